@@ -84,7 +84,7 @@ typedef struct {
 } REQ;
 
 /* Global variables */
-extern thread_master_t *master;
+extern THREAD_LOCAL thread_master_t *master;
 extern REQ *req;		/* Cmd line arguments */
 extern int exit_code;
 
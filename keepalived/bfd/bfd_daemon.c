@@ -23,6 +23,8 @@
 #include "config.h"
 
 #include <unistd.h>
+#include <errno.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/prctl.h>
@@ -48,6 +50,7 @@
 #include "utils.h"
 #include "scheduler.h"
 #include "process.h"
+#include "memory.h"
 #include "utils.h"
 
 /* Global variables */
@@ -92,6 +95,10 @@ stop_bfd(int status)
 	else
 		log_message(LOG_INFO, "Stopped");
 
+#ifdef _WITH_ASYNC_LOG_
+	set_async_log(0);
+#endif
+
 #ifdef ENABLE_LOG_TO_FILE
 	if (log_file_name)
 		close_log_file();
@@ -158,6 +165,13 @@ start_bfd(__attribute__((unused)) data_t *old_global_data)
 	/* If we are just testing the configuration, then we terminate now */
 	if (__test_bit(CONFIG_TEST_BIT, &debug))
 		return;
+
+#ifdef _WITH_ASYNC_LOG_
+	/* Start, resize or stop logging from the drain thread */
+	set_async_log(global_data->async_log);
+#endif
+
+	set_log_rate_limits(global_data->log_rate_limit);
 	bfd_complete_init();
 
 	/* Post initializations */
@@ -170,6 +184,12 @@ start_bfd(__attribute__((unused)) data_t *old_global_data)
 
 	thread_add_event(master, bfd_dispatcher_init, bfd_data, 0);
 
+	/* Select the timer queue implementation */
+	thread_set_timer_wheel(master, global_data->timer_wheel);
+
+	/* Assign the ready queue classes */
+	set_bfd_thread_priorities();
+
 	/* Set the process priority and non swappable if configured */
 // TODO - measure max stack usage
 	set_process_priorities(
@@ -197,6 +217,41 @@ sigreload_bfd(__attribute__ ((unused)) void *v,
 	thread_add_event(master, reload_bfd_thread, NULL, 0);
 }
 
+#if defined _WITH_THREAD_STATS_ || defined _WITH_ALLOC_PROFILE_
+static const char *bfd_stats_file = "/tmp/keepalived_bfd.stats";
+
+static int
+print_bfd_stats(__attribute__((unused)) thread_t * thread)
+{
+	FILE *file = fopen_safe(bfd_stats_file, "w");
+
+	if (!file) {
+		log_message(LOG_INFO, "Can't open %s (%d: %s)",
+			bfd_stats_file, errno, strerror(errno));
+		return 0;
+	}
+
+#ifdef _WITH_THREAD_STATS_
+	dump_thread_stats(master, file);
+#endif
+#ifdef _WITH_ALLOC_PROFILE_
+	alloc_profile_dump(file);
+#endif
+	fclose(file);
+
+	return 0;
+}
+
+static void
+sigusr2_bfd(__attribute__ ((unused)) void *v,
+	   __attribute__ ((unused)) int sig)
+{
+	log_message(LOG_INFO, "Printing BFD stats for process(%d) on signal",
+		    getpid());
+	thread_add_event(master, print_bfd_stats, NULL, 0);
+}
+#endif
+
 /* Terminate handler */
 static void
 sigend_bfd(__attribute__ ((unused)) void *v,
@@ -211,6 +266,12 @@ static void
 bfd_signal_init(void)
 {
 	signal_set(SIGHUP, sigreload_bfd, NULL);
+#if defined _WITH_THREAD_STATS_ || defined _WITH_ALLOC_PROFILE_
+	signal_set(SIGUSR2, sigusr2_bfd, NULL);
+#endif
+#ifdef _WITH_ALLOC_PROFILE_
+	signal_set(SIGALLOC, alloc_profile_signal, NULL);
+#endif
 	signal_set(SIGINT, sigend_bfd, NULL);
 	signal_set(SIGTERM, sigend_bfd, NULL);
 	signal_ignore(SIGPIPE);
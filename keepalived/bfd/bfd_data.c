@@ -68,9 +68,17 @@ alloc_bfd(char *name)
 	bfd->sands_exp = -1;
 	bfd->sands_rst = -1;
 
+	name_table_add(bfd_data->bfd_index, bfd->iname, bfd);
 	list_add(bfd_data->bfd, bfd);
 }
 
+void
+remove_bfd(bfd_t *bfd)
+{
+	name_table_remove(bfd_data->bfd_index, bfd->iname, bfd);
+	list_del(bfd_data->bfd, bfd);
+}
+
 static void
 free_bfd(void *data)
 {
@@ -122,23 +130,11 @@ dump_bfd(FILE *fp, void *data)
 static bfd_t *
 find_bfd_by_name2(const char *name, const bfd_data_t *data)
 {
-	element e;
-	bfd_t *bfd;
-
 	assert(name);
 	assert(data);
-	assert(data->bfd);
+	assert(data->bfd_index);
 
-	if (LIST_ISEMPTY(data->bfd))
-		return NULL;
-
-	for (e = LIST_HEAD(data->bfd); e; ELEMENT_NEXT(e)) {
-		bfd = ELEMENT_DATA(e);
-		if (!strcmp(name, bfd->iname))
-			return bfd;
-	}
-
-	return NULL;
+	return name_table_lookup(data->bfd_index, name);
 }
 
 bfd_t *
@@ -165,6 +161,7 @@ alloc_bfd_data(void)
 
 	data = (bfd_data_t *) MALLOC(sizeof (bfd_data_t));
 	data->bfd = alloc_list(free_bfd, dump_bfd);
+	data->bfd_index = alloc_name_table();
 
 	/* Initialize internal variables */
 	data->thread_in = NULL;
@@ -179,6 +176,7 @@ free_bfd_data(bfd_data_t * data)
 	assert(data);
 
 	free_list(&data->bfd);
+	free_name_table(&data->bfd_index);
 	FREE(data);
 }
 
@@ -113,7 +113,7 @@ bfd_nbrip_handler(vector_t *strvec)
 			    "Configuration error: BFD instance %s has"
 			    " malformed %s address %s, ignoring instance",
 			    bfd->iname, neighbor_str, FMT_STR_VSLOT(strvec, 1));
-		list_del(bfd_data->bfd, bfd);
+		remove_bfd(bfd);
 		skip_block(false);
 		return;
 	} else if (find_bfd_by_addr(&nbr_addr)) {
@@ -121,7 +121,7 @@ bfd_nbrip_handler(vector_t *strvec)
 			    "Configuration error: BFD instance %s has"
 			    " duplicate %s address %s, ignoring instance",
 			    bfd->iname, neighbor_str, FMT_STR_VSLOT(strvec, 1));
-		list_del(bfd_data->bfd, bfd);
+		remove_bfd(bfd);
 		skip_block(false);
 		return;
 	} else
@@ -308,8 +308,13 @@ bfd_maxhops_handler(vector_t *strvec)
 static void
 bfd_vrrp_end_handler(void)
 {
-	if (specified_event_processes && !__test_bit(DAEMON_VRRP, &specified_event_processes))
-		list_del(vrrp_data->vrrp_track_bfds, LIST_TAIL_DATA(vrrp_data->vrrp_track_bfds));
+	vrrp_tracked_bfd_t *tbfd;
+
+	if (specified_event_processes && !__test_bit(DAEMON_VRRP, &specified_event_processes)) {
+		tbfd = LIST_TAIL_DATA(vrrp_data->vrrp_track_bfds);
+		name_table_remove(vrrp_data->vrrp_track_bfd_index, tbfd->bname, tbfd);
+		list_del(vrrp_data->vrrp_track_bfds, tbfd);
+	}
 }
 #endif
 
@@ -317,8 +322,13 @@ bfd_vrrp_end_handler(void)
 static void
 bfd_checker_end_handler(void)
 {
-	if (specified_event_processes && !__test_bit(DAEMON_CHECKERS, &specified_event_processes))
-		list_del(check_data->track_bfds, LIST_TAIL_DATA(check_data->track_bfds));
+	checker_tracked_bfd_t *tbfd;
+
+	if (specified_event_processes && !__test_bit(DAEMON_CHECKERS, &specified_event_processes)) {
+		tbfd = LIST_TAIL_DATA(check_data->track_bfds);
+		name_table_remove(check_data->track_bfd_index, tbfd->bname, tbfd);
+		list_del(check_data->track_bfds, tbfd);
+	}
 }
 #endif
 
@@ -334,7 +344,7 @@ bfd_end_handler(void)
 			    "Configuration error: BFD instance %s has"
 			    " no %s address set, disabling instance",
 			    bfd->iname, neighbor_str);
-		list_del(bfd_data->bfd, bfd);
+		remove_bfd(bfd);
 		return;
 	}
 
@@ -346,7 +356,7 @@ bfd_end_handler(void)
 			    " are not of the same family, disabling instance",
 			    bfd->iname, inet_sockaddrtos(&bfd->src_addr),
 			    neighbor_str, inet_sockaddrtos(&bfd->nbr_addr));
-		list_del(bfd_data->bfd, bfd);
+		remove_bfd(bfd);
 		return;
 	}
 
@@ -382,25 +392,23 @@ bfd_vrrp_handler(vector_t *strvec)
 {
 	vrrp_tracked_bfd_t *tbfd;
 	char *name;
-	element e;
 
 	if (!strvec)
 		return;
 
 	name = vector_slot(strvec, 1);
 
-	LIST_FOREACH(vrrp_data->vrrp_track_bfds, tbfd, e) {
-		if (!strcmp(name, tbfd->bname)) {
-			report_config_error(CONFIG_GENERAL_ERROR, "BFD %s already specified", name);
-			skip_block(true);
-			return;
-		}
+	if (find_vrrp_tracked_bfd_by_name(name)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "BFD %s already specified", name);
+		skip_block(true);
+		return;
 	}
 
 	PMALLOC(tbfd);
 	strcpy(tbfd->bname, name);
 	tbfd->weight = 0;
 	tbfd->bfd_up = false;
+	name_table_add(vrrp_data->vrrp_track_bfd_index, tbfd->bname, tbfd);
 	list_add(vrrp_data->vrrp_track_bfds, tbfd);
 }
 #endif
@@ -440,19 +448,16 @@ bfd_checker_handler(vector_t *strvec)
 {
 	checker_tracked_bfd_t *tbfd;
 	char *name;
-	element e;
 
 	if (!strvec)
 		return;
 
 	name = vector_slot(strvec, 1);
 
-	LIST_FOREACH(check_data->track_bfds, tbfd, e) {
-		if (!strcmp(name, tbfd->bname)) {
-			report_config_error(CONFIG_GENERAL_ERROR, "BFD %s already specified", name);
-			skip_block(true);
-			return;
-		}
+	if (find_checker_tracked_bfd_by_name(name)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "BFD %s already specified", name);
+		skip_block(true);
+		return;
 	}
 
 	PMALLOC(tbfd);
@@ -460,6 +465,7 @@ bfd_checker_handler(vector_t *strvec)
 	strcpy(tbfd->bname, name);
 //	tbfd->weight = 0;
 
+	name_table_add(check_data->track_bfd_index, tbfd->bname, tbfd);
 	list_add(check_data->track_bfds, tbfd);
 }
 #endif
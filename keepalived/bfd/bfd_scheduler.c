@@ -875,30 +875,22 @@ bfd_receive_packet(bfdpkt_t *pkt, int fd, char *buf, ssize_t bufsz)
 static int
 bfd_receiver_thread(thread_t *thread)
 {
-	bfd_data_t *data;
 	bfdpkt_t pkt;
 	int fd;
 
 	assert(thread);
-
-	data = THREAD_ARG(thread);
-	assert(data);
+	assert(THREAD_ARG(thread));
 
 	fd = thread->u.fd;
 	assert(fd >= 0);
 
-	data->thread_in = NULL;
-
-	/* Ignore THREAD_READ_TIMEOUT */
+	/* Ignore THREAD_READ_TIMEOUT. The thread is persistent, so
+	 * stays registered for the next packet. */
 	if (thread->type == THREAD_READY_FD) {
 		if (!bfd_receive_packet(&pkt, fd, bfd_buffer, BFD_BUFFER_SIZE))
 			bfd_handle_packet(&pkt);
 	}
 
-	data->thread_in =
-	    thread_add_read(thread->master, bfd_receiver_thread, data,
-			    fd, TIMER_NEVER);
-
 	return 0;
 }
 
@@ -1032,8 +1024,8 @@ bfd_register_workers(bfd_data_t *data)
 	assert(!data->thread_in);
 
 	/* Set timeout to not expire */
-	data->thread_in = thread_add_read(master, bfd_receiver_thread,
-					  data, data->fd_in, TIMER_NEVER);
+	data->thread_in = thread_add_persistent_read(master, bfd_receiver_thread,
+						     data, data->fd_in, TIMER_NEVER, false);
 
 	/* Resume or schedule threads */
 	for (e = LIST_HEAD(data->bfd); e; ELEMENT_NEXT(e)) {
@@ -1137,6 +1129,14 @@ bfd_dispatcher_init(thread_t *thread)
 	return 0;
 }
 
+/* Session timers and packets are time critical */
+void
+set_bfd_thread_priorities(void)
+{
+	thread_set_func_priority(master, bfd_sender_thread, THREAD_PRIO_CRITICAL);
+	thread_set_func_priority(master, bfd_expire_thread, THREAD_PRIO_CRITICAL);
+	thread_set_func_priority(master, bfd_receiver_thread, THREAD_PRIO_CRITICAL);
+}
 
 #ifdef THREAD_DUMP
 void
@@ -48,23 +48,26 @@
 #include "bfd_event.h"
 #include "bfd_daemon.h"
 #endif
+#ifdef _WITH_CHECKER_THREADS_
+#include "check_workers.h"
+#endif
 
 /* Global vars */
-list checkers_queue;
+list_head_t checkers_queue = LIST_HEAD_INIT(checkers_queue);
 
 /* free checker data */
-static void
-free_checker(void *data)
+void
+free_checker(checker_t *checker)
 {
-	checker_t *checker = data;
+	list_head_del(&checker->e_list);
+	list_head_del(&checker->rs_list);
 	(*checker->free_func) (checker);
 }
 
 /* dump checker data */
 static void
-dump_checker(FILE *fp, void *data)
+dump_checker(FILE *fp, checker_t *checker)
 {
-	checker_t *checker = data;
 	char *vs_ret;
 	char *vs_sav;
 
@@ -124,9 +127,12 @@ queue_checker(void (*free_func) (void *), void (*dump_func) (FILE *, void *)
 	      , conn_opts_t *co)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	checker_t *checker = (checker_t *) MALLOC(sizeof (checker_t));
 
+	INIT_LIST_HEAD(&checker->e_list);
+	INIT_LIST_HEAD(&checker->rs_list);
+
 	/* Set default dst = RS, timeout = 5 */
 	if (co) {
 		co->dst = rs->addr;
@@ -153,7 +159,8 @@ queue_checker(void (*free_func) (void *), void (*dump_func) (FILE *, void *)
 	checker->default_retry = 1 ;
 
 	/* queue the checker */
-	list_add(checkers_queue, checker);
+	list_add_tail(&checker->e_list, &checkers_queue);
+	list_add_tail(&checker->rs_list, &rs->checkers);
 
 	return checker;
 }
@@ -161,12 +168,12 @@ queue_checker(void (*free_func) (void *), void (*dump_func) (FILE *, void *)
 void
 dequeue_new_checker(void)
 {
-	checker_t *checker = ELEMENT_DATA(checkers_queue->tail);
+	checker_t *checker = CHECKER_GET_CURRENT();
 
 	if (!checker->is_up)
 		set_checker_state(checker, true);
 
-	free_list_element(checkers_queue, checkers_queue->tail);
+	free_checker(checker);
 }
 
 bool
@@ -418,9 +425,12 @@ install_checker_common_keywords(bool connection_keywords)
 void
 dump_checkers_queue(FILE *fp)
 {
-	if (!LIST_ISEMPTY(checkers_queue)) {
+	checker_t *checker;
+
+	if (!list_empty(&checkers_queue)) {
 		conf_write(fp, "------< Health checkers >------");
-		dump_list(fp, checkers_queue);
+		list_for_each_entry(checker, &checkers_queue, e_list)
+			dump_checker(fp, checker);
 	}
 }
 
@@ -428,39 +438,38 @@ dump_checkers_queue(FILE *fp)
 void
 init_checkers_queue(void)
 {
-	checkers_queue = alloc_list(free_checker, dump_checker);
+	INIT_LIST_HEAD(&checkers_queue);
 }
 
 /* release the checkers for a virtual server */
 void
 free_vs_checkers(virtual_server_t *vs)
 {
-	element e;
-	element next;
-	checker_t *checker;
-
-	if (LIST_ISEMPTY(checkers_queue))
-		return;
-
-	for (e = LIST_HEAD(checkers_queue); e; e = next) {
-		next = e->next;
+	checker_t *checker, *checker_tmp;
 
-		checker = ELEMENT_DATA(e);
+	list_for_each_entry_safe(checker, checker_tmp, &checkers_queue, e_list) {
 		if (checker->vs != vs)
 			continue;
 
-		free_list_element(checkers_queue, e);
+		free_checker(checker);
 	}
 }
 
+/* release a list of checkers */
+void
+free_checker_list(list_head_t *l)
+{
+	checker_t *checker, *checker_tmp;
+
+	list_for_each_entry_safe(checker, checker_tmp, l, e_list)
+		free_checker(checker);
+}
+
 /* release the checkers_queue */
 void
 free_checkers_queue(void)
 {
-	if (!checkers_queue)
-		return;
-
-	free_list(&checkers_queue);
+	free_checker_list(&checkers_queue);
 }
 
 /* register checkers to the global I/O scheduler */
@@ -468,10 +477,9 @@ void
 register_checkers_thread(void)
 {
 	checker_t *checker;
-	element e;
 	unsigned long warmup;
 
-	LIST_FOREACH(checkers_queue, checker, e) {
+	list_for_each_entry(checker, &checkers_queue, e_list) {
 		if (checker->launch)
 		{
 			if (checker->vs->ha_suspend && !checker->vs->ha_suspend_addr_count)
@@ -480,6 +488,14 @@ register_checkers_thread(void)
 			log_message(LOG_INFO, "%sctivating healthchecker for service %s for VS %s"
 					    , checker->enabled ? "A" : "Dea", FMT_RS(checker->rs, checker->vs), FMT_VS(checker->vs));
 
+			thread_set_func_slack(master, checker->launch);
+
+#ifdef _WITH_CHECKER_THREADS_
+			/* The worker thread schedules it when it starts */
+			if (checker_worker_assign(checker))
+				continue;
+#endif
+
 			/* wait for a random timeout to begin checker thread.
 			   It helps avoiding multiple simultaneous checks to
 			   the same RS.
@@ -591,7 +607,7 @@ update_checker_activity(sa_family_t family, void *address, bool enable)
 {
 	checker_t *checker;
 	virtual_server_t *vs;
-	element e, e1;
+	element e;
 	char addr_str[INET6_ADDRSTRLEN];
 	bool address_logged = false;
 
@@ -605,7 +621,7 @@ update_checker_activity(sa_family_t family, void *address, bool enable)
 	if (!using_ha_suspend)
 		return;
 
-	if (LIST_ISEMPTY(checkers_queue))
+	if (list_empty(&checkers_queue))
 		return;
 
 	/* Check if any of the virtual servers are using this address, and have ha_suspend */
@@ -637,7 +653,7 @@ update_checker_activity(sa_family_t family, void *address, bool enable)
 			vs->ha_suspend_addr_count--;
 
 		/* Processing Healthcheckers queue for this vs */
-		LIST_FOREACH(checkers_queue, checker, e1) {
+		list_for_each_entry(checker, &checkers_queue, e_list) {
 			if (checker->vs != vs)
 				continue;
 
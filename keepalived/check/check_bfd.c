@@ -94,17 +94,9 @@ bfd_check_compare(void *a, void *b)
 }
 
 checker_tracked_bfd_t *
-find_checker_tracked_bfd_by_name(char *name)
+find_checker_tracked_bfd_by_name(const char *name)
 {
-	element e;
-	checker_tracked_bfd_t *bfd;
-
-	LIST_FOREACH(check_data->track_bfds, bfd, e) {
-		if (!strcmp(bfd->bname, name))
-			return bfd;
-	}
-
-	return NULL;
+	return name_table_lookup(check_data->track_bfd_index, name);
 }
 
 static void
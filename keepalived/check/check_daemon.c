@@ -33,12 +33,13 @@
 #include <sys/resource.h>
 
 #ifdef THREAD_DUMP
+#ifdef _WITH_SNMP_
 #include "snmp.h"
+#endif
 #include "scheduler.h"
 #include "smtp.h"
 #include "check_dns.h"
 #include "check_http.h"
-#include "check_misc.h"
 #include "check_smtp.h"
 #include "check_tcp.h"
 #endif
@@ -47,6 +48,11 @@
 #include "ipwrapper.h"
 #include "check_ssl.h"
 #include "check_api.h"
+#include "check_misc.h"
+#ifdef _WITH_CHECKER_THREADS_
+#include "check_workers.h"
+#endif
+#include "notify.h"
 #include "global_data.h"
 #include "pidfile.h"
 #include "signals.h"
@@ -73,6 +79,9 @@ bool using_ha_suspend;
 /* local variables */
 static char *check_syslog_ident;
 static bool two_phase_terminate;
+static mem_arena_t *check_arena;	/* the current configuration generation */
+static timeval_t start_time;		/* of startup, or of the current reload */
+static unsigned long parse_time;
 
 static int
 lvs_notify_fifo_script_exit(__attribute__((unused)) thread_t *thread)
@@ -122,6 +131,7 @@ checker_terminate_phase2(void)
 		free_global_data(global_data);
 	if (check_data)
 		free_check_data(check_data);
+	mem_arena_release(check_arena);
 	free_parent_mallocs_exit();
 
 	/*
@@ -135,6 +145,10 @@ checker_terminate_phase2(void)
 	else
 		log_message(LOG_INFO, "Stopped");
 
+#ifdef _WITH_ASYNC_LOG_
+	set_async_log(0);
+#endif
+
 #ifdef ENABLE_LOG_TO_FILE
 	if (log_file_name)
 		close_log_file();
@@ -179,6 +193,10 @@ checker_shutdown_backstop_thread(thread_t *thread)
 static void
 checker_terminate_phase1(bool schedule_next_thread)
 {
+#ifdef _WITH_CHECKER_THREADS_
+	stop_checker_workers();
+#endif
+
 	if (using_ha_suspend || __test_bit(LOG_ADDRESS_CHANGES, &debug))
 		kernel_netlink_close();
 
@@ -231,10 +249,24 @@ stop_check(int status)
 	exit(status);
 }
 
+/* Logged with -D, for scale benchmarks such as test/scale-bench.sh */
+static void
+log_check_timing(void)
+{
+	log_message(LOG_INFO, "Checker %s took %lu us: parse %lu us",
+		    reload ? "reload" : "startup", timer_elapsed(start_time), parse_time);
+}
+
 /* Daemon init sequence */
 static void
-start_check(list old_checkers_queue, data_t *old_global_data)
+start_check(data_t *old_global_data)
 {
+	unsigned num_checkers;
+	timeval_t parse_start;
+
+	if (!reload)
+		start_time = timer_now();
+
 	init_checkers_queue();
 
 	/* Parse configuration file */
@@ -246,7 +278,14 @@ start_check(list old_checkers_queue, data_t *old_global_data)
 		return;
 	}
 
+	parse_start = timer_now();
+	check_arena = mem_arena_new();
+	mem_arena_set(check_arena);
 	init_data(conf_file, check_init_keywords);
+	mem_arena_set(NULL);
+	parse_time = timer_elapsed(parse_start);
+	if (__test_bit(LOG_DETAIL_BIT, &debug))
+		mem_arena_log_stats(check_arena, "Parsed");
 
 	if (reload)
 		init_global_data(global_data, old_global_data);
@@ -272,6 +311,15 @@ start_check(list old_checkers_queue, data_t *old_global_data)
 	if (__test_bit(CONFIG_TEST_BIT, &debug))
 		return;
 
+#ifdef _WITH_ASYNC_LOG_
+	/* Start, resize or stop logging from the drain thread */
+	set_async_log(global_data->async_log);
+#endif
+
+	set_log_rate_limits(global_data->log_rate_limit);
+	add_script_spawner_read_thread(master);
+	set_script_vfork(global_data->script_vfork);
+
 	/* Initialize sub-system if any virtual servers are configured */
 	if ((!LIST_ISEMPTY(check_data->vs) || (reload && !LIST_ISEMPTY(old_check_data->vs))) &&
 	    ipvs_start() != IPVS_SUCCESS) {
@@ -307,7 +355,7 @@ start_check(list old_checkers_queue, data_t *old_global_data)
 
 	/* Processing differential configuration parsing */
 	if (reload)
-		clear_diff_services(old_checkers_queue);
+		clear_diff_services();
 
 	/* We can send SMTP messages from here so set the time */
 	set_time_now();
@@ -322,9 +370,31 @@ start_check(list old_checkers_queue, data_t *old_global_data)
 		dump_check_data(NULL, check_data);
 	}
 
+	/* Size the scheduler slabs: each checker has a timer and, while
+	 * connecting, an fd thread with its event */
+	num_checkers = list_count(&checkers_queue);
+	thread_master_prealloc(master,
+			       2 * num_checkers + THREAD_SLAB_CHUNK,
+			       num_checkers + THREAD_SLAB_CHUNK);
+
+#ifdef _WITH_CHECKER_THREADS_
+	/* Checkers assigned to a worker thread are not added to master */
+	init_checker_workers(global_data->checker_threads);
+#endif
+
+	/* Checker timers may be delayed to expire together */
+	thread_set_timer_slack(master, global_data->timer_slack * (TIMER_HZ / 1000));
+
 	/* Register checkers thread */
 	register_checkers_thread();
 
+	/* Select the timer queue implementation */
+	thread_set_timer_wheel(master, global_data->timer_wheel);
+
+	/* Script reaping can wait behind the checkers */
+	set_check_misc_thread_priorities();
+	thread_set_func_priority(master, child_killed_thread, THREAD_PRIO_BULK);
+
 	/* Set the process priority and non swappable if configured */
 	set_process_priorities(
 #ifdef _HAVE_SCHED_RT_
@@ -334,12 +404,20 @@ start_check(list old_checkers_queue, data_t *old_global_data)
 #endif
 #endif
 			       global_data->checker_process_priority, global_data->checker_no_swap ? 4096 : 0);
+
+#ifdef _WITH_CHECKER_THREADS_
+	/* Started last so that the threads inherit the process priorities */
+	start_checker_workers();
+#endif
+
+	if (!reload && __test_bit(LOG_DETAIL_BIT, &debug))
+		log_check_timing();
 }
 
 void
 check_validate_config(void)
 {
-	start_check(NULL, NULL);
+	start_check(NULL);
 }
 
 #ifndef _DEBUG_
@@ -347,7 +425,10 @@ check_validate_config(void)
 static int
 reload_check_thread(__attribute__((unused)) thread_t * thread)
 {
-	list old_checkers_queue;
+	LH_LIST_HEAD(old_checkers_queue);
+	mem_arena_t *old_arena;
+
+	start_time = timer_now();
 
 	log_message(LOG_INFO, "Reloading");
 
@@ -365,14 +446,17 @@ reload_check_thread(__attribute__((unused)) thread_t * thread)
 	/* Remove the notify fifo - we don't know if it will be the same after a reload */
 	notify_fifo_close(&global_data->notify_fifo, &global_data->lvs_notify_fifo);
 
+#ifdef _WITH_CHECKER_THREADS_
+	stop_checker_workers();
+#endif
+
 	/* Destroy master thread */
 	checker_dispatcher_release();
 	thread_cleanup_master(master);
 	thread_add_base_threads(master);
 
 	/* Save previous checker data */
-	old_checkers_queue = checkers_queue;
-	checkers_queue = NULL;
+	list_splice_init(&checkers_queue, &old_checkers_queue);
 
 	free_ssl();
 	ipvs_stop();
@@ -382,14 +466,23 @@ reload_check_thread(__attribute__((unused)) thread_t * thread)
 	check_data = NULL;
 	old_global_data = global_data;
 	global_data = NULL;
+	old_arena = check_arena;
 
 	/* Reload the conf */
-	start_check(old_checkers_queue, old_global_data);
+	start_check(old_global_data);
 
 	/* free backup data */
 	free_check_data(old_check_data);
 	free_global_data(old_global_data);
-	free_list(&old_checkers_queue);
+	free_checker_list(&old_checkers_queue);
+
+	/* Nothing refers to the old configuration now */
+	if (__test_bit(LOG_DETAIL_BIT, &debug))
+		mem_arena_log_stats(old_arena, "Releasing");
+	mem_arena_release(old_arena);
+
+	if (__test_bit(LOG_DETAIL_BIT, &debug))
+		log_check_timing();
 	UNSET_RELOAD;
 
 	return 0;
@@ -401,6 +494,40 @@ sigreload_check(__attribute__((unused)) void *v, __attribute__((unused)) int sig
 	thread_add_event(master, reload_check_thread, NULL, 0);
 }
 
+#if defined _WITH_THREAD_STATS_ || defined _WITH_ALLOC_PROFILE_
+static const char *check_stats_file = "/tmp/keepalived_check.stats";
+
+static int
+print_check_stats(__attribute__((unused)) thread_t * thread)
+{
+	FILE *file = fopen_safe(check_stats_file, "w");
+
+	if (!file) {
+		log_message(LOG_INFO, "Can't open %s (%d: %s)",
+			check_stats_file, errno, strerror(errno));
+		return 0;
+	}
+
+#ifdef _WITH_THREAD_STATS_
+	dump_thread_stats(master, file);
+#endif
+#ifdef _WITH_ALLOC_PROFILE_
+	alloc_profile_dump(file);
+#endif
+	fclose(file);
+
+	return 0;
+}
+
+static void
+sigusr2_check(__attribute__((unused)) void *v, __attribute__((unused)) int sig)
+{
+	log_message(LOG_INFO, "Printing checker stats for process(%d) on signal",
+		    getpid());
+	thread_add_event(master, print_check_stats, NULL, 0);
+}
+#endif
+
 /* Terminate handler */
 static void
 sigend_check(__attribute__((unused)) void *v, __attribute__((unused)) int sig)
@@ -414,6 +541,12 @@ static void
 check_signal_init(void)
 {
 	signal_set(SIGHUP, sigreload_check, NULL);
+#if defined _WITH_THREAD_STATS_ || defined _WITH_ALLOC_PROFILE_
+	signal_set(SIGUSR2, sigusr2_check, NULL);
+#endif
+#ifdef _WITH_ALLOC_PROFILE_
+	signal_set(SIGALLOC, alloc_profile_signal, NULL);
+#endif
 	signal_set(SIGINT, sigend_check, NULL);
 	signal_set(SIGTERM, sigend_check, NULL);
 	signal_ignore(SIGPIPE);
@@ -457,6 +590,9 @@ register_check_thread_addresses(void)
 	register_check_smtp_addresses();
 	register_check_ssl_addresses();
 	register_check_tcp_addresses();
+#ifdef _WITH_CHECKER_THREADS_
+	register_check_workers_addresses();
+#endif
 #ifdef _WITH_BFD_
 	register_check_bfd_addresses();
 #endif
@@ -568,6 +704,11 @@ start_check_child(void)
 
 	/* Create the new master thread */
 	thread_destroy_master(master);	/* This destroys any residual settings from the parent */
+
+	/* Start the script spawner while we are small and have few fds open */
+	if (global_data->script_spawner)
+		start_script_spawner();
+
 	master = thread_make_master();
 #endif
 
@@ -582,7 +723,7 @@ start_check_child(void)
 #endif
 
 	/* Start Healthcheck daemon */
-	start_check(NULL, NULL);
+	start_check(NULL);
 
 #ifdef _DEBUG_
 	return 0;
@@ -151,6 +151,7 @@ alloc_vsg(char *gname)
 	new->addr_range = alloc_list(free_vsg_entry, dump_vsg_entry);
 	new->vfwmark = alloc_list(free_vsg_entry, dump_vsg_entry);
 
+	name_table_add(check_data->vs_group_index, new->gname, new);
 	list_add(check_data->vs_group, new);
 }
 void
@@ -240,6 +241,170 @@ alloc_vsg_entry(vector_t *strvec)
 	}
 }
 
+/* Real server facility functions */
+void
+free_rs(real_server_t *rs)
+{
+	checker_t *checker, *checker_tmp;
+
+	/* Any checkers still queued for the real server go with it */
+	list_for_each_entry_safe(checker, checker_tmp, &rs->checkers, rs_list)
+		free_checker(checker);
+
+	list_head_del(&rs->e_list);
+	free_notify_script(&rs->notify_up);
+	free_notify_script(&rs->notify_down);
+#ifdef _WITH_BFD_
+	free_list(&rs->tracked_bfds);
+#endif
+	FREE_PTR(rs->virtualhost);
+	FREE(rs);
+}
+
+void
+free_rs_list(list_head_t *l)
+{
+	real_server_t *rs, *rs_tmp;
+
+	list_for_each_entry_safe(rs, rs_tmp, l, e_list)
+		free_rs(rs);
+}
+
+/* Real server index, keyed on address and port */
+static unsigned
+rs_hash_key(sa_family_t af, const void *addr, uint16_t port, unsigned bits)
+{
+	const uint32_t *a = addr;
+	uint32_t h = port;
+
+	if (af == AF_INET6)
+		h ^= a[0] ^ a[1] ^ a[2] ^ a[3];
+	else
+		h ^= a[0];
+
+	return (h * 0x9e3779b1U) >> (32 - bits);
+}
+
+static hlist_head_t *
+rs_hash_rs_bucket(virtual_server_t *vs, real_server_t *rs)
+{
+	if (rs->addr.ss_family == AF_INET6)
+		return rs_hash_bucket(vs, AF_INET6, &((struct sockaddr_in6 *)&rs->addr)->sin6_addr, ((struct sockaddr_in6 *)&rs->addr)->sin6_port);
+
+	return rs_hash_bucket(vs, AF_INET, &((struct sockaddr_in *)&rs->addr)->sin_addr, ((struct sockaddr_in *)&rs->addr)->sin_port);
+}
+
+/* addr is an in_addr or in6_addr, port is in network byte order */
+hlist_head_t *
+rs_hash_bucket(virtual_server_t *vs, sa_family_t af, const void *addr, uint16_t port)
+{
+	static hlist_head_t empty = HLIST_HEAD_INIT;
+
+	if (!vs->rs_hash)
+		return &empty;
+
+	return &vs->rs_hash[rs_hash_key(af, addr, port, vs->rs_hash_bits)];
+}
+
+/* Entries sharing a bucket are kept in the order they were added, so
+ * that lookups find the first matching real server in vs->rs. */
+static void
+rs_hash_insert(virtual_server_t *vs, real_server_t *rs)
+{
+	hlist_head_t *head = rs_hash_rs_bucket(vs, rs);
+	hlist_node_t *pos;
+
+	if (!head->first) {
+		hlist_add_head(&rs->e_hash, head);
+		return;
+	}
+
+	for (pos = head->first; pos->next; pos = pos->next);
+	hlist_add_after(pos, &rs->e_hash);
+}
+
+/* Must be called before rs is added to vs->rs */
+void
+rs_hash_add(virtual_server_t *vs, real_server_t *rs)
+{
+	real_server_t *r;
+
+	if (!vs->rs_hash || vs->rs_hash_count >= (1U << vs->rs_hash_bits)) {
+		/* Double the index and rehash in list order */
+		vs->rs_hash_bits = vs->rs_hash ? vs->rs_hash_bits + 1 : RS_HASH_MIN_BITS;
+		FREE_PTR(vs->rs_hash);
+		vs->rs_hash = MALLOC(sizeof(hlist_head_t) << vs->rs_hash_bits);
+		list_for_each_entry(r, &vs->rs, e_list) {
+			if (!hlist_unhashed(&r->e_hash))
+				rs_hash_insert(vs, r);
+		}
+	}
+
+	rs_hash_insert(vs, rs);
+	vs->rs_hash_count++;
+}
+
+void
+rs_hash_del(virtual_server_t *vs, real_server_t *rs)
+{
+	if (hlist_unhashed(&rs->e_hash))
+		return;
+
+	hlist_del_init(&rs->e_hash);
+	vs->rs_hash_count--;
+}
+
+static void
+dump_rs(FILE *fp, real_server_t *rs)
+{
+
+	conf_write(fp, "   ------< Real server >------");
+	conf_write(fp, "   RIP = %s, RPORT = %d, WEIGHT = %d"
+			    , inet_sockaddrtos(&rs->addr)
+			    , ntohs(inet_sockaddrport(&rs->addr))
+			    , rs->weight);
+	switch (rs->forwarding_method) {
+	case IP_VS_CONN_F_MASQ:
+		conf_write(fp, "   Forwarding method = NAT");
+		break;
+	case IP_VS_CONN_F_DROUTE:
+		conf_write(fp, "   Forwarding method = DR");
+		break;
+	case IP_VS_CONN_F_TUNNEL:
+		conf_write(fp, "   Forwarding method = TUN");
+		break;
+	}
+
+	conf_write(fp, "   Alpha is %s", rs->alpha ? "ON" : "OFF");
+	conf_write(fp, "   Delay loop = %lu" , rs->delay_loop / TIMER_HZ);
+	if (rs->retry != UINT_MAX)
+		conf_write(fp, "   Retry count = %u" , rs->retry);
+	if (rs->delay_before_retry != ULONG_MAX)
+		conf_write(fp, "   Retry delay = %lu" , rs->delay_before_retry / TIMER_HZ);
+	if (rs->warmup != ULONG_MAX)
+		conf_write(fp, "   Warmup = %lu", rs->warmup / TIMER_HZ);
+	conf_write(fp, "   Inhibit on failure is %s", rs->inhibit ? "ON" : "OFF");
+
+	if (rs->notify_up)
+		conf_write(fp, "     RS up notify script = %s, uid:gid %d:%d",
+				cmd_str(rs->notify_up), rs->notify_up->uid, rs->notify_up->gid);
+	if (rs->notify_down)
+		conf_write(fp, "     RS down notify script = %s, uid:gid %d:%d",
+				cmd_str(rs->notify_down), rs->notify_down->uid, rs->notify_down->gid);
+	if (rs->virtualhost)
+		conf_write(fp, "    VirtualHost = %s", rs->virtualhost);
+	conf_write(fp, "   Using smtp notification = %s", rs->smtp_alert ? "yes" : "no");
+}
+
+static void
+dump_rs_list(FILE *fp, list_head_t *l)
+{
+	real_server_t *rs;
+
+	list_for_each_entry(rs, l, e_list)
+		dump_rs(fp, rs);
+}
+
 /* Virtual server facility functions */
 static void
 free_vs(void *data)
@@ -247,8 +412,10 @@ free_vs(void *data)
 	virtual_server_t *vs = data;
 	FREE_PTR(vs->vsgname);
 	FREE_PTR(vs->virtualhost);
+	free_config_block(&vs->conf_block);
 	FREE_PTR(vs->s_svr);
-	free_list(&vs->rs);
+	free_rs_list(&vs->rs);
+	FREE_PTR(vs->rs_hash);
 	free_notify_script(&vs->notify_quorum_up);
 	free_notify_script(&vs->notify_quorum_down);
 	FREE(vs);
@@ -363,7 +530,7 @@ dump_vs(FILE *fp, void *data)
 			break;
 		}
 	}
-	dump_list(fp, vs->rs);
+	dump_rs_list(fp, &vs->rs);
 }
 
 void
@@ -375,6 +542,7 @@ alloc_vs(char *param1, char *param2)
 	unsigned fwmark;
 
 	new = (virtual_server_t *) MALLOC(sizeof(virtual_server_t));
+	INIT_LIST_HEAD(&new->rs);
 
 	new->af = AF_UNSPEC;
 
@@ -451,64 +619,6 @@ alloc_ssvr(char *ip, char *port)
 	}
 }
 
-/* Real server facility functions */
-static void
-free_rs(void *data)
-{
-	real_server_t *rs = data;
-
-	free_notify_script(&rs->notify_up);
-	free_notify_script(&rs->notify_down);
-#ifdef _WITH_BFD_
-	free_list(&rs->tracked_bfds);
-#endif
-	FREE_PTR(rs->virtualhost);
-	FREE(rs);
-}
-
-static void
-dump_rs(FILE *fp, void *data)
-{
-	real_server_t *rs = data;
-
-	conf_write(fp, "   ------< Real server >------");
-	conf_write(fp, "   RIP = %s, RPORT = %d, WEIGHT = %d"
-			    , inet_sockaddrtos(&rs->addr)
-			    , ntohs(inet_sockaddrport(&rs->addr))
-			    , rs->weight);
-	switch (rs->forwarding_method) {
-	case IP_VS_CONN_F_MASQ:
-		conf_write(fp, "   Forwarding method = NAT");
-		break;
-	case IP_VS_CONN_F_DROUTE:
-		conf_write(fp, "   Forwarding method = DR");
-		break;
-	case IP_VS_CONN_F_TUNNEL:
-		conf_write(fp, "   Forwarding method = TUN");
-		break;
-	}
-
-	conf_write(fp, "   Alpha is %s", rs->alpha ? "ON" : "OFF");
-	conf_write(fp, "   Delay loop = %lu" , rs->delay_loop / TIMER_HZ);
-	if (rs->retry != UINT_MAX)
-		conf_write(fp, "   Retry count = %u" , rs->retry);
-	if (rs->delay_before_retry != ULONG_MAX)
-		conf_write(fp, "   Retry delay = %lu" , rs->delay_before_retry / TIMER_HZ);
-	if (rs->warmup != ULONG_MAX)
-		conf_write(fp, "   Warmup = %lu", rs->warmup / TIMER_HZ);
-	conf_write(fp, "   Inhibit on failure is %s", rs->inhibit ? "ON" : "OFF");
-
-	if (rs->notify_up)
-		conf_write(fp, "     RS up notify script = %s, uid:gid %d:%d",
-				cmd_str(rs->notify_up), rs->notify_up->uid, rs->notify_up->gid);
-	if (rs->notify_down)
-		conf_write(fp, "     RS down notify script = %s, uid:gid %d:%d",
-				cmd_str(rs->notify_down), rs->notify_down->uid, rs->notify_down->gid);
-	if (rs->virtualhost)
-		conf_write(fp, "    VirtualHost = %s", rs->virtualhost);
-	conf_write(fp, "   Using smtp notification = %s", rs->smtp_alert ? "yes" : "no");
-}
-
 void
 alloc_rs(char *ip, char *port)
 {
@@ -551,10 +661,11 @@ alloc_rs(char *ip, char *port)
 	new->virtualhost = NULL;
 	new->smtp_alert = -1;
 
-// ??? alloc list in alloc_vs
-	if (!LIST_EXISTS(vs->rs))
-		vs->rs = alloc_list(free_rs, dump_rs);
-	list_add(vs->rs, new);
+	INIT_LIST_HEAD(&new->checkers);
+	INIT_HLIST_NODE(&new->e_hash);
+	INIT_LIST_HEAD(&new->e_list);
+	rs_hash_add(vs, new);
+	list_add_tail(&new->e_list, &vs->rs);
 
 	clear_dynamic_misc_check_flag();
 }
@@ -596,6 +707,10 @@ alloc_check_data(void)
 #ifdef _WITH_BFD_
 	new->track_bfds = alloc_list(free_checker_bfd, dump_checker_bfd);
 #endif
+	new->vs_group_index = alloc_name_table();
+#ifdef _WITH_BFD_
+	new->track_bfd_index = alloc_name_table();
+#endif
 
 	return new;
 }
@@ -607,6 +722,10 @@ free_check_data(check_data_t *data)
 	free_list(&data->vs_group);
 #ifdef _WITH_BFD_
 	free_list(&data->track_bfds);
+#endif
+	free_name_table(&data->vs_group_index);
+#ifdef _WITH_BFD_
+	free_name_table(&data->track_bfd_index);
 #endif
 	FREE(data);
 }
@@ -640,7 +759,7 @@ char *
 format_vs (virtual_server_t *vs)
 {
 	/* alloc large buffer because of unknown length of vs->vsgname */
-	static char ret[512];
+	static THREAD_LOCAL char ret[512];
 
 	if (vs->vsgname)
 		snprintf (ret, sizeof (ret) - 1, "[%s]:%d"
@@ -658,7 +777,7 @@ format_vs (virtual_server_t *vs)
 static void
 check_check_script_security(void)
 {
-	element e, e1;
+	element e;
 	virtual_server_t *vs;
 	real_server_t *rs;
 	int script_flags;
@@ -677,9 +796,7 @@ check_check_script_security(void)
 		script_flags |= check_notify_script_secure(&vs->notify_quorum_up, magic);
 		script_flags |= check_notify_script_secure(&vs->notify_quorum_down, magic);
 
-		for (e1 = LIST_HEAD(vs->rs); e1; ELEMENT_NEXT(e1)) {
-			rs = ELEMENT_DATA(e1);
-
+		list_for_each_entry(rs, &vs->rs, e_list) {
 			script_flags |= check_notify_script_secure(&rs->notify_up, magic);
 			script_flags |= check_notify_script_secure(&rs->notify_down, magic);
 		}
@@ -707,10 +824,11 @@ bool validate_check_config(void)
 	real_server_t *rs;
 	checker_t *checker;
 	element next;
+	unsigned num_rs;
 
 	using_ha_suspend = false;
 	LIST_FOREACH_NEXT(check_data->vs, vs, e, next) {
-		if (!vs->rs || LIST_ISEMPTY(vs->rs)) {
+		if (list_empty(&vs->rs)) {
 			report_config_error(CONFIG_GENERAL_ERROR, "Virtual server %s has no real servers - ignoring", FMT_VS(vs));
 			free_list_element(check_data->vs, e);
 			continue;
@@ -718,9 +836,10 @@ bool validate_check_config(void)
 
 		/* Check that the quorum isn't higher than the number of real servers,
 		 * otherwise we will never be able to come up. */
-		if (vs->quorum > LIST_SIZE(vs->rs)) {
-			report_config_error(CONFIG_GENERAL_ERROR, "Warning - quorum %1$d for %2$s exceeds number of real servers %3$d, reducing quorum to %3$d", vs->quorum, FMT_VS(vs), LIST_SIZE(vs->rs));
-			vs->quorum = LIST_SIZE(vs->rs);
+		num_rs = list_count(&vs->rs);
+		if (vs->quorum > num_rs) {
+			report_config_error(CONFIG_GENERAL_ERROR, "Warning - quorum %1$d for %2$s exceeds number of real servers %3$d, reducing quorum to %3$d", vs->quorum, FMT_VS(vs), num_rs);
+			vs->quorum = num_rs;
 		}
 
 		/* Ensure that no virtual server hysteresis >= quorum */
@@ -807,7 +926,7 @@ bool validate_check_config(void)
 		}
 
 		/* Spin through all the real servers */
-		LIST_FOREACH(vs->rs, rs, e1) {
+		list_for_each_entry(rs, &vs->rs, e_list) {
 			/* Set the forwarding method if necessary */
 			if (rs->forwarding_method == IP_VS_CONN_F_FWD_MASK) {
 				if (vs->forwarding_method == IP_VS_CONN_F_FWD_MASK) {
@@ -849,8 +968,7 @@ bool validate_check_config(void)
 		}
 	}
 
-	LIST_FOREACH(checkers_queue, checker, e)
-	{
+	list_for_each_entry(checker, &checkers_queue, e_list) {
 		/* Ensure any checkers that don't have ha_suspend set are enabled */
 		if (!checker->vs->ha_suspend)
 			checker->enabled = true;
@@ -112,8 +112,6 @@ dns_final(thread_t * thread, int error, const char *fmt, ...)
 	char buf[MAX_LOG_MSG];
 	va_list args;
 	int len;
-	bool checker_was_up;
-	bool rs_was_alive;
 
 	checker_t *checker = THREAD_ARG(thread);
 
@@ -123,7 +121,7 @@ dns_final(thread_t * thread, int error, const char *fmt, ...)
 	thread_close_fd(thread);
 
 	if (error) {
-		if (checker->is_up || !checker->has_run) {
+		if (CHECKER_IS_UP(checker) || !CHECKER_HAS_RUN(checker)) {
 			if (checker->retry_it < checker->retry) {
 				checker->retry_it++;
 				thread_add_timer(thread->master,
@@ -135,27 +133,17 @@ dns_final(thread_t * thread, int error, const char *fmt, ...)
 				va_start(args, fmt);
 				len = vsnprintf(buf, sizeof (buf), fmt, args);
 				va_end(args);
-				if (checker->has_run && checker->retry)
+				if (CHECKER_HAS_RUN(checker) && checker->retry)
 					snprintf(buf + len, sizeof(buf) - len, " after %d retries", checker->retry);
 				dns_log_message(thread, LOG_INFO, buf);
 			}
-			checker_was_up = checker->is_up;
-			rs_was_alive = checker->rs->alive;
-			update_svr_checker_state(DOWN, checker);
-			if (checker_was_up && checker->rs->smtp_alert &&
-			    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
-				smtp_alert(SMTP_MSG_RS, checker, NULL,
-					   "=> DNS_CHECK: failed on service <=");
+			update_svr_checker_state_alert(DOWN, checker,
+						       "=> DNS_CHECK: failed on service <=");
 		}
 	} else {
-		if (!checker->is_up || !checker->has_run) {
-			checker_was_up = checker->is_up;
-			rs_was_alive = checker->rs->alive;
-			update_svr_checker_state(UP, checker);
-			if (!checker_was_up && checker->rs->smtp_alert &&
-			    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
-				smtp_alert(SMTP_MSG_RS, checker, NULL,
-					   "=> DNS_CHECK: succeed on service <=");
+		if (!CHECKER_IS_UP(checker) || !CHECKER_HAS_RUN(checker)) {
+			update_svr_checker_state_alert(UP, checker,
+						       "=> DNS_CHECK: succeed on service <=");
 		}
 	}
 
@@ -477,6 +465,7 @@ dns_check_handler(__attribute__((unused)) vector_t * strvec)
 	/* Set the non-standard retry time */
 	checker->default_retry = DNS_DEFAULT_RETRY;
 	checker->default_delay_before_retry = 0;	/* This will default to delay_loop */
+	checker->worker_safe = true;
 }
 
 static void
@@ -365,12 +365,13 @@ http_get_handler(vector_t *strvec)
 		      http_connect_thread, http_get_check_compare,
 		      http_get_chk, CHECKER_NEW_CO());
 	checker->default_delay_before_retry = 3 * TIMER_HZ;
+	checker->worker_safe = true;
 }
 
 static void
 http_get_retry_handler(vector_t *strvec)
 {
-	checker_t *checker = LIST_TAIL_DATA(checkers_queue);
+	checker_t *checker = CHECKER_GET_CURRENT();
 	unsigned retry;
 
 	if (!read_unsigned_strvec(strvec, 1, &retry, 0, UINT_MAX, true)) {
@@ -704,8 +705,12 @@ url_check(void)
 	}
 
 #ifdef _WITH_REGEX_CHECK_
-	if (conf_regex_pattern)
+	if (conf_regex_pattern) {
 		prepare_regex(url);
+
+		/* The match data and JIT stack are shared between urls */
+		CHECKER_GET_CURRENT()->worker_safe = false;
+	}
 	else if (conf_regex_options
 		 || url->regex_no_match
 		 || url->regex_min_offset
@@ -817,8 +822,6 @@ epilog(thread_t * thread, int method, unsigned t, unsigned c)
 	http_checker_t *http_get_check = CHECKER_ARG(checker);
 	request_t *req = http_get_check->req;
 	unsigned long delay = 0;
-	bool checker_was_up;
-	bool rs_was_alive;
 
 	http_get_check->url_it += t ? t : -http_get_check->url_it;
 	checker->retry_it += c ? c : -checker->retry_it;
@@ -828,16 +831,11 @@ epilog(thread_t * thread, int method, unsigned t, unsigned c)
 		 * Check completed.
 		 * check if server is currently alive.
 		 */
-		if (!checker->is_up || !checker->has_run) {
+		if (!CHECKER_IS_UP(checker) || !CHECKER_HAS_RUN(checker)) {
 			log_message(LOG_INFO, "Remote Web server %s succeed on service."
 					    , FMT_HTTP_RS(checker));
-			checker_was_up = checker->is_up;
-			rs_was_alive = checker->rs->alive;
-			update_svr_checker_state(UP, checker);
-			if (!checker_was_up && checker->rs->smtp_alert &&
-			    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
-				smtp_alert(SMTP_MSG_RS, checker, NULL,
-					   "=> CHECK succeed on service <=");
+			update_svr_checker_state_alert(UP, checker,
+						       "=> CHECK succeed on service <=");
 		}
 
 		/* Reset it counters */
@@ -851,8 +849,8 @@ epilog(thread_t * thread, int method, unsigned t, unsigned c)
 	 * servers.
 	 */
 	else if (method == REGISTER_CHECKER_RETRY && checker->retry_it > checker->retry) {
-		if (checker->is_up || !checker->has_run) {
-			if (checker->has_run && checker->retry)
+		if (CHECKER_IS_UP(checker) || !CHECKER_HAS_RUN(checker)) {
+			if (CHECKER_HAS_RUN(checker) && checker->retry)
 				log_message(LOG_INFO
 				   , "Check on service %s failed after %u retry."
 				   , FMT_HTTP_RS(checker)
@@ -861,14 +859,9 @@ epilog(thread_t * thread, int method, unsigned t, unsigned c)
 				log_message(LOG_INFO
 				   , "Check on service %s failed."
 				   , FMT_HTTP_RS(checker));
-			checker_was_up = checker->is_up;
-			rs_was_alive = checker->rs->alive;
-			update_svr_checker_state(DOWN, checker);
-			if (checker_was_up && checker->rs->smtp_alert &&
-			    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
-				smtp_alert(SMTP_MSG_RS, checker, NULL,
-					   "=> CHECK failed on service"
-					   " : HTTP request failed <=");
+			update_svr_checker_state_alert(DOWN, checker,
+						       "=> CHECK failed on service"
+						       " : HTTP request failed <=");
 		}
 
 		/* Reset it counters */
@@ -907,8 +900,8 @@ timeout_epilog(thread_t * thread, const char *debug_msg)
 	checker_t *checker = THREAD_ARG(thread);
 
 	/* check if server is currently alive */
-	if (checker->is_up) {
-		log_message(LOG_INFO, "%s server %s."
+	if (CHECKER_IS_UP(checker)) {
+		log_message_rl(LOG_INFO, "%s server %s."
 				    , debug_msg
 				    , FMT_HTTP_RS(checker));
 		return epilog(thread, REGISTER_CHECKER_RETRY, 0, 1);
@@ -1176,7 +1169,7 @@ http_handle_response(thread_t * thread, unsigned char digest[MD5_DIGEST_LENGTH]
 	}
 #endif
 
-	if (!checker->is_up) {
+	if (!CHECKER_IS_UP(checker)) {
 		switch (last_success) {
 			case NONE:
 				break;
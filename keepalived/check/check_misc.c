@@ -28,6 +28,7 @@
 #include <errno.h>
 #include <signal.h>
 #include <stdio.h>
+#include <sys/wait.h>
 
 #include "main.h"
 #include "check_misc.h"
@@ -47,6 +48,8 @@
 
 static int misc_check_thread(thread_t *);
 static int misc_check_child_thread(thread_t *);
+static int misc_check_coproc_thread(thread_t *);
+static int misc_check_coproc_exit_thread(thread_t *);
 
 static bool script_user_set;
 static misc_checker_t *new_misck_checker;
@@ -64,6 +67,7 @@ free_misc_check(void *data)
 {
 	misc_checker_t *misck_checker = CHECKER_DATA(data);
 
+	coproc_release(&misck_checker->coproc);
 	FREE(misck_checker->script.args);
 	FREE(misck_checker);
 	FREE(data);
@@ -79,6 +83,7 @@ dump_misc_check(FILE *fp, void *data)
 	conf_write(fp, "   script = %s", cmd_str(&misck_checker->script));
 	conf_write(fp, "   timeout = %lu", misck_checker->timeout/TIMER_HZ);
 	conf_write(fp, "   dynamic = %s", misck_checker->dynamic ? "YES" : "NO");
+	conf_write(fp, "   persistent = %s", misck_checker->persistent ? "YES" : "NO");
 	conf_write(fp, "   uid:gid = %d:%d", misck_checker->script.uid, misck_checker->script.gid);
 	dump_checker_opts(fp, checker);
 }
@@ -155,6 +160,15 @@ misc_dynamic_handler(__attribute__((unused)) vector_t *strvec)
 		have_dynamic_misc_checker = true;
 }
 
+static void
+misc_persistent_handler(__attribute__((unused)) vector_t *strvec)
+{
+	if (!new_misck_checker)
+		return;
+
+	new_misck_checker->persistent = true;
+}
+
 static void
 misc_user_handler(vector_t *strvec)
 {
@@ -213,6 +227,7 @@ install_misc_check_keyword(void)
 	install_keyword("misc_path", &misc_path_handler);
 	install_keyword("misc_timeout", &misc_timeout_handler);
 	install_keyword("misc_dynamic", &misc_dynamic_handler);
+	install_keyword("misc_persistent", &misc_persistent_handler);
 	install_keyword("user", &misc_user_handler);
 	install_sublevel_end_handler(&misc_end_handler);
 	install_sublevel_end();
@@ -222,20 +237,13 @@ install_misc_check_keyword(void)
 int
 check_misc_script_security(magic_t magic)
 {
-	element e, next;
-	checker_t *checker;
+	checker_t *checker, *checker_tmp;
 	misc_checker_t *misc_script;
 	int script_flags = 0;
 	int flags;
 	bool insecure;
 
-	if (LIST_ISEMPTY(checkers_queue))
-		return 0;
-
-	for (e = LIST_HEAD(checkers_queue); e; e = next) {
-		next = e->next;
-		checker = ELEMENT_DATA(e);
-
+	list_for_each_entry_safe(checker, checker_tmp, &checkers_queue, e_list) {
 		if (checker->launch != misc_check_thread)
 			continue;
 
@@ -258,7 +266,7 @@ check_misc_script_security(magic_t magic)
 
 		if (insecure) {
 			/* Remove the script */
-			free_list_element(checkers_queue, e);
+			free_checker(checker);
 		}
 	}
 
@@ -285,6 +293,21 @@ misc_check_thread(thread_t * thread)
 		return 0;
 	}
 
+	if (misck_checker->persistent) {
+		if (!misck_checker->coproc.pid &&
+		    coproc_start(thread->master, misc_check_coproc_exit_thread, checker, &misck_checker->coproc, &misck_checker->script))
+			return -1;
+
+		/* If the request can't be sent, the script's exit gives the result */
+		if (coproc_request(thread->master, misc_check_coproc_thread, checker, &misck_checker->coproc,
+				   FMT_CHK(checker), (misck_checker->timeout) ? misck_checker->timeout : checker->vs->delay_loop))
+			coproc_kill(&misck_checker->coproc);
+		misck_checker->last_ran = time_now;
+		misck_checker->state = SCRIPT_STATE_RUNNING;
+
+		return 0;
+	}
+
 	/* Execute the script in a child process. Parent returns, child doesn't */
 	ret = system_call_script(thread->master, misc_check_child_thread,
 				  checker, (misck_checker->timeout) ? misck_checker->timeout : checker->vs->delay_loop,
@@ -297,60 +320,19 @@ misc_check_thread(thread_t * thread)
 	return ret;
 }
 
-static int
-misc_check_child_thread(thread_t * thread)
+/* Apply the result of running a script, given as a wait() status, and
+ * schedule the next check */
+static void
+misc_check_result(checker_t *checker, int wait_status)
 {
-	int wait_status;
-	pid_t pid;
-	checker_t *checker;
-	misc_checker_t *misck_checker;
+	misc_checker_t *misck_checker = CHECKER_ARG(checker);
 	timeval_t next_time;
-	int sig_num;
-	unsigned timeout = 0;
 	char *script_exit_type = NULL;
 	bool script_success;
 	char *reason = NULL;
 	int reason_code = 0;	/* Avoid uninitialised warning by older versions of gcc */
 	bool rs_was_alive;
 
-	checker = THREAD_ARG(thread);
-	misck_checker = CHECKER_ARG(checker);
-
-	if (thread->type == THREAD_CHILD_TIMEOUT) {
-		pid = THREAD_CHILD_PID(thread);
-
-		if (misck_checker->state == SCRIPT_STATE_RUNNING) {
-			misck_checker->state = SCRIPT_STATE_REQUESTING_TERMINATION;
-			sig_num = SIGTERM;
-			timeout = 2;
-		} else if (misck_checker->state == SCRIPT_STATE_REQUESTING_TERMINATION) {
-			misck_checker->state = SCRIPT_STATE_FORCING_TERMINATION;
-			sig_num = SIGKILL;
-			timeout = 2;
-		} else if (misck_checker->state == SCRIPT_STATE_FORCING_TERMINATION) {
-			log_message(LOG_INFO, "Child (PID %d) failed to terminate after kill", pid);
-			sig_num = SIGKILL;
-			timeout = 10;	/* Give it longer to terminate */
-		}
-
-		if (timeout) {
-			/* If kill returns an error, we can't kill the process since either the process has terminated,
-			 * or we don't have permission. If we can't kill it, there is no point trying again. */
-			if (!kill(-pid, sig_num))
-				timeout = 1000;
-		} else if (misck_checker->state != SCRIPT_STATE_IDLE) {
-			log_message(LOG_INFO, "Child thread pid %d timeout with unknown script state %d", pid, misck_checker->state);
-			timeout = 10;	/* We need some timeout */
-		}
-
-		if (timeout)
-			thread_add_child(thread->master, misc_check_child_thread, checker, pid, timeout * TIMER_HZ);
-
-		return 0;
-	}
-
-	wait_status = THREAD_CHILD_STATUS(thread);
-
 	if (WIFEXITED(wait_status)) {
 		int status = WEXITSTATUS(wait_status);
 
@@ -386,14 +368,6 @@ misc_check_child_thread(thread_t * thread)
 		}
 	}
 	else if (WIFSIGNALED(wait_status)) {
-		if (misck_checker->state == SCRIPT_STATE_REQUESTING_TERMINATION && WTERMSIG(wait_status) == SIGTERM) {
-			/* The script terminated due to a SIGTERM, and we sent it a SIGTERM to
-			 * terminate the process. Now make sure any children it created have
-			 * died too. */
-			pid = THREAD_CHILD_PID(thread);
-			kill(-pid, SIGKILL);
-		}
-
 		/* We treat forced termination as a failure */
 		if (checker->is_up || !checker->has_run) {
 			if (checker->retry_it < checker->retry)
@@ -452,18 +426,129 @@ misc_check_child_thread(thread_t * thread)
 	    (next_time.tv_sec == 0 && next_time.tv_usec == 0))
 		next_time.tv_sec = 0, next_time.tv_usec = 1;
 
-	thread_add_timer(thread->master, misc_check_thread, checker, timer_long(next_time));
+	thread_add_timer(master, misc_check_thread, checker, timer_long(next_time));
 
 	misck_checker->state = SCRIPT_STATE_IDLE;
+}
+
+static int
+misc_check_child_thread(thread_t * thread)
+{
+	int wait_status;
+	pid_t pid;
+	checker_t *checker;
+	misc_checker_t *misck_checker;
+	int sig_num;
+	unsigned timeout = 0;
+
+	checker = THREAD_ARG(thread);
+	misck_checker = CHECKER_ARG(checker);
+
+	if (thread->type == THREAD_CHILD_TIMEOUT) {
+		pid = THREAD_CHILD_PID(thread);
+
+		if (misck_checker->state == SCRIPT_STATE_RUNNING) {
+			misck_checker->state = SCRIPT_STATE_REQUESTING_TERMINATION;
+			sig_num = SIGTERM;
+			timeout = 2;
+		} else if (misck_checker->state == SCRIPT_STATE_REQUESTING_TERMINATION) {
+			misck_checker->state = SCRIPT_STATE_FORCING_TERMINATION;
+			sig_num = SIGKILL;
+			timeout = 2;
+		} else if (misck_checker->state == SCRIPT_STATE_FORCING_TERMINATION) {
+			log_message(LOG_INFO, "Child (PID %d) failed to terminate after kill", pid);
+			sig_num = SIGKILL;
+			timeout = 10;	/* Give it longer to terminate */
+		}
+
+		if (timeout) {
+			/* If kill returns an error, we can't kill the process since either the process has terminated,
+			 * or we don't have permission. If we can't kill it, there is no point trying again. */
+			if (!kill(-pid, sig_num))
+				timeout = 1000;
+		} else if (misck_checker->state != SCRIPT_STATE_IDLE) {
+			log_message(LOG_INFO, "Child thread pid %d timeout with unknown script state %d", pid, misck_checker->state);
+			timeout = 10;	/* We need some timeout */
+		}
+
+		if (timeout)
+			thread_add_child(thread->master, misc_check_child_thread, checker, pid, timeout * TIMER_HZ);
+
+		return 0;
+	}
+
+	wait_status = THREAD_CHILD_STATUS(thread);
+
+	if (WIFSIGNALED(wait_status) &&
+	    misck_checker->state == SCRIPT_STATE_REQUESTING_TERMINATION && WTERMSIG(wait_status) == SIGTERM) {
+		/* The script terminated due to a SIGTERM, and we sent it a SIGTERM to
+		 * terminate the process. Now make sure any children it created have
+		 * died too. */
+		pid = THREAD_CHILD_PID(thread);
+		kill(-pid, SIGKILL);
+	}
+
+	misc_check_result(checker, wait_status);
+
+	return 0;
+}
+
+/* The reply of a persistent script is used as its exit status would be */
+static int
+misc_check_coproc_thread(thread_t * thread)
+{
+	checker_t *checker = THREAD_ARG(thread);
+	misc_checker_t *misck_checker = CHECKER_ARG(checker);
+	int value;
+	int ret;
+
+	ret = coproc_read(thread, &misck_checker->coproc, &value);
+	if (ret > 0)
+		misc_check_result(checker, W_EXITCODE(value, 0));
+	else if (ret < 0) {
+		/* It is killed, and its exit gives the result */
+		if (thread->type == THREAD_READ_TIMEOUT)
+			misck_checker->state = SCRIPT_STATE_FORCING_TERMINATION;
+		coproc_kill(&misck_checker->coproc);
+	}
+
+	return 0;
+}
+
+static int
+misc_check_coproc_exit_thread(thread_t * thread)
+{
+	checker_t *checker = THREAD_ARG(thread);
+	misc_checker_t *misck_checker = CHECKER_ARG(checker);
+
+	if (thread->type != THREAD_CHILD_TERMINATED ||
+	    THREAD_CHILD_PID(thread) != misck_checker->coproc.pid)
+		return 0;
+
+	coproc_exited(&misck_checker->coproc, THREAD_CHILD_STATUS(thread));
+
+	/* If it exited while a request was outstanding, its exit status is the result */
+	if (misck_checker->state != SCRIPT_STATE_IDLE)
+		misc_check_result(checker, THREAD_CHILD_STATUS(thread));
 
 	return 0;
 }
 
+void
+set_check_misc_thread_priorities(void)
+{
+	thread_set_func_priority(master, misc_check_child_thread, THREAD_PRIO_BULK);
+	thread_set_func_priority(master, misc_check_coproc_thread, THREAD_PRIO_BULK);
+	thread_set_func_priority(master, misc_check_coproc_exit_thread, THREAD_PRIO_BULK);
+}
+
 #ifdef THREAD_DUMP
 void
 register_check_misc_addresses(void)
 {
 	register_thread_address("misc_check_child_thread", misc_check_child_thread);
+	register_thread_address("misc_check_coproc_thread", misc_check_coproc_thread);
+	register_thread_address("misc_check_coproc_exit_thread", misc_check_coproc_exit_thread);
 	register_thread_address("misc_check_thread", misc_check_thread);
 }
 #endif
@@ -117,6 +117,7 @@ vsg_handler(vector_t *strvec)
 	vsg = LIST_TAIL_DATA(check_data->vs_group);
 	if (LIST_ISEMPTY(vsg->vfwmark) && LIST_ISEMPTY(vsg->addr_range)) {
 		report_config_error(CONFIG_GENERAL_ERROR, "virtual server group %s has no entries - removing", vsg->gname);
+		name_table_remove(check_data->vs_group_index, vsg->gname, vsg);
 		free_list_element(check_data->vs_group, check_data->vs_group->tail);
 	}
 }
@@ -136,7 +137,8 @@ vs_end_handler(void)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
 	real_server_t *rs;
-	element e;
+
+	get_config_block(&vs->conf_block);
 
 	/* If the real (sorry) server uses tunnel forwarding, the address family
 	 * does not have to match the address family of the virtual server */
@@ -168,15 +170,12 @@ vs_end_handler(void)
 		if (vs->s_svr)
 			vs->af = vs->s_svr->addr.ss_family;
 
-		if (!LIST_ISEMPTY(vs->rs)) {
-			for (e = LIST_HEAD(vs->rs); e; ELEMENT_NEXT(e)) {
-				rs = ELEMENT_DATA(e);
-				if (vs->af == AF_UNSPEC)
-					vs->af = rs->addr.ss_family;
-				else if (vs->af != rs->addr.ss_family) {
-					vs->af = AF_UNSPEC;
-					break;
-				}
+		list_for_each_entry(rs, &vs->rs, e_list) {
+			if (vs->af == AF_UNSPEC)
+				vs->af = rs->addr.ss_family;
+			else if (vs->af != rs->addr.ss_family) {
+				vs->af = AF_UNSPEC;
+				break;
 			}
 		}
 
@@ -507,10 +506,10 @@ rs_end_handler(void)
 
 	vs = LIST_TAIL_DATA(check_data->vs);
 
-	if (LIST_ISEMPTY(vs->rs))
+	if (list_empty(&vs->rs))
 		return;
 
-	rs = LIST_TAIL_DATA(vs->rs);
+	rs = list_last_entry(&vs->rs, real_server_t, e_list);
 
 	/* For tunnelled forwarding, the address families don't have to be the same, so
 	 * long as the kernel supports IPVS_DEST_ATTR_ADDR_FAMILY */
@@ -522,7 +521,8 @@ rs_end_handler(void)
 			vs->af = rs->addr.ss_family;
 		else if (vs->af != rs->addr.ss_family) {
 			report_config_error(CONFIG_GENERAL_ERROR, "Address family of virtual server and real server %s don't match - skipping real server.", inet_sockaddrtos(&rs->addr));
-			free_list_element(vs->rs, vs->rs->tail);
+			rs_hash_del(vs, rs);
+			free_rs(rs);
 		}
 	}
 }
@@ -530,7 +530,7 @@ static void
 rs_weight_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	unsigned weight;
 
 	if (!read_unsigned_strvec(strvec, 1, &weight, 1, 65535, true)) {
@@ -544,7 +544,7 @@ static void
 rs_forwarding_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 
 	svr_forwarding_handler(rs, strvec);
 }
@@ -552,7 +552,7 @@ static void
 uthreshold_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	unsigned threshold;
 
 	if (!read_unsigned_strvec(strvec, 1, &threshold, 0, UINT_MAX, true)) {
@@ -565,7 +565,7 @@ static void
 lthreshold_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	unsigned threshold;
 
 	if (!read_unsigned_strvec(strvec, 1, &threshold, 0, UINT_MAX, true)) {
@@ -589,7 +589,7 @@ static void
 notify_up_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	if (rs->notify_up) {
 		report_config_error(CONFIG_GENERAL_ERROR, "(%s) notify_up script already specified - ignoring %s", vs->vsgname, FMT_STR_VSLOT(strvec,1));
 		return;
@@ -600,7 +600,7 @@ static void
 notify_down_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	if (rs->notify_down) {
 		report_config_error(CONFIG_GENERAL_ERROR, "(%s) notify_down script already specified - ignoring %s", vs->vsgname, FMT_STR_VSLOT(strvec,1));
 		return;
@@ -611,7 +611,7 @@ static void
 rs_delay_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	unsigned long delay;
 
 	if (read_timer(strvec, 1, &delay, 1, 0, true))
@@ -623,7 +623,7 @@ static void
 rs_delay_before_retry_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	unsigned long delay;
 
 	if (read_timer(strvec, 1, &delay, 0, 0, true))
@@ -635,7 +635,7 @@ static void
 rs_retry_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	unsigned retry;
 
 	if (!read_unsigned_strvec(strvec, 1, &retry, 1, UINT32_MAX, false)) {
@@ -648,7 +648,7 @@ static void
 rs_warmup_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	unsigned long delay;
 
 	if (read_timer(strvec, 1, &delay, 0, 0, true))
@@ -660,7 +660,7 @@ static void
 rs_inhibit_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	int res = true;
 
 	if (vector_size(strvec) >= 2) {
@@ -676,7 +676,7 @@ static void
 rs_alpha_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	int res = true;
 
 	if (vector_size(strvec) >= 2) {
@@ -692,7 +692,7 @@ static void
 rs_smtp_alert_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	int res = true;
 
 	if (vector_size(strvec) >= 2) {
@@ -708,7 +708,7 @@ static void
 rs_virtualhost_handler(vector_t *strvec)
 {
 	virtual_server_t *vs = LIST_TAIL_DATA(check_data->vs);
-	real_server_t *rs = LIST_TAIL_DATA(vs->rs);
+	real_server_t *rs = list_last_entry(&vs->rs, real_server_t, e_list);
 	rs->virtualhost = set_value(strvec);
 }
 static void
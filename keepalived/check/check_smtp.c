@@ -135,7 +135,8 @@ smtp_check_handler(__attribute__((unused)) vector_t *strvec)
 		      smtp_check_compare, smtp_checker, default_co);
 
 	/* Set an empty conn_opts for any connection configured */
-	((checker_t *)checkers_queue->tail->data)->co = (conn_opts_t*)MALLOC(sizeof(conn_opts_t));
+	CHECKER_GET_CURRENT()->co = (conn_opts_t*)MALLOC(sizeof(conn_opts_t));
+	CHECKER_GET_CURRENT()->worker_safe = true;
 
 	/*
 	 * Last, allocate the list that will hold all the per host
@@ -283,8 +284,6 @@ smtp_final(thread_t *thread, int error, const char *format, ...)
 	char error_buff[512];
 	char smtp_buff[542];
 	va_list varg_list;
-	bool checker_was_up;
-	bool rs_was_alive;
 
 	/* Error or no error we should always have to close the socket */
 	thread_close_fd(thread);
@@ -293,8 +292,9 @@ smtp_final(thread_t *thread, int error, const char *format, ...)
 	checker->retry_it++;
 
 	if (error) {
-		/* Always syslog the error when the real server is up */
-		if (checker->is_up) {
+		/* Syslog the error when the real server is up, subject to
+		 * the log rate limit */
+		if (CHECKER_IS_UP(checker) && log_ratelimit_ok(LOG_INFO)) {
 			if (format != NULL) {
 				/* prepend format with the "SMTP_CHECK " string */
 				strncpy(error_buff, "SMTP_CHECK ", sizeof(error_buff) - 1);
@@ -325,23 +325,17 @@ smtp_final(thread_t *thread, int error, const char *format, ...)
 		 * be noted that smtp_alert makes a copy of the string arguments, so
 		 * we don't have to keep them statically allocated.
 		 */
-		if (checker->is_up || !checker->has_run) {
-			checker_was_up = checker->is_up;
-			rs_was_alive = checker->rs->alive;
-			update_svr_checker_state(DOWN, checker);
-			if (checker->rs->smtp_alert && checker_was_up &&
-			    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails)) {
-				if (format != NULL) {
-					snprintf(error_buff, sizeof(error_buff), "=> CHECK failed on service : %s <=", format);
-					va_start(varg_list, format);
-					vsnprintf(smtp_buff, sizeof(smtp_buff), error_buff, varg_list);
-					va_end(varg_list);
-				} else
-					strncpy(smtp_buff, "=> CHECK failed on service <=", sizeof(smtp_buff));
-
-				smtp_buff[sizeof(smtp_buff) - 1] = '\0';
-				smtp_alert(SMTP_MSG_RS, checker, NULL, smtp_buff);
-			}
+		if (CHECKER_IS_UP(checker) || !CHECKER_HAS_RUN(checker)) {
+			if (format != NULL) {
+				snprintf(error_buff, sizeof(error_buff), "=> CHECK failed on service : %s <=", format);
+				va_start(varg_list, format);
+				vsnprintf(smtp_buff, sizeof(smtp_buff), error_buff, varg_list);
+				va_end(varg_list);
+			} else
+				strncpy(smtp_buff, "=> CHECK failed on service <=", sizeof(smtp_buff));
+
+			smtp_buff[sizeof(smtp_buff) - 1] = '\0';
+			update_svr_checker_state_alert(DOWN, checker, smtp_buff);
 		}
 
 		/* Reset everything back to the first host in the list */
@@ -726,8 +720,6 @@ smtp_connect_thread(thread_t *thread)
 	conn_opts_t *smtp_host;
 	enum connect_result status;
 	int sd;
-	bool checker_was_up;
-	bool rs_was_alive;
 
 	/* Let's review our data structures.
 	 *
@@ -773,17 +765,12 @@ smtp_connect_thread(thread_t *thread)
 	 * will be reset and we will continue on checking them one by one.
 	 */
 	if ((smtp_checker->host_ptr = list_element(smtp_checker->host, smtp_checker->host_ctr)) == NULL) {
-		if (!checker->is_up || !checker->has_run) {
+		if (!CHECKER_IS_UP(checker) || !CHECKER_HAS_RUN(checker)) {
 			log_message(LOG_INFO, "Remote SMTP server %s succeed on service."
 					    , FMT_CHK(checker));
 
-			checker_was_up = checker->is_up;
-			rs_was_alive = checker->rs->alive;
-			update_svr_checker_state(UP, checker);
-			if (checker->rs->smtp_alert && !checker_was_up &&
-			    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
-				smtp_alert(SMTP_MSG_RS, checker, NULL,
-					   "=> CHECK succeed on service <=");
+			update_svr_checker_state_alert(UP, checker,
+						       "=> CHECK succeed on service <=");
 		}
 
 		checker->retry_it = 0;
@@ -394,7 +394,7 @@ check_snmp_virtualserver(struct variable *vp, oid *name, size_t *length,
 {
 	static struct counter64 counter64_ret;
 	virtual_server_t *v;
-	element e;
+	real_server_t *rs;
 
 	if ((v = (virtual_server_t *)
 	     snmp_header_list_table(vp, name, length, exact,
@@ -540,17 +540,13 @@ check_snmp_virtualserver(struct variable *vp, oid *name, size_t *length,
 		long_ret.u = v->hysteresis;
 		return (u_char*)&long_ret;
 	case CHECK_SNMP_VSREALTOTAL:
-		if (LIST_ISEMPTY(v->rs))
-			long_ret.u = 0;
-		else
-			long_ret.u = LIST_SIZE(v->rs);
+		long_ret.u = list_count(&v->rs);
 		return (u_char*)&long_ret;
 	case CHECK_SNMP_VSREALUP:
 		long_ret.u = 0;
-		if (!LIST_ISEMPTY(v->rs))
-			for (e = LIST_HEAD(v->rs); e; ELEMENT_NEXT(e))
-				if (((real_server_t *)ELEMENT_DATA(e))->alive)
-					long_ret.u++;
+		list_for_each_entry(rs, &v->rs, e_list)
+			if (rs->alive)
+				long_ret.u++;
 		return (u_char*)&long_ret;
 	case CHECK_SNMP_VSSTATSCONNS:
 		ipvs_update_stats(v);
@@ -708,7 +704,7 @@ check_snmp_realserver_weight(int action,
 			     u_char *var_val, u_char var_val_type, size_t var_val_len,
 			     __attribute__((unused)) u_char *statP, oid *name, size_t name_len)
 {
-	element e1, e2;
+	element e1;
 	virtual_server_t *vs = NULL;
 	real_server_t *rs = NULL;
 	oid ivs, irs;
@@ -736,10 +732,11 @@ check_snmp_realserver_weight(int action,
 					rs = NULL;
 					if (--irs == 0) break;
 				}
-				for (e2 = LIST_HEAD(vs->rs); e2; ELEMENT_NEXT(e2)) {
-					rs = ELEMENT_DATA(e2);
+				list_for_each_entry(rs, &vs->rs, e_list) {
 					if (--irs == 0) break;
 				}
+				if (&rs->e_list == &vs->rs)
+					rs = NULL;
 				break;
 			}
 		}
@@ -765,7 +762,8 @@ check_snmp_realserver(struct variable *vp, oid *name, size_t *length,
 	size_t target_len;
 	unsigned curvirtual = 0, curreal;
 	real_server_t *e = NULL, *be = NULL;
-	element e1, e2 = NULL;
+	element e1;
+	list_head_t *e2 = NULL;
 	virtual_server_t *vs, *bvs = NULL;
 	int state;
 	int type, btype;
@@ -803,19 +801,19 @@ check_snmp_realserver(struct variable *vp, oid *name, size_t *length,
 				type = state++;
 				break;
 			case STATE_RS_REGULAR_FIRST:
-				e2 = LIST_HEAD(vs->rs);
-				e = ELEMENT_DATA(e2);
+				e2 = vs->rs.next;
+				e = list_empty(&vs->rs) ? NULL : list_entry(e2, real_server_t, e_list);
 				type = state++;
 				break;
 			case STATE_RS_REGULAR_NEXT:
 				type = state;
-				ELEMENT_NEXT(e2);
-				if (!e2) {
+				e2 = e2->next;
+				if (e2 == &vs->rs) {
 					e = NULL;
 					state++;
 					break;
 				}
-				e = ELEMENT_DATA(e2);
+				e = list_entry(e2, real_server_t, e_list);
 				break;
 			default:
 				/* Dunno? */
@@ -1475,7 +1473,7 @@ check_snmp_agent_close()
 void
 check_snmp_rs_trap(real_server_t *rs, virtual_server_t *vs, bool stopping)
 {
-	element e;
+	real_server_t *r;
 
 	/* OID of the notification */
 	oid notification_oid[] = { CHECK_OID, 5, 0, 1 };
@@ -1537,10 +1535,10 @@ check_snmp_rs_trap(real_server_t *rs, virtual_server_t *vs, bool stopping)
 		notification_oid[notification_oid_len - 1] = 2;
 
 	/* Initialize data */
-	realtotal = LIST_SIZE(vs->rs);
+	realtotal = list_count(&vs->rs);
 	realup = 0;
-	for (e = LIST_HEAD(vs->rs); e; ELEMENT_NEXT(e))
-		if (((real_server_t *)ELEMENT_DATA(e))->alive)
+	list_for_each_entry(r, &vs->rs, e_list)
+		if (r->alive)
 			realup++;
 
 	/* snmpTrapOID */
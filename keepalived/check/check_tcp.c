@@ -69,9 +69,12 @@ tcp_check_compare(void *a, void *b)
 static void
 tcp_check_handler(__attribute__((unused)) vector_t *strvec)
 {
+	checker_t *checker;
+
 	/* queue new checker */
-	queue_checker(free_tcp_check, dump_tcp_check, tcp_connect_thread,
-		      tcp_check_compare, NULL, CHECKER_NEW_CO());
+	checker = queue_checker(free_tcp_check, dump_tcp_check, tcp_connect_thread,
+				tcp_check_compare, NULL, CHECKER_NEW_CO());
+	checker->worker_safe = true;
 }
 
 static void
@@ -97,8 +100,6 @@ tcp_epilog(thread_t * thread, bool is_success)
 {
 	checker_t *checker;
 	unsigned long delay;
-	bool checker_was_up;
-	bool rs_was_alive;
 
 	checker = THREAD_ARG(thread);
 
@@ -106,18 +107,13 @@ tcp_epilog(thread_t * thread, bool is_success)
 		delay = checker->delay_loop;
 		checker->retry_it = 0;
 
-		if (is_success && (!checker->is_up || !checker->has_run)) {
+		if (is_success && (!CHECKER_IS_UP(checker) || !CHECKER_HAS_RUN(checker))) {
 			log_message(LOG_INFO, "TCP connection to %s success."
 					, FMT_TCP_RS(checker));
-			checker_was_up = checker->is_up;
-			rs_was_alive = checker->rs->alive;
-			update_svr_checker_state(UP, checker);
-			if (checker->rs->smtp_alert && !checker_was_up &&
-			    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
-				smtp_alert(SMTP_MSG_RS, checker, NULL,
-					   "=> TCP CHECK succeed on service <=");
+			update_svr_checker_state_alert(UP, checker,
+						       "=> TCP CHECK succeed on service <=");
 		} else if (!is_success && 
-			   (checker->is_up || !checker->has_run)) {
+			   (CHECKER_IS_UP(checker) || !CHECKER_HAS_RUN(checker))) {
 			if (checker->retry)
 				log_message(LOG_INFO
 				    , "Check on service %s failed after %d retries."
@@ -127,13 +123,8 @@ tcp_epilog(thread_t * thread, bool is_success)
 				log_message(LOG_INFO
 				    , "Check on service %s failed."
 				    , FMT_TCP_RS(checker));
-			checker_was_up = checker->is_up;
-			rs_was_alive = checker->rs->alive;
-			update_svr_checker_state(DOWN, checker);
-			if (checker->rs->smtp_alert && checker_was_up &&
-			    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
-				smtp_alert(SMTP_MSG_RS, checker, NULL,
-					   "=> TCP CHECK failed on service <=");
+			update_svr_checker_state_alert(DOWN, checker,
+						       "=> TCP CHECK failed on service <=");
 		}
 	} else {
 		delay = checker->delay_before_retry;
@@ -164,14 +155,14 @@ tcp_check_thread(thread_t * thread)
 		tcp_epilog(thread, true);
 		break;
 	case connect_timeout:
-		if (checker->is_up)
-			log_message(LOG_INFO, "TCP connection to %s timeout."
+		if (CHECKER_IS_UP(checker))
+			log_message_rl(LOG_INFO, "TCP connection to %s timeout."
 					, FMT_TCP_RS(checker));
 		tcp_epilog(thread, false);
 		break;
 	default:
-		if (checker->is_up)
-			log_message(LOG_INFO, "TCP connection to %s failed."
+		if (CHECKER_IS_UP(checker))
+			log_message_rl(LOG_INFO, "TCP connection to %s failed."
 					, FMT_TCP_RS(checker));
 		tcp_epilog(thread, false);
 	}
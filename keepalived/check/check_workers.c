@@ -0,0 +1,371 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        Checker worker threads. The worker_safe checkers are
+ *              sharded by real server over a pool of threads, each
+ *              running its own thread_master. Checker state changes are
+ *              passed back to the main thread, which owns the IPVS
+ *              topology, notifies and SNMP.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2001-2018 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#include "config.h"
+
+/* system includes */
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+/* local includes */
+#include "check_workers.h"
+#include "check_api.h"
+#include "ipwrapper.h"
+#include "global_data.h"
+#include "scheduler.h"
+#include "list_head.h"
+#include "logger.h"
+#include "memory.h"
+#include "timer.h"
+
+typedef struct _checker_worker {
+	unsigned		id;
+	pthread_t		tid;
+	bool			running;
+	thread_master_t		*master;	/* The worker's own thread master */
+	int			ctl_fd;		/* eventfd to tell the worker to stop */
+	list			checkers;	/* The checkers this worker runs */
+	unsigned		seed;		/* For the warmup delays */
+} checker_worker_t;
+
+/* A checker state change waiting to be applied by the main thread */
+typedef struct _checker_result {
+	checker_t		*checker;
+	bool			alive;
+	char			*alert;		/* SMTP alert to send if the state changes */
+
+	/* Linked list member */
+	list_head_t		e;
+} checker_result_t;
+
+static checker_worker_t *workers;
+static unsigned num_workers;
+static unsigned assign_worker;
+static real_server_t *assign_rs;
+
+/* Set on each worker thread, NULL on the main thread */
+static THREAD_LOCAL checker_worker_t *current_worker;
+
+static pthread_mutex_t results_lock = PTHREAD_MUTEX_INITIALIZER;
+static LH_LIST_HEAD(results);
+static int results_fd = -1;
+static thread_t *results_thread;
+
+void
+init_checker_workers(unsigned num)
+{
+	unsigned i;
+
+#ifdef _MEM_CHECK_
+	/* The memory checker's allocation tracking is not thread safe */
+	if (num) {
+		log_message(LOG_INFO, "checker_threads is not supported with memory checking - running checkers on main thread");
+		num = 0;
+	}
+#endif
+
+	num_workers = num;
+	assign_worker = 0;
+	assign_rs = NULL;
+
+	if (!num_workers)
+		return;
+
+	workers = MALLOC(num_workers * sizeof(checker_worker_t));
+	for (i = 0; i < num_workers; i++) {
+		workers[i].id = i;
+		workers[i].ctl_fd = -1;
+		workers[i].checkers = alloc_list(NULL, NULL);
+		workers[i].seed = (unsigned)rand();
+	}
+}
+
+/* Called from register_checkers_thread(). Returns true if a worker thread will
+ * run the checker. The checkers of a real server are queued consecutively, so
+ * they are all given to the same worker. */
+bool
+checker_worker_assign(checker_t *checker)
+{
+	if (!num_workers || !checker->worker_safe)
+		return false;
+
+	if (checker->rs != assign_rs) {
+		if (assign_rs && ++assign_worker == num_workers)
+			assign_worker = 0;
+		assign_rs = checker->rs;
+	}
+
+	list_add(workers[assign_worker].checkers, checker);
+
+	/* From now on only the worker reads and writes these */
+	checker->on_worker = true;
+	checker->worker_is_up = checker->is_up;
+	checker->worker_has_run = checker->has_run;
+
+	return true;
+}
+
+/* Called in the context of a worker thread, from update_svr_checker_state_alert().
+ * The checker and real server state is only touched by the main thread, which
+ * also decides whether to send the alert. */
+bool
+checker_worker_post_state(bool alive, checker_t *checker, const char *alert)
+{
+	checker_result_t *result;
+	uint64_t val = 1;
+
+	if (!current_worker)
+		return false;
+
+	checker->worker_is_up = alive;
+	checker->worker_has_run = true;
+
+	PMALLOC(result);
+	result->checker = checker;
+	result->alive = alive;
+	if (alert) {
+		result->alert = MALLOC(strlen(alert) + 1);
+		strcpy(result->alert, alert);
+	}
+
+	pthread_mutex_lock(&results_lock);
+	list_add_tail(&result->e, &results);
+	pthread_mutex_unlock(&results_lock);
+
+	if (write(results_fd, &val, sizeof(val)) == -1 && errno != EAGAIN)
+		log_message(LOG_INFO, "checker thread %u: unable to signal result - %s", current_worker->id, strerror(errno));
+
+	return true;
+}
+
+static void
+apply_checker_results(void)
+{
+	checker_result_t *result, *result_tmp;
+	list_head_t pending;
+
+	INIT_LIST_HEAD(&pending);
+
+	pthread_mutex_lock(&results_lock);
+	list_splice_init(&results, &pending);
+	pthread_mutex_unlock(&results_lock);
+
+	list_for_each_entry_safe(result, result_tmp, &pending, e) {
+		list_head_del(&result->e);
+		update_svr_checker_state_alert(result->alive, result->checker, result->alert);
+		FREE_PTR(result->alert);
+		FREE(result);
+	}
+}
+
+static int
+checker_results_thread(thread_t *thread)
+{
+	uint64_t val;
+
+	if (read(thread->u.fd, &val, sizeof(val)) == -1 && errno != EAGAIN)
+		log_message(LOG_INFO, "Unable to read checker results eventfd - %s", strerror(errno));
+
+	apply_checker_results();
+
+	results_thread = thread_add_read(thread->master, checker_results_thread, NULL, thread->u.fd, TIMER_NEVER);
+
+	return 0;
+}
+
+static int
+checker_worker_ctl_thread(thread_t *thread)
+{
+	thread_add_terminate_event(thread->master);
+
+	return 0;
+}
+
+static void *
+checker_worker_thread(void *arg)
+{
+	checker_worker_t *worker = arg;
+	checker_t *checker;
+	element e;
+	unsigned long warmup;
+	sigset_t sigs;
+
+	/* Signals are handled by the main thread's signalfd */
+	sigfillset(&sigs);
+	pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+
+	current_worker = worker;
+	master = worker->master;
+	set_time_now();
+
+	thread_add_read(master, checker_worker_ctl_thread, NULL, worker->ctl_fd, TIMER_NEVER);
+
+	LIST_FOREACH(worker->checkers, checker, e) {
+		warmup = checker->warmup;
+		if (warmup)
+			warmup = warmup * (unsigned)rand_r(&worker->seed) / RAND_MAX;
+		thread_add_timer(master, checker->launch, checker,
+				 BOOTSTRAP_DELAY + warmup);
+	}
+
+	process_threads(master);
+
+	return NULL;
+}
+
+/* Run a worker's checkers on the main thread if the worker can't be started */
+static void
+checker_worker_fallback(checker_worker_t *worker)
+{
+	checker_t *checker;
+	element e;
+
+	LIST_FOREACH(worker->checkers, checker, e) {
+		checker->on_worker = false;
+		thread_add_timer(master, checker->launch, checker, BOOTSTRAP_DELAY);
+	}
+}
+
+void
+start_checker_workers(void)
+{
+	checker_worker_t *worker;
+	checker_t *checker;
+	element e;
+	unsigned i;
+	unsigned started = 0;
+	size_t size;
+	int ret;
+
+	if (!num_workers)
+		return;
+
+	results_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (results_fd == -1) {
+		log_message(LOG_INFO, "Unable to create checker results eventfd - %s", strerror(errno));
+		for (i = 0; i < num_workers; i++)
+			checker_worker_fallback(&workers[i]);
+		return;
+	}
+	results_thread = thread_add_read(master, checker_results_thread, NULL, results_fd, TIMER_NEVER);
+	thread_set_func_priority(master, checker_results_thread, THREAD_PRIO_CRITICAL);
+
+	for (i = 0; i < num_workers; i++) {
+		worker = &workers[i];
+
+		if (LIST_ISEMPTY(worker->checkers))
+			continue;
+
+		worker->ctl_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		worker->master = worker->ctl_fd == -1 ? NULL : thread_make_worker_master();
+		if (!worker->master) {
+			log_message(LOG_INFO, "Unable to set up checker thread %u - running its checkers on main thread", i);
+			checker_worker_fallback(worker);
+			continue;
+		}
+
+		size = LIST_SIZE(worker->checkers);
+		thread_master_prealloc(worker->master, 2 * size + THREAD_SLAB_CHUNK, size + THREAD_SLAB_CHUNK);
+		thread_set_timer_wheel(worker->master, global_data->timer_wheel);
+		thread_set_timer_slack(worker->master, master->timer_slack);
+		LIST_FOREACH(worker->checkers, checker, e)
+			thread_set_func_slack(worker->master, checker->launch);
+
+		if ((ret = pthread_create(&worker->tid, NULL, checker_worker_thread, worker))) {
+			log_message(LOG_INFO, "Unable to start checker thread %u - %s - running its checkers on main thread", i, strerror(ret));
+			thread_destroy_master(worker->master);
+			worker->master = NULL;
+			checker_worker_fallback(worker);
+			continue;
+		}
+
+		worker->running = true;
+		started++;
+	}
+
+	log_message(LOG_INFO, "Started %u checker thread%s", started, started == 1 ? "" : "s");
+}
+
+void
+stop_checker_workers(void)
+{
+	checker_worker_t *worker;
+	uint64_t val = 1;
+	unsigned i;
+
+	if (!num_workers)
+		return;
+
+	for (i = 0; i < num_workers; i++) {
+		worker = &workers[i];
+		if (worker->running &&
+		    write(worker->ctl_fd, &val, sizeof(val)) == -1)
+			log_message(LOG_INFO, "Unable to stop checker thread %u - %s", i, strerror(errno));
+	}
+
+	for (i = 0; i < num_workers; i++) {
+		worker = &workers[i];
+		if (worker->running) {
+			pthread_join(worker->tid, NULL);
+			worker->running = false;
+		}
+		if (worker->master)
+			thread_destroy_master(worker->master);
+		if (worker->ctl_fd != -1)
+			close(worker->ctl_fd);
+		free_list(&worker->checkers);
+	}
+
+	/* Apply anything the workers reported before they stopped */
+	apply_checker_results();
+
+	if (results_thread) {
+		thread_cancel(results_thread);
+		results_thread = NULL;
+	}
+	if (results_fd != -1) {
+		close(results_fd);
+		results_fd = -1;
+	}
+
+	FREE(workers);
+	num_workers = 0;
+}
+
+#ifdef THREAD_DUMP
+void
+register_check_workers_addresses(void)
+{
+	register_thread_address("checker_results_thread", checker_results_thread);
+	register_thread_address("checker_worker_ctl_thread", checker_worker_ctl_thread);
+}
+#endif
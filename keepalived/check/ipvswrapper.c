@@ -130,17 +130,9 @@ modprobe_ipvs(void)
 }
 /* fetch virtual server group from group name */
 virtual_server_group_t *
-ipvs_get_group_by_name(char *gname, list l)
+ipvs_get_group_by_name(char *gname, name_table_t *index)
 {
-	element e;
-	virtual_server_group_t *vsg;
-
-	for (e = LIST_HEAD(l); e; ELEMENT_NEXT(e)) {
-		vsg = ELEMENT_DATA(e);
-		if (!strcmp(vsg->gname, gname))
-			return vsg;
-	}
-	return NULL;
+	return name_table_lookup(index, gname);
 }
 
 /* Initialization helpers */
@@ -557,7 +549,6 @@ void
 ipvs_group_sync_entry(virtual_server_t *vs, virtual_server_group_entry_t *vsge)
 {
 	real_server_t *rs;
-	element e;
 	ipvs_service_t srule;
 	ipvs_dest_t drule;
 
@@ -568,7 +559,7 @@ ipvs_group_sync_entry(virtual_server_t *vs, virtual_server_group_entry_t *vsge)
 		srule.user.port = inet_sockaddrport(&vsge->addr);
 
 	/* Process realserver queue */
-	LIST_FOREACH(vs->rs, rs, e) {
+	list_for_each_entry(rs, &vs->rs, e_list) {
 // ??? What if !quorum_state_up?
 		if (rs->reloaded && (rs->alive || (rs->inhibit && rs->set))) {
 			/* Prepare the IPVS drule */
@@ -591,7 +582,6 @@ void
 ipvs_group_remove_entry(virtual_server_t *vs, virtual_server_group_entry_t *vsge)
 {
 	real_server_t *rs;
-	element e;
 	ipvs_service_t srule;
 	ipvs_dest_t drule;
 
@@ -603,7 +593,7 @@ ipvs_group_remove_entry(virtual_server_t *vs, virtual_server_group_entry_t *vsge
 		srule.user.port = inet_sockaddrport(&vsge->addr);
 
 	/* Process realserver queue */
-	LIST_FOREACH(vs->rs, rs, e) {
+	list_for_each_entry(rs, &vs->rs, e_list) {
 		if (rs->alive) {
 			/* Setting IPVS drule */
 			ipvs_set_drule(IP_VS_SO_SET_DELDEST, &drule, rs);
@@ -653,9 +643,10 @@ vsd_equal(real_server_t *rs, struct ip_vs_dest_entry_app *entry)
 static void
 ipvs_update_vs_stats(virtual_server_t *vs, uint32_t fwmark, union nf_inet_addr *nfaddr, uint16_t port)
 {
-	element e;
 	struct ip_vs_get_dests_app *dests = NULL;
 	real_server_t *rs;
+	hlist_head_t *head;
+	hlist_node_t *pos;
 	unsigned int i;
 	ipvs_service_entry_t *serv;
 
@@ -687,13 +678,15 @@ ipvs_update_vs_stats(virtual_server_t *vs, uint32_t fwmark, union nf_inet_addr *
 		if (vs->s_svr && vsd_equal(vs->s_svr, &dests->user.entrytable[i]))
 			rs = vs->s_svr;
 		else {
-			/* Search for a match in the list of real servers */
-			for (e = LIST_HEAD(vs->rs); e; ELEMENT_NEXT(e)) {
-				rs = ELEMENT_DATA(e);
+			/* Look the real server up in the index */
+			head = rs_hash_bucket(vs, dests->user.entrytable[i].af,
+					      &dests->user.entrytable[i].nf_addr,
+					      dests->user.entrytable[i].user.port);
+			hlist_for_each_entry(rs, pos, head, e_hash) {
 				if (vsd_equal(rs, &dests->user.entrytable[i]))
 					break;
 			}
-			if (!e)
+			if (!pos)
 				rs = NULL;
 		}
 
@@ -722,7 +715,7 @@ ipvs_update_vs_stats(virtual_server_t *vs, uint32_t fwmark, union nf_inet_addr *
 void
 ipvs_update_stats(virtual_server_t *vs)
 {
-	element e, ge;
+	element ge;
 	virtual_server_group_entry_t *vsg_entry;
 	uint32_t addr_ip;
 	uint16_t port;
@@ -742,8 +735,7 @@ ipvs_update_stats(virtual_server_t *vs)
 		vs->s_svr->activeconns =
 			vs->s_svr->inactconns = vs->s_svr->persistconns = 0;
 	}
-	for (e = LIST_HEAD(vs->rs); e; ELEMENT_NEXT(e)) {
-		rs = ELEMENT_DATA(e);
+	list_for_each_entry(rs, &vs->rs, e_list) {
 		memset(&rs->stats, 0, sizeof(rs->stats));
 		rs->activeconns = rs->inactconns = rs->persistconns = 0;
 	}
@@ -35,17 +35,20 @@
 #include "global_data.h"
 #include "smtp.h"
 #include "check_daemon.h"
+#include "bitops.h"
+#include "list_diff.h"
+#ifdef _WITH_CHECKER_THREADS_
+#include "check_workers.h"
+#endif
 
 /* Returns the sum of all alive RS weight in a virtual server. */
 static unsigned long
 weigh_live_realservers(virtual_server_t * vs)
 {
-	element e;
 	real_server_t *svr;
 	long count = 0;
 
-	for (e = LIST_HEAD(vs->rs); e; ELEMENT_NEXT(e)) {
-		svr = ELEMENT_DATA(e);
+	list_for_each_entry(svr, &vs->rs, e_list) {
 		if (ISALIVE(svr))
 			count += svr->weight;
 	}
@@ -183,16 +186,15 @@ do_rs_notifies(virtual_server_t* vs, real_server_t* rs, bool stopping)
 
 /* Remove a realserver IPVS rule */
 static void
-clear_service_rs(virtual_server_t * vs, list l, bool stopping)
+clear_service_rs(virtual_server_t * vs, list_head_t *l, bool stopping)
 {
-	element e;
 	real_server_t *rs;
 	long weight_sum;
 	long threshold = vs->quorum - vs->hysteresis;
 	bool sav_inhibit;
 	smtp_rs rs_info = { .vs = vs };
 
-	LIST_FOREACH(l, rs, e) {
+	list_for_each_entry(rs, l, e_list) {
 		if (rs->set || stopping)
 			log_message(LOG_INFO, "%s %sservice %s from VS %s",
 					stopping ? "Shutting down" : "Removing",
@@ -270,7 +272,7 @@ clear_service_vs(virtual_server_t * vs, bool stopping)
 
 	/* Even if the sorry server was configured, if we are using
 	 * inhibit_on_failure, then real servers may be configured. */
-	clear_service_rs(vs, vs->rs, stopping);
+	clear_service_rs(vs, &vs->rs, stopping);
 
 	/* The above will handle Omega case for VS as well. */
 
@@ -301,10 +303,9 @@ clear_services(void)
 static bool
 init_service_rs(virtual_server_t * vs)
 {
-	element e;
 	real_server_t *rs;
 
-	LIST_FOREACH(vs->rs, rs, e) {
+	list_for_each_entry(rs, &vs->rs, e_list) {
 		if (rs->reloaded) {
 			if (rs->iweight != rs->pweight)
 				update_svr_wgt(rs->iweight, vs, rs, false);
@@ -366,13 +367,12 @@ sync_service_vsg(virtual_server_t * vs)
 static void
 perform_quorum_state(virtual_server_t *vs, bool add)
 {
-	element e;
 	real_server_t *rs;
 
 	log_message(LOG_INFO, "%s the pool for VS %s"
 			    , add?"Adding alive servers to":"Removing alive servers from"
 			    , FMT_VS(vs));
-	LIST_FOREACH(vs->rs, rs, e) {
+	list_for_each_entry(rs, &vs->rs, e_list) {
 		if (!ISALIVE(rs)) /* We only handle alive servers */
 			continue;
 // ??? The following seems unnecessary
@@ -603,8 +603,8 @@ set_checker_state(checker_t *checker, bool up)
 }
 
 /* Update checker's state */
-void
-update_svr_checker_state(bool alive, checker_t *checker)
+static void
+do_update_svr_checker_state(bool alive, checker_t *checker)
 {
 	if (checker->is_up == alive) {
 		if (!checker->has_run) {
@@ -635,20 +635,69 @@ update_svr_checker_state(bool alive, checker_t *checker)
 	set_checker_state(checker, alive);
 }
 
-/* Check if a vsg entry is in new data */
-static virtual_server_group_entry_t *
-vsge_exist(virtual_server_group_entry_t *vsg_entry, list l)
+void
+update_svr_checker_state(bool alive, checker_t *checker)
 {
-	element e;
-	virtual_server_group_entry_t *vsge;
+	update_svr_checker_state_alert(alive, checker, NULL);
+}
 
-	for (e = LIST_HEAD(l); e; ELEMENT_NEXT(e)) {
-		vsge = ELEMENT_DATA(e);
-		if (VSGE_ISEQ(vsg_entry, vsge))
-			return vsge;
-	}
+/* Update checker's state, and send the SMTP alert if the checker's state
+ * changes, and either the real server's state changes or checker emails
+ * are not disabled */
+void
+update_svr_checker_state_alert(bool alive, checker_t *checker, const char *alert)
+{
+	bool checker_was_up;
+	bool rs_was_alive;
 
-	return NULL;
+#ifdef _WITH_CHECKER_THREADS_
+	/* On a worker thread, hand the change to the main thread */
+	if (checker_worker_post_state(alive, checker, alert))
+		return;
+#endif
+
+	checker_was_up = checker->is_up;
+	rs_was_alive = checker->rs->alive;
+
+	do_update_svr_checker_state(alive, checker);
+
+	if (alert && checker->rs->smtp_alert && checker_was_up != alive &&
+	    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
+		smtp_alert(SMTP_MSG_RS, checker, NULL, alert);
+}
+
+/* Identity hash of a virtual server or group entry address */
+static uint64_t
+sockaddr_diff_hash(const struct sockaddr_storage *addr)
+{
+	if (addr->ss_family == AF_INET6)
+		return mem_hash(&((const struct sockaddr_in6 *)addr)->sin6_addr, sizeof(struct in6_addr)) ^
+		       ((const struct sockaddr_in6 *)addr)->sin6_port;
+
+	return (uint64_t)((const struct sockaddr_in *)addr)->sin_addr.s_addr << 16 ^
+	       ((const struct sockaddr_in *)addr)->sin_port ^
+	       (uint64_t)addr->ss_family << 48;
+}
+
+static uint64_t
+vsge_diff_hash(const void *data)
+{
+	const virtual_server_group_entry_t *vsge = data;
+
+	return sockaddr_diff_hash(&vsge->addr) ^ (uint64_t)vsge->range << 32 ^ vsge->vfwmark;
+}
+
+static bool
+vsge_diff_match(const void *old_data, const void *new_data)
+{
+	return VSGE_ISEQ((const virtual_server_group_entry_t *)old_data, (const virtual_server_group_entry_t *)new_data);
+}
+
+/* Check if a vsg entry is in new data */
+static virtual_server_group_entry_t *
+vsge_exist(virtual_server_group_entry_t *vsg_entry, list_diff_t *diff)
+{
+	return list_diff_find(diff, vsg_entry);
 }
 
 /* Clear the diff vsge of old group */
@@ -657,10 +706,16 @@ clear_diff_vsge(list old, list new, virtual_server_t * old_vs)
 {
 	virtual_server_group_entry_t *vsge, *new_vsge;
 	element e;
+	list_diff_t *diff;
+
+	if (LIST_ISEMPTY(old))
+		return;
+
+	diff = alloc_list_diff(vsge_diff_hash, vsge_diff_match, new, NULL);
 
 	for (e = LIST_HEAD(old); e; ELEMENT_NEXT(e)) {
 		vsge = ELEMENT_DATA(e);
-		new_vsge = vsge_exist(vsge, new);
+		new_vsge = vsge_exist(vsge, diff);
 		if (new_vsge) {
 			new_vsge->tcp_alive = vsge->tcp_alive;
 			new_vsge->udp_alive = vsge->udp_alive;
@@ -679,6 +734,8 @@ clear_diff_vsge(list old, list new, virtual_server_t * old_vs)
 			ipvs_group_remove_entry(old_vs, vsge);
 		}
 	}
+
+	free_list_diff(&diff);
 }
 
 /* Clear the diff vsg of the old vs */
@@ -693,38 +750,42 @@ clear_diff_vsg(virtual_server_t * old_vs, virtual_server_t * new_vs)
 	clear_diff_vsge(old->vfwmark, new->vfwmark, old_vs);
 }
 
-/* Check if a vs exist in new data and returns pointer to it */
-static virtual_server_t*
-vs_exist(virtual_server_t * old_vs)
+/* Only fields compared by VS_ISEQ() may contribute to the hash */
+static uint64_t
+vs_diff_hash(const void *data)
 {
-	element e;
-	list l = check_data->vs;
-	virtual_server_t *vs;
+	const virtual_server_t *vs = data;
 
-	if (LIST_ISEMPTY(l))
-		return NULL;
+	return sockaddr_diff_hash(&vs->addr) ^ (uint64_t)vs->vfwmark << 24 ^ (uint64_t)vs->service_type << 56;
+}
 
-	for (e = LIST_HEAD(l); e; ELEMENT_NEXT(e)) {
-		vs = ELEMENT_DATA(e);
-		if (VS_ISEQ(old_vs, vs))
-			return vs;
-	}
+static bool
+vs_diff_match(const void *old_data, const void *new_data)
+{
+	return VS_ISEQ((const virtual_server_t *)old_data, (const virtual_server_t *)new_data);
+}
 
-	return NULL;
+/* Check if a vs exist in new data and returns pointer to it */
+static virtual_server_t*
+vs_exist(virtual_server_t * old_vs, list_diff_t *diff)
+{
+	return list_diff_find(diff, old_vs);
 }
 
 /* Check if rs is in new vs data */
 static real_server_t *
-rs_exist(real_server_t * old_rs, list l)
+rs_exist(real_server_t * old_rs, virtual_server_t *vs)
 {
-	element e;
 	real_server_t *rs;
+	hlist_node_t *pos;
+	hlist_head_t *head;
 
-	if (LIST_ISEMPTY(l))
-		return NULL;
+	if (old_rs->addr.ss_family == AF_INET6)
+		head = rs_hash_bucket(vs, AF_INET6, &((struct sockaddr_in6 *)&old_rs->addr)->sin6_addr, ((struct sockaddr_in6 *)&old_rs->addr)->sin6_port);
+	else
+		head = rs_hash_bucket(vs, AF_INET, &((struct sockaddr_in *)&old_rs->addr)->sin_addr, ((struct sockaddr_in *)&old_rs->addr)->sin_port);
 
-	for (e = LIST_HEAD(l); e; ELEMENT_NEXT(e)) {
-		rs = ELEMENT_DATA(e);
+	hlist_for_each_entry(rs, pos, head, e_hash) {
 		if (RS_ISEQ(rs, old_rs))
 			return rs;
 	}
@@ -733,92 +794,112 @@ rs_exist(real_server_t * old_rs, list l)
 }
 
 static void
-migrate_checkers(real_server_t *old_rs, real_server_t *new_rs, list old_checkers_queue)
+migrate_checkers(real_server_t *old_rs, real_server_t *new_rs)
 {
-	list l;
-	element e, e1;
 	checker_t *old_c, *new_c;
 
-	l = alloc_list(NULL, NULL);
-	LIST_FOREACH(old_checkers_queue, old_c, e) {
-		if (old_c->rs == old_rs)
-			list_add(l, old_c);
-	}
+	if (list_empty(&old_rs->checkers))
+		return;
 
-	if (!LIST_ISEMPTY(l)) {
-		LIST_FOREACH(checkers_queue, new_c, e) {
-			if (new_c->rs != new_rs || !new_c->compare)
-				continue;
-			LIST_FOREACH(l, old_c, e1) {
-				if (old_c->compare == new_c->compare && new_c->compare(old_c, new_c)) {
-					/* Update status if different */
-					if (old_c->is_up != new_c->is_up)
-						set_checker_state(new_c, old_c->is_up);
+	list_for_each_entry(new_c, &new_rs->checkers, rs_list) {
+		if (!new_c->compare)
+			continue;
+		list_for_each_entry(old_c, &old_rs->checkers, rs_list) {
+			if (old_c->compare == new_c->compare && new_c->compare(old_c, new_c)) {
+				/* Update status if different */
+				if (old_c->is_up != new_c->is_up)
+					set_checker_state(new_c, old_c->is_up);
 
-					/* Transfer some other state flags */
-					new_c->has_run = old_c->has_run;
-					new_c->retry_it = old_c->retry_it;
+				/* Transfer some other state flags */
+				new_c->has_run = old_c->has_run;
+				new_c->retry_it = old_c->retry_it;
 
-					break;
-				}
+				break;
 			}
 		}
-
-		if (!new_rs->num_failed_checkers)
-			SET_ALIVE(new_rs);
 	}
 
-	free_list(&l);
+	if (!new_rs->num_failed_checkers)
+		SET_ALIVE(new_rs);
 }
 
-/* Clear the diff rs of the old vs */
+/* Copy the state of a rs to its replacement */
 static void
-clear_diff_rs(virtual_server_t *old_vs, virtual_server_t *new_vs, list old_checkers_queue)
+reload_rs(real_server_t *old_rs, real_server_t *new_rs)
+{
+	/*
+	 * We reflect the previous alive
+	 * flag value to not try to set
+	 * already set IPVS rule.
+	 */
+	if (new_rs->alive)
+		new_rs->alive = old_rs->alive;
+	new_rs->set = old_rs->set;
+	new_rs->weight = old_rs->weight;
+	new_rs->pweight = old_rs->iweight;
+	new_rs->reloaded = true;
+
+	/*
+	 * We must migrate the state of the old checkers.
+	 * If we do not, the new RS is in a state where it’s reported
+	 * as down with no check failed. As a result, the server will never
+	 * be put back up when it’s alive again in check_tcp.c#83 because
+	 * of the check that put a rs up only if it was not previously up.
+	 * For alpha mode checkers, if it was up, we don't need another
+	 * success to say it is now up.
+	 */
+	migrate_checkers(old_rs, new_rs);
+}
+
+/* The real servers of an unchanged virtual_server block are the same
+ * ones in the same order, so there is nothing to remove and their
+ * state can be copied without looking them up. Returns false, and
+ * changes nothing, if they unexpectedly differ. */
+static bool
+carry_over_rs(virtual_server_t *old_vs, virtual_server_t *new_vs)
 {
-	element e;
 	real_server_t *rs, *new_rs;
-	list rs_to_remove;
 
-	/* If old vs didn't own rs then nothing return */
-	if (LIST_ISEMPTY(old_vs->rs))
-		return;
+	new_rs = list_first_entry(&new_vs->rs, real_server_t, e_list);
+	list_for_each_entry(rs, &old_vs->rs, e_list) {
+		if (&new_rs->e_list == &new_vs->rs || !RS_ISEQ(rs, new_rs))
+			return false;
+		new_rs = list_entry(new_rs->e_list.next, real_server_t, e_list);
+	}
+	if (&new_rs->e_list != &new_vs->rs)
+		return false;
+
+	new_rs = list_first_entry(&new_vs->rs, real_server_t, e_list);
+	list_for_each_entry(rs, &old_vs->rs, e_list) {
+		reload_rs(rs, new_rs);
+		new_rs = list_entry(new_rs->e_list.next, real_server_t, e_list);
+	}
+
+	return true;
+}
+
+/* Clear the diff rs of the old vs */
+static void
+clear_diff_rs(virtual_server_t *old_vs, virtual_server_t *new_vs)
+{
+	real_server_t *rs, *rs_tmp, *new_rs;
+	LH_LIST_HEAD(rs_to_remove);
 
 	/* remove RS from old vs which are not found in new vs */
-	rs_to_remove = alloc_list (NULL, NULL);
-	LIST_FOREACH(old_vs->rs, rs, e) {
-		new_rs = rs_exist(rs, new_vs->rs);
+	list_for_each_entry_safe(rs, rs_tmp, &old_vs->rs, e_list) {
+		new_rs = rs_exist(rs, new_vs);
 		if (!new_rs) {
 			log_message(LOG_INFO, "service %s no longer exist"
 					    , FMT_RS(rs, old_vs));
 
-			list_add (rs_to_remove, rs);
-		} else {
-			/*
-			 * We reflect the previous alive
-			 * flag value to not try to set
-			 * already set IPVS rule.
-			 */
-			if (new_rs->alive)
-				new_rs->alive = rs->alive;
-			new_rs->set = rs->set;
-			new_rs->weight = rs->weight;
-			new_rs->pweight = rs->iweight;
-			new_rs->reloaded = true;
-
-			/*
-			 * We must migrate the state of the old checkers.
-			 * If we do not, the new RS is in a state where it’s reported
-			 * as down with no check failed. As a result, the server will never
-			 * be put back up when it’s alive again in check_tcp.c#83 because
-			 * of the check that put a rs up only if it was not previously up.
-			 * For alpha mode checkers, if it was up, we don't need another
-			 * success to say it is now up.
-			 */
-			migrate_checkers(rs, new_rs, old_checkers_queue);
-		}
+			list_move_tail(&rs->e_list, &rs_to_remove);
+		} else
+			reload_rs(rs, new_rs);
 	}
-	clear_service_rs(old_vs, rs_to_remove, false);
-	free_list(&rs_to_remove);
+	clear_service_rs(old_vs, &rs_to_remove, false);
+
+	/* The old vs still owns the removed real servers */
+	list_splice(&rs_to_remove, &old_vs->rs);
 }
 
 /* clear sorry server, but only if changed */
@@ -857,10 +938,14 @@ clear_diff_s_srv(virtual_server_t *old_vs, real_server_t *new_rs)
 /* When reloading configuration, remove negative diff entries
  * and copy status of existing entries to the new ones */
 void
-clear_diff_services(list old_checkers_queue)
+clear_diff_services(void)
 {
 	element e;
 	virtual_server_t *vs, *new_vs;
+	unsigned num_unchanged = 0;
+	list_diff_t *diff;
+
+	diff = alloc_list_diff(vs_diff_hash, vs_diff_match, check_data->vs, NULL);
 
 	/* Remove diff entries from previous IPVS rules */
 	LIST_FOREACH(old_check_data->vs, vs, e) {
@@ -868,7 +953,7 @@ clear_diff_services(list old_checkers_queue)
 		 * Try to find this vs into the new conf data
 		 * reloaded.
 		 */
-		new_vs = vs_exist(vs);
+		new_vs = vs_exist(vs, diff);
 		if (!new_vs) {
 			if (vs->vsgname)
 				log_message(LOG_INFO, "Removing Virtual Server Group [%s]", vs->vsgname);
@@ -892,10 +977,25 @@ clear_diff_services(list old_checkers_queue)
 			/* omega = false must not prevent the notifiers from being called,
 			   because the VS still exists in new configuration */
 			vs->omega = true;
-			clear_diff_rs(vs, new_vs, old_checkers_queue);
+			if (config_block_unchanged(&vs->conf_block, &new_vs->conf_block) &&
+			    carry_over_rs(vs, new_vs))
+				num_unchanged++;
+			else {
+				if (__test_bit(LOG_DETAIL_BIT, &debug)) {
+					char loc_buf[CONFIG_BLOCK_LOCATION_LEN];
+
+					log_message(LOG_INFO, "Virtual server %s configuration at %s has changed", FMT_VS(new_vs), config_block_location(&new_vs->conf_block, loc_buf, sizeof(loc_buf)));
+				}
+				clear_diff_rs(vs, new_vs);
+			}
 			clear_diff_s_srv(vs, new_vs->s_svr);
 		}
 	}
+
+	free_list_diff(&diff);
+
+	if (!LIST_ISEMPTY(check_data->vs))
+		log_message(LOG_INFO, "%u of %u virtual servers unchanged by reload", num_unchanged, LIST_SIZE(check_data->vs));
 }
 
 void
@@ -916,7 +1016,7 @@ link_vsg_to_vs(void)
 		vs = ELEMENT_DATA(e);
 
 		if (vs->vsgname) {
-			vs->vsg = ipvs_get_group_by_name(vs->vsgname, check_data->vs_group);
+			vs->vsg = ipvs_get_group_by_name(vs->vsgname, check_data->vs_group_index);
 			if (!vs->vsg) {
 				log_message(LOG_INFO, "Virtual server group %s specified but not configured - ignoring virtual server %s", vs->vsgname, FMT_VS(vs));
 				free_vs_checkers(vs);
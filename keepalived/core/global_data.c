@@ -151,6 +151,7 @@ data_t *
 alloc_global_data(void)
 {
 	data_t *new;
+	int i;
 
 	if (global_data)
 		return global_data;
@@ -220,6 +221,11 @@ alloc_global_data(void)
 #endif
 #endif
 
+	for (i = 0; i <= LOG_DEBUG; i++) {
+		new->log_rate_limit[i].rate = LOG_RATE_DEFAULT;
+		new->log_rate_limit[i].burst = LOG_BURST_DEFAULT;
+	}
+
 	return new;
 }
 
@@ -361,6 +367,7 @@ dump_global_data(FILE *fp, data_t * data)
 #ifdef _WITH_VRRP_
 	char buf[64];
 #endif
+	int i;
 
 	if (!data)
 		return;
@@ -531,6 +538,9 @@ dump_global_data(FILE *fp, data_t * data)
 #ifdef _WITH_LVS_
 	conf_write(fp, " Checker process priority = %d", data->checker_process_priority);
 	conf_write(fp, " Checker don't swap = %s", data->checker_no_swap ? "true" : "false");
+#ifdef _WITH_CHECKER_THREADS_
+	conf_write(fp, " Checker threads = %u", data->checker_threads);
+#endif
 #ifdef _HAVE_SCHED_RT_
 	conf_write(fp, " Checker realtime priority = %u", data->checker_realtime_priority);
 #if HAVE_DECL_RLIMIT_RTTIME
@@ -597,4 +607,17 @@ dump_global_data(FILE *fp, data_t * data)
 	conf_write(fp, " rx_bufs_multiples = %u", global_data->vrrp_rx_bufs_multiples);
 	conf_write(fp, " umask = 0%o", umask_val);
 #endif
+	conf_write(fp, " timer_wheel = %s", global_data->timer_wheel ? "true" : "false");
+	conf_write(fp, " timer_slack = %ums", global_data->timer_slack);
+#ifdef _WITH_ASYNC_LOG_
+	conf_write(fp, " async_log = %u", global_data->async_log);
+#endif
+	conf_write(fp, " script_spawner = %s", data->script_spawner ? "true" : "false");
+	conf_write(fp, " script_vfork = %s", data->script_vfork ? "true" : "false");
+	for (i = 0; i <= LOG_DEBUG; i++) {
+		if (data->log_rate_limit[i].rate)
+			conf_write(fp, " log_rate_limit %s = %u/s, burst %u", log_priority_names[i], data->log_rate_limit[i].rate, data->log_rate_limit[i].burst);
+		else
+			conf_write(fp, " log_rate_limit %s = none", log_priority_names[i]);
+	}
 }
@@ -35,6 +35,7 @@
 #include <sched.h>
 #endif
 #include <strings.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -53,6 +54,9 @@
 #include "vrrp_firewall.h"
 #endif
 #include "memory.h"
+#ifdef _WITH_CHECKER_THREADS_
+#include "check_workers.h"
+#endif
 
 #if HAVE_DECL_CLONE_NEWNET
 #include "namespaces.h"
@@ -924,6 +928,20 @@ checker_no_swap_handler(__attribute__((unused)) vector_t *strvec)
 {
 	global_data->checker_no_swap = true;
 }
+#ifdef _WITH_CHECKER_THREADS_
+static void
+checker_threads_handler(vector_t *strvec)
+{
+	unsigned threads;
+
+	if (!read_unsigned_strvec(strvec, 1, &threads, 0, CHECKER_MAX_THREADS, false)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "checker_threads '%s' must be in [0, %d] - ignoring", FMT_STR_VSLOT(strvec, 1), CHECKER_MAX_THREADS);
+		return;
+	}
+
+	global_data->checker_threads = threads;
+}
+#endif
 #ifdef _HAVE_SCHED_RT_
 static void
 checker_rt_priority_handler(vector_t *strvec)
@@ -1476,6 +1494,117 @@ umask_handler(vector_t *strvec)
 	update_log_file_perms(umask_bits);
 #endif
 }
+static void
+timer_wheel_handler(vector_t *strvec)
+{
+	int res = true;
+
+	if (vector_size(strvec) >= 2) {
+		res = check_true_false(strvec_slot(strvec,1));
+		if (res < 0) {
+			report_config_error(CONFIG_GENERAL_ERROR, "Invalid value '%s' for global timer_wheel specified", FMT_STR_VSLOT(strvec, 1));
+			return;
+		}
+	}
+
+	global_data->timer_wheel = res;
+}
+static void
+timer_slack_handler(vector_t *strvec)
+{
+	unsigned slack;
+
+	if (!read_unsigned_strvec(strvec, 1, &slack, 0, TIMER_MAX_SLACK, false)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "timer_slack '%s' must be in [0, %u] milliseconds - ignoring", FMT_STR_VSLOT(strvec, 1), TIMER_MAX_SLACK);
+		return;
+	}
+
+	global_data->timer_slack = slack;
+}
+#ifdef _WITH_ASYNC_LOG_
+static void
+async_log_handler(vector_t *strvec)
+{
+	unsigned slots = ASYNC_LOG_DEFAULT_SLOTS;
+
+	if (vector_size(strvec) >= 2 &&
+	    !read_unsigned_strvec(strvec, 1, &slots, ASYNC_LOG_MIN_SLOTS, ASYNC_LOG_MAX_SLOTS, false)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "async_log '%s' must be in [%u, %u] - ignoring", FMT_STR_VSLOT(strvec, 1), ASYNC_LOG_MIN_SLOTS, ASYNC_LOG_MAX_SLOTS);
+		return;
+	}
+
+	global_data->async_log = slots;
+}
+#endif
+static void
+script_spawner_handler(vector_t *strvec)
+{
+	int res = true;
+
+	if (vector_size(strvec) >= 2) {
+		res = check_true_false(strvec_slot(strvec,1));
+		if (res < 0) {
+			report_config_error(CONFIG_GENERAL_ERROR, "Invalid value '%s' for global script_spawner specified", FMT_STR_VSLOT(strvec, 1));
+			return;
+		}
+	}
+
+	global_data->script_spawner = res;
+}
+static void
+script_vfork_handler(vector_t *strvec)
+{
+	int res = true;
+
+	if (vector_size(strvec) >= 2) {
+		res = check_true_false(strvec_slot(strvec,1));
+		if (res < 0) {
+			report_config_error(CONFIG_GENERAL_ERROR, "Invalid value '%s' for global script_vfork specified", FMT_STR_VSLOT(strvec, 1));
+			return;
+		}
+	}
+
+	global_data->script_vfork = res;
+}
+static void
+log_rate_limit_handler(vector_t *strvec)
+{
+	log_rate_limit_t limit = { .burst = LOG_BURST_DEFAULT };
+	int priority = -1;
+	unsigned i = 1;
+	int p;
+
+	for (p = 0; p <= LOG_DEBUG; p++) {
+		if (vector_size(strvec) > 1 && !strcmp(strvec_slot(strvec, 1), log_priority_names[p])) {
+			priority = p;
+			i++;
+			break;
+		}
+	}
+
+	if (vector_size(strvec) <= i) {
+		report_config_error(CONFIG_GENERAL_ERROR, "log_rate_limit requires a rate");
+		return;
+	}
+
+	if (!read_unsigned_strvec(strvec, i, &limit.rate, 0, UINT_MAX, false)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "log_rate_limit rate '%s' is invalid - ignoring", FMT_STR_VSLOT(strvec, i));
+		return;
+	}
+
+	if (vector_size(strvec) > i + 1 &&
+	    !read_unsigned_strvec(strvec, i + 1, &limit.burst, 1, UINT_MAX, false)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "log_rate_limit burst '%s' is invalid - ignoring", FMT_STR_VSLOT(strvec, i + 1));
+		return;
+	}
+
+	if (priority >= 0)
+		global_data->log_rate_limit[priority] = limit;
+	else {
+		for (p = 0; p <= LOG_DEBUG; p++)
+			global_data->log_rate_limit[p] = limit;
+	}
+}
 
 void
 init_global_keywords(bool global_active)
@@ -1564,6 +1693,9 @@ init_global_keywords(bool global_active)
 	install_keyword("lvs_notify_fifo_script", &lvs_notify_fifo_script);
 	install_keyword("checker_priority", &checker_prio_handler);
 	install_keyword("checker_no_swap", &checker_no_swap_handler);
+#ifdef _WITH_CHECKER_THREADS_
+	install_keyword("checker_threads", &checker_threads_handler);
+#endif
 #ifdef _HAVE_SCHED_RT_
 	install_keyword("checker_rt_priority", &checker_rt_priority_handler);
 #if HAVE_DECL_RLIMIT_RTTIME == 1
@@ -1628,4 +1760,12 @@ init_global_keywords(bool global_active)
 	install_keyword("vrrp_rx_bufs_multiplier", &vrrp_rx_bufs_multiplier_handler);
 #endif
 	install_keyword("umask", &umask_handler);
+	install_keyword("timer_wheel", &timer_wheel_handler);
+	install_keyword("timer_slack", &timer_slack_handler);
+#ifdef _WITH_ASYNC_LOG_
+	install_keyword("async_log", &async_log_handler);
+#endif
+	install_keyword("log_rate_limit", &log_rate_limit_handler);
+	install_keyword("script_spawner", &script_spawner_handler);
+	install_keyword("script_vfork", &script_vfork_handler);
 }
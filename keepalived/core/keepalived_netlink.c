@@ -1204,6 +1204,14 @@ netlink_parse_info(int (*filter) (struct sockaddr_nl *, struct nlmsghdr *),
 		} while (len < 0 && errno == EINTR);
 
 		if (len < 0) {
+			/* An overrun is only reported once, and there can still be
+			 * messages queued, which the edge triggered monitor socket
+			 * would not be told about again */
+			if (errno == ENOBUFS) {
+				log_message(LOG_INFO, "Netlink: Receive buffer overrun on %s socket - (%m)", nl == &nl_kernel ? "monitor" : "cmd");
+				log_message(LOG_INFO, "  - increase the relevant netlink_rcv_bufs global parameter and/or set force");
+				continue;
+			}
 			ret = -1;
 			break;
 		}
@@ -1244,12 +1252,18 @@ netlink_parse_info(int (*filter) (struct sockaddr_nl *, struct nlmsghdr *),
 			       "Netlink: Sender address length error: length %d",
 			       msg.msg_namelen);
 			ret = -1;
+			/* The edge triggered monitor socket must be read until
+			 * there is nothing left, so skip the bad messages */
+			if (read_all)
+				continue;
 			break;
 		}
 
 		for (h = (struct nlmsghdr *) nlmsg_buf; NLMSG_OK(h, (size_t)len); h = NLMSG_NEXT(h, len)) {
 			/* Finish off reading. */
 			if (h->nlmsg_type == NLMSG_DONE) {
+				if (read_all)
+					continue;
 				FREE(nlmsg_buf);
 				return ret;
 			}
@@ -1273,13 +1287,18 @@ netlink_parse_info(int (*filter) (struct sockaddr_nl *, struct nlmsghdr *),
 				if (h->nlmsg_len < NLMSG_LENGTH(sizeof (struct nlmsgerr))) {
 					log_message(LOG_INFO,
 					       "Netlink: error: message truncated");
+					ret = -1;
+					if (read_all)
+						continue;
 					FREE(nlmsg_buf);
-					return -1;
+					return ret;
 				}
 
 				if (n && (err->error == -EEXIST) &&
 				    ((n->nlmsg_type == RTM_NEWROUTE) ||
 				     (n->nlmsg_type == RTM_NEWADDR))) {
+					if (read_all)
+						continue;
 					FREE(nlmsg_buf);
 					return 0;
 				}
@@ -1290,7 +1309,7 @@ netlink_parse_info(int (*filter) (struct sockaddr_nl *, struct nlmsghdr *),
 				 * in the same CIDR are deleted */
 				if (n && err->error == -EADDRNOTAVAIL &&
 				    n->nlmsg_type == RTM_DELADDR) {
-					if (!(h->nlmsg_flags & NLM_F_MULTI)) {
+					if (!(h->nlmsg_flags & NLM_F_MULTI) && !read_all) {
 						FREE(nlmsg_buf);
 						return 0;
 					}
@@ -1305,8 +1324,11 @@ netlink_parse_info(int (*filter) (struct sockaddr_nl *, struct nlmsghdr *),
 					       get_nl_msg_type(err->msg.nlmsg_type), err->msg.nlmsg_type,
 					       err->msg.nlmsg_seq, err->msg.nlmsg_pid);
 
+				ret = -1;
+				if (read_all)
+					continue;
 				FREE(nlmsg_buf);
-				return -1;
+				return ret;
 			}
 
 #ifdef _WITH_VRRP_
@@ -1344,6 +1366,8 @@ netlink_parse_info(int (*filter) (struct sockaddr_nl *, struct nlmsghdr *),
 			       len);
 
 			ret = -1;
+			if (read_all)
+				continue;
 			break;
 		}
 	}
@@ -2207,10 +2231,10 @@ kernel_netlink(thread_t * thread)
 {
 	nl_handle_t *nl = THREAD_ARG(thread);
 
+	/* The thread is persistent and edge triggered, and
+	 * netlink_parse_info() reads until there is nothing left */
 	if (thread->type != THREAD_READ_TIMEOUT)
 		netlink_parse_info(netlink_broadcast_filter, nl, NULL, true);
-	nl->thread = thread_add_read(master, kernel_netlink, nl, nl->fd,
-				      TIMER_NEVER);
 	return 0;
 }
 
@@ -2283,7 +2307,7 @@ kernel_netlink_init(void)
 	/* If the netlink kernel fd is already open, just register a read thread.
 	 * This will happen at reload. */
 	if (nl_kernel.fd > 0) {
-		nl_kernel.thread = thread_add_read(master, kernel_netlink, &nl_kernel, nl_kernel.fd, TIMER_NEVER);
+		nl_kernel.thread = thread_add_persistent_read(master, kernel_netlink, &nl_kernel, nl_kernel.fd, TIMER_NEVER, true);
 		return;
 	}
 
@@ -2311,8 +2335,8 @@ kernel_netlink_init(void)
 	if (nl_kernel.fd > 0) {
 		//注册netlink广播消息处理
 		log_message(LOG_INFO, "Registering Kernel netlink reflector");
-		nl_kernel.thread = thread_add_read(master, kernel_netlink, &nl_kernel, nl_kernel.fd,
-						   TIMER_NEVER);
+		nl_kernel.thread = thread_add_persistent_read(master, kernel_netlink, &nl_kernel, nl_kernel.fd,
+							      TIMER_NEVER, true);
 	} else
 		log_message(LOG_INFO, "Error while registering Kernel netlink reflector channel");
 
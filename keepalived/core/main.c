@@ -39,6 +39,7 @@
 #include <getopt.h>
 #include <linux/version.h>
 #include <ctype.h>
+#include <limits.h>
 
 #include "main.h"
 #include "global_data.h"
@@ -571,6 +572,23 @@ propagate_signal(__attribute__((unused)) void *v, int sig)
 	else if (sig == SIGHUP && running_vrrp())
 		start_vrrp_child();
 #endif
+#if defined _WITH_THREAD_STATS_ || defined _WITH_ALLOC_PROFILE_
+	/* Checker and BFD processes only report scheduler and allocation statistics */
+	if (sig == SIGUSR2
+#ifdef _WITH_ALLOC_PROFILE_
+	    || sig == SIGALLOC
+#endif
+			   ) {
+#ifdef _WITH_LVS_
+		if (checkers_child > 0)
+			kill(checkers_child, sig);
+#endif
+#ifdef _WITH_BFD_
+		if (bfd_child > 0)
+			kill(bfd_child, sig);
+#endif
+	}
+#endif
 #ifdef _WITH_LVS_
 	if (sig == SIGHUP) {
 		if (checkers_child > 0)
@@ -810,6 +828,9 @@ signal_init(void)
 	signal_set(SIGUSR2, propagate_signal, NULL);
 #ifdef _WITH_JSON_
 	signal_set(SIGJSON, propagate_signal, NULL);
+#endif
+#ifdef _WITH_ALLOC_PROFILE_
+	signal_set(SIGALLOC, propagate_signal, NULL);
 #endif
 	signal_set(SIGINT, sigend, NULL);
 	signal_set(SIGTERM, sigend, NULL);
@@ -1182,6 +1203,9 @@ usage(const char *prog)
 	fprintf(stderr, "      --signum=SIGFUNC         Return signal number for STOP, RELOAD, DATA, STATS"
 #ifdef _WITH_JSON_
 								", JSON"
+#endif
+#ifdef _WITH_ALLOC_PROFILE_
+								", ALLOC"
 #endif
 								"\n");
 	fprintf(stderr, "  -t, --config-test[=LOG_FILE] Check the configuration for obvious errors, output to\n"
@@ -1189,6 +1213,12 @@ usage(const char *prog)
 #ifdef _WITH_PERF_
 	fprintf(stderr, "      --perf[=PERF_TYPE]       Collect perf data, PERF_TYPE=all, run(default) or end\n");
 #endif
+#ifdef _WITH_THREAD_TRACE_
+	fprintf(stderr, "      --thread-trace=DIR       Record scheduler traces of each process in DIR\n");
+#endif
+#ifdef _WITH_ALLOC_PROFILE_
+	fprintf(stderr, "      --alloc-profile[=BYTES]  Sample allocations, one per BYTES allocated on average\n");
+#endif
 #ifdef WITH_DEBUG_OPTIONS
 	fprintf(stderr, "      --debug[=...]            Enable debug options. p, b, c, v specify parent, bfd, checker and vrrp processes\n");
 #ifdef _TIMER_CHECK_
@@ -1296,6 +1326,12 @@ parse_cmdline(int argc, char **argv)
 #ifdef _WITH_PERF_
 		{"perf",		optional_argument,	NULL,  5 },
 #endif
+#ifdef _WITH_THREAD_TRACE_
+		{"thread-trace",	required_argument,	NULL,  7 },
+#endif
+#ifdef _WITH_ALLOC_PROFILE_
+		{"alloc-profile",	optional_argument,	NULL,  8 },
+#endif
 #ifdef WITH_DEBUG_OPTIONS
 		{"debug",		optional_argument,	NULL,  6 },
 #endif
@@ -1554,6 +1590,25 @@ parse_cmdline(int argc, char **argv)
 
 			break;
 #endif
+#ifdef _WITH_THREAD_TRACE_
+		case 7:
+			thread_trace_dir = optarg;
+			break;
+#endif
+#ifdef _WITH_ALLOC_PROFILE_
+		case 8:
+			if (optarg && optarg[0]) {
+				unsigned interval;
+
+				if (!read_unsigned(optarg, &interval, 1, UINT_MAX, false)) {
+					fprintf(stderr, "Invalid allocation profile interval '%s'\n", optarg);
+					break;
+				}
+				alloc_profile_interval = interval;
+			}
+			alloc_profile_enable(true);
+			break;
+#endif
 #ifdef WITH_DEBUG_OPTIONS
 		case 6:
 			set_debug_options(optarg && optarg[0] ? optarg : NULL);
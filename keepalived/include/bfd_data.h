@@ -27,10 +27,12 @@
 #include <stdio.h>
 
 #include "list.h"
+#include "name_table.h"
 #include "bfd.h"
 
 typedef struct _bfd_data {
 	list bfd;		/* List of BFD instances */
+	name_table_t *bfd_index;	/* BFD instances by iname */
 	int fd_in;		/* Input socket fd */
 	thread_t *thread_in;	/* Input socket thread */
 } bfd_data_t;
@@ -43,6 +45,7 @@ extern bfd_data_t *old_bfd_data;
 extern char *bfd_buffer;
 
 extern void alloc_bfd(char *);
+extern void remove_bfd(bfd_t *);
 extern bfd_data_t *alloc_bfd_data(void);
 extern void dump_bfd_data(FILE *, bfd_data_t *);
 extern void free_bfd_data(bfd_data_t *);
@@ -32,6 +32,7 @@
 
 /* local includes */
 #include "list.h"
+#include "list_head.h"
 #include "check_data.h"
 #include "vector.h"
 #include "layer4.h"
@@ -57,16 +58,24 @@ typedef struct _checker {
 	unsigned			retry_it;		/* number of successive failures */
 	unsigned			default_retry;		/* number of retries before failing */
 	unsigned long			default_delay_before_retry; /* interval between retries */
+	bool				worker_safe;		/* May run on a checker worker thread */
+#ifdef _WITH_CHECKER_THREADS_
+	bool				on_worker;		/* Run by a checker worker thread */
+	bool				worker_is_up;		/* is_up and has_run as last reported */
+	bool				worker_has_run;		/*   by the worker thread */
+#endif
+	list_head_t			e_list;			/* checkers_queue */
+	list_head_t			rs_list;		/* real_server_t->checkers */
 } checker_t;
 
 /* Checkers queue */
-extern list checkers_queue;
+extern list_head_t checkers_queue;
 
 /* utility macro */
 #define CHECKER_ARG(X) ((X)->data)
 #define CHECKER_CO(X) (((checker_t *)X)->co)
 #define CHECKER_DATA(X) (((checker_t *)X)->data)
-#define CHECKER_GET_CURRENT() (LIST_TAIL_DATA(checkers_queue))
+#define CHECKER_GET_CURRENT() (list_last_entry(&checkers_queue, checker_t, e_list))
 #define CHECKER_GET() (CHECKER_DATA(CHECKER_GET_CURRENT()))
 #define CHECKER_GET_CO() (((checker_t *)CHECKER_GET_CURRENT())->co)
 #define CHECKER_VALUE_STRING(X) (set_value(X))
@@ -74,8 +83,20 @@ extern list checkers_queue;
 #define CHECKER_NEW_CO() ((conn_opts_t *) MALLOC(sizeof (conn_opts_t)))
 #define FMT_CHK(C) FMT_RS((C)->rs, (C)->vs)
 
+/* The checker's state, as seen by the thread running it. The main thread
+ * updates is_up and has_run, so a checker run by a worker thread uses the
+ * state it last reported instead. */
+#ifdef _WITH_CHECKER_THREADS_
+#define CHECKER_IS_UP(C) ((C)->on_worker ? (C)->worker_is_up : (C)->is_up)
+#define CHECKER_HAS_RUN(C) ((C)->on_worker ? (C)->worker_has_run : (C)->has_run)
+#else
+#define CHECKER_IS_UP(C) ((C)->is_up)
+#define CHECKER_HAS_RUN(C) ((C)->has_run)
+#endif
+
 /* Prototypes definition */
 extern void init_checkers_queue(void);
+extern void free_checker(checker_t *);
 extern void free_vs_checkers(virtual_server_t *);
 extern void dump_connection_opts(FILE *, void *);
 extern void dump_checker_opts(FILE *, void *);
@@ -88,6 +109,7 @@ extern void dequeue_new_checker(void);
 extern bool check_conn_opts(conn_opts_t *);
 extern bool compare_conn_opts(conn_opts_t *, conn_opts_t *);
 extern void dump_checkers_queue(FILE *);
+extern void free_checker_list(list_head_t *);
 extern void free_checkers_queue(void);
 extern void register_checkers_thread(void);
 extern void install_checkers_keyword(void);
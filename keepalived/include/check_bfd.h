@@ -52,6 +52,7 @@ typedef struct _bfd_checker {
 } bfd_checker_t;
 
 /* Prototypes defs */
+extern checker_tracked_bfd_t *find_checker_tracked_bfd_by_name(const char *);
 extern void install_bfd_check_keyword(void);
 extern void start_bfd_monitoring(thread_master_t *);
 extern void checker_bfd_dispatcher_release(void);
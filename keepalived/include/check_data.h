@@ -39,8 +39,11 @@
 
 /* local includes */
 #include "list.h"
+#include "list_head.h"
+#include "name_table.h"
 #include "vector.h"
 #include "notify.h"
+#include "parser.h"
 #include "utils.h"
 
 /* Daemon dynamic data structure definition */
@@ -58,6 +61,9 @@ typedef struct _ssl_data {
 	char				*keyfile;
 } ssl_data_t;
 
+/* Initial number of buckets, as log2, of a virtual server's real server index */
+#define RS_HASH_MIN_BITS	4
+
 /* Real Server definition */
 typedef struct _real_server {
 	struct sockaddr_storage		addr;
@@ -99,6 +105,10 @@ typedef struct _real_server {
 #ifdef _WITH_BFD_
 	list				tracked_bfds;	/* list of bfd_checker_t */
 #endif
+
+	list_head_t			checkers;	/* checker_t - checkers of this real server */
+	hlist_node_t			e_hash;		/* virtual_server_t->rs_hash */
+	list_head_t			e_list;		/* virtual_server_t->rs */
 } real_server_t;
 
 /* Virtual Server group definition */
@@ -151,7 +161,10 @@ typedef struct _virtual_server {
 	char				*virtualhost;	/* Default virtualhost for HTTP and SSL healthcheckers
 							   if not set on real servers */
 	int				weight;
-	list				rs;
+	list_head_t			rs;		/* real_server_t */
+	hlist_head_t			*rs_hash;	/* real_server_t, keyed on address and port */
+	unsigned			rs_hash_bits;	/* log2 of the number of rs_hash buckets */
+	unsigned			rs_hash_count;	/* number of real servers in rs_hash */
 	int				alive;
 	bool				alpha;		/* Set if alpha mode is default. */
 	bool				omega;		/* Omega mode enabled. */
@@ -168,6 +181,7 @@ typedef struct _virtual_server {
 	int				smtp_alert;	/* Send email on status change */
 	bool				quorum_state_up; /* Reflects result of the last transition done. */
 	bool				reloaded;	/* quorum_state was copied from old config while reloading */
+	config_block_t			conf_block;	/* Where configured, to spot changes on reload */
 #if defined(_WITH_SNMP_CHECKER_) && defined(_WITH_LVS_)
 	/* Statistics */
 	time_t				lastupdated;
@@ -187,6 +201,10 @@ typedef struct _check_data {
 	list				vs;
 #ifdef _WITH_BFD_
 	list				track_bfds;	/* list of checker_tracked_bfd_t */
+#endif
+	name_table_t			*vs_group_index; /* virtual_server_group_t by gname */
+#ifdef _WITH_BFD_
+	name_table_t			*track_bfd_index; /* checker_tracked_bfd_t by bname */
 #endif
 } check_data_t;
 
@@ -246,6 +264,11 @@ extern void alloc_vsg(char *);
 extern void alloc_vsg_entry(vector_t *);
 extern void alloc_vs(char *, char *);
 extern void alloc_rs(char *, char *);
+extern void free_rs(real_server_t *);
+extern void free_rs_list(list_head_t *);
+extern hlist_head_t *rs_hash_bucket(virtual_server_t *, sa_family_t, const void *, uint16_t);
+extern void rs_hash_add(virtual_server_t *, real_server_t *);
+extern void rs_hash_del(virtual_server_t *, real_server_t *);
 extern void alloc_ssvr(char *, char *);
 extern check_data_t *alloc_check_data(void);
 extern void free_check_data(check_data_t *);
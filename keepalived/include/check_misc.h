@@ -39,12 +39,15 @@ typedef struct _misc_checker {
 	bool			dynamic;	/* false: old-style, true: exit code from checker affects weight */
 	script_state_t		state;		/* current state of script */
 	timeval_t		last_ran;	/* Time script last ran */
+	bool			persistent;	/* Script is kept running, and sent a request each check */
+	script_coproc_t		coproc;
 } misc_checker_t;
 
 /* Prototypes defs */
 extern void clear_dynamic_misc_check_flag(void);
 extern void install_misc_check_keyword(void);
 extern int check_misc_script_security(magic_t);
+extern void set_check_misc_thread_priorities(void);
 #ifdef THREAD_DUMP
 extern void register_check_misc_addresses(void);
 #endif
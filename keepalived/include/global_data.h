@@ -50,6 +50,7 @@
 #include "list.h"
 #include "vrrp_if.h"
 #include "timer.h"
+#include "logger.h"
 #ifdef _WITH_VRRP_
 #include "vrrp.h"
 #endif
@@ -64,6 +65,7 @@
 
 /* constants */
 #define DEFAULT_SMTP_CONNECTION_TIMEOUT (30 * TIMER_HZ)
+#define TIMER_MAX_SLACK			10000	/* msecs */
 
 #ifdef _WITH_VRRP_
 #define RX_BUFS_POLICY_MTU		0x01
@@ -157,6 +159,9 @@ typedef struct _data {
 	bool				have_checker_config;
 	char				checker_process_priority;
 	bool				checker_no_swap;
+#ifdef _WITH_CHECKER_THREADS_
+	unsigned			checker_threads;
+#endif
 #ifdef _HAVE_SCHED_RT_
 	unsigned			checker_realtime_priority;
 #if HAVE_DECL_RLIMIT_RTTIME == 1
@@ -225,6 +230,14 @@ typedef struct _data {
 	size_t				vrrp_rx_bufs_size;
 	int				vrrp_rx_bufs_multiples;
 #endif
+	bool				timer_wheel;		/* use the timer wheel rather than an rb tree for timers */
+	unsigned			timer_slack;		/* msecs non-critical timers can be delayed to coalesce them */
+#ifdef _WITH_ASYNC_LOG_
+	unsigned			async_log;		/* log ring entries, 0 to log synchronously */
+#endif
+	log_rate_limit_t		log_rate_limit[LOG_DEBUG + 1];	/* per priority limits of rate limited log messages */
+	bool				script_spawner;		/* fork scripts from a small helper process */
+	bool				script_vfork;		/* start scripts with clone(CLONE_VM | CLONE_VFORK) */
 } data_t;
 
 /* Global vars exported */
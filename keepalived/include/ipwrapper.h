@@ -45,10 +45,11 @@
 extern void update_svr_wgt(int, virtual_server_t *, real_server_t *, bool);
 extern void set_checker_state(checker_t *, bool);
 extern void update_svr_checker_state(bool, checker_t *);
+extern void update_svr_checker_state_alert(bool, checker_t *, const char *);
 extern bool init_services(void);
 extern void clear_services(void);
 extern void set_quorum_states(void);
-extern void clear_diff_services(list);
+extern void clear_diff_services(void);
 extern void link_vsg_to_vs(void);
 
 #endif
@@ -37,8 +37,10 @@
 /* local include */
 #include "vector.h"
 #include "list.h"
+#include "list_head.h"
 #include "timer.h"
 #include "notify.h"
+#include "parser.h"
 #if defined _WITH_VRRP_AUTH_
 #include "vrrp_ipsecah.h"
 #endif
@@ -178,10 +180,17 @@ typedef enum chksum_compatibility {
 } chksum_compatibility_t;
 #endif
 
+/* Unicast peer to send adverts to */
+typedef struct _unicast_peer {
+	struct sockaddr_storage	address;
+	list_head_t		e_list;
+} unicast_peer_t;
+
 /* parameters per virtual router -- rfc2338.6.1.2 */
 typedef struct _vrrp_t {
 	sa_family_t		family;			/* AF_INET|AF_INET6 */ //使用哪种ip协议
 	char			*iname;			/* Instance Name */ //vrrp实例名称
+	config_block_t		conf_block;		/* Where configured, to spot changes on reload */
 	vrrp_sgroup_t		*sync;			/* Sync group we belong to */
 	vrrp_stats		*stats;			/* Statistics */
 	interface_t		*ifp;			/* Interface we belong to */
@@ -209,7 +218,7 @@ typedef struct _vrrp_t {
 	bool			track_saddr;		/* Fault state if configured saddr is missing */
 	//记录发送方地址
 	struct sockaddr_storage	pkt_saddr;		/* Src IP address received in VRRP IP header */
-	list			unicast_peer;		/* List of Unicast peer to send advert to */
+	list_head_t		unicast_peer;		/* unicast_peer_t - peers to send adverts to */
 #ifdef _WITH_UNICAST_CHKSUM_COMPAT_
 	chksum_compatibility_t	unicast_chksum_compat;	/* Whether v1.3.6 and earlier chksum is used */
 #endif
@@ -30,6 +30,7 @@
 /* local includes */
 #include "list.h"
 #include "vector.h"
+#include "name_table.h"
 
 /* Configuration data root */
 typedef struct _vrrp_data {
@@ -46,6 +47,12 @@ typedef struct _vrrp_data {
 	list			vrrp_track_files;	/* vrrp_tracked_file_t */
 #ifdef _WITH_BFD_
 	list			vrrp_track_bfds;	/* vrrp_tracked_bfd_t */
+#endif
+	name_table_t		*vrrp_name_index;	/* vrrp_t by iname */
+	name_table_t		*vrrp_script_index;	/* vrrp_script_t by sname */
+	name_table_t		*vrrp_track_file_index;	/* vrrp_tracked_file_t by fname */
+#ifdef _WITH_BFD_
+	name_table_t		*vrrp_track_bfd_index;	/* vrrp_tracked_bfd_t by bname */
 #endif
 } vrrp_data_t;
 
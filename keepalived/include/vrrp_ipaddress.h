@@ -120,6 +120,7 @@ extern ip_address_t *parse_ipaddress(ip_address_t *, char *, bool);
 extern ip_address_t *parse_route(char *);
 extern void alloc_ipaddress(list, vector_t *, interface_t *, bool);
 extern void get_diff_address(vrrp_t *, vrrp_t *, list);
+extern bool carry_over_addresses(vrrp_t *, vrrp_t *);
 extern void clear_address_list(list, bool);
 extern void clear_diff_saddresses(void);
 extern void reinstate_static_address(ip_address_t *);
@@ -255,6 +255,7 @@ extern void format_iproute(ip_route_t *, char *, size_t);
 extern void dump_iproute(FILE *, void *);
 extern void alloc_route(list, vector_t *, bool);
 extern void clear_diff_routes(list, list);
+extern bool carry_over_routes(list, list);
 extern void clear_diff_sroutes(void);
 extern void reinstate_static_route(ip_route_t *);
 
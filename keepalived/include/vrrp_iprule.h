@@ -123,6 +123,7 @@ extern void format_iprule(ip_rule_t *, char *, size_t);
 extern void dump_iprule(FILE *, void *);
 extern void alloc_rule(list, vector_t *, bool);
 extern void clear_diff_rules(list, list);
+extern bool carry_over_rules(list, list);
 extern void clear_diff_srules(void);
 extern void reset_next_rule_priority(void);
 
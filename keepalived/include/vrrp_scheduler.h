@@ -61,6 +61,7 @@ extern int vrrp_gratuitous_arp_thread(thread_t *);
 extern int vrrp_lower_prio_gratuitous_arp_thread(thread_t *);
 extern int vrrp_arp_thread(thread_t *);
 extern void try_up_instance(vrrp_t *, bool);
+extern void set_vrrp_thread_priorities(void);
 #ifdef _WITH_DUMP_THREADS_
 extern void dump_threads(void);
 #endif
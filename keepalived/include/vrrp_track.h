@@ -71,6 +71,8 @@ typedef struct _vrrp_script {
 	script_state_t		state;		/* current state of script */
 	script_init_state_t	init_state;	/* current initialisation state of script */
 	bool			insecure;	/* Set if script is run by root, but is non-root modifiable */
+	bool			persistent;	/* Script is kept running, and sent a request each interval */
+	script_coproc_t		coproc;
 } vrrp_script_t;
 
 /* Tracked script structure definition */
@@ -59,6 +59,7 @@
 #include "vrrp_snmp.h"
 #endif
 #include "list.h"
+#include "list_diff.h"
 #include "logger.h"
 #include "main.h"
 #include "utils.h"
@@ -279,8 +280,10 @@ check_vrrp_script_security(void)
 		next = e->next;
 		vscript = ELEMENT_DATA(e);
 
-		if (vscript->insecure)
+		if (vscript->insecure) {
+			name_table_remove(vrrp_data->vrrp_script_index, vscript->sname, vscript);
 			free_list_element(vrrp_data->vrrp_script, e);
+		}
 	}
 }
 
@@ -382,7 +385,7 @@ vrrp_update_pkt(vrrp_t *vrrp, uint8_t prio, struct sockaddr_storage* addr)
 
 #ifdef _WITH_VRRP_AUTH_
 	/* We will need to be called again if there is more than one unicast peer, so don't calculate checksums */
-	final_update = (LIST_ISEMPTY(vrrp->unicast_peer) || !LIST_HEAD(vrrp->unicast_peer)->next || addr);
+	final_update = (list_empty(&vrrp->unicast_peer) || list_is_last(vrrp->unicast_peer.next, &vrrp->unicast_peer) || addr);
 #endif
 
 	if (vrrp->family == AF_INET) {
@@ -485,7 +488,7 @@ vrrp_update_pkt(vrrp_t *vrrp, uint8_t prio, struct sockaddr_storage* addr)
 				/* zero the ip mutable fields */
 				ip->tos = 0;
 				ip->frag_off = 0;
-				if (!LIST_ISEMPTY(vrrp->unicast_peer))
+				if (!list_empty(&vrrp->unicast_peer))
 					ip->ttl = 0;
 				/* Compute the ICV & trunc the digest to 96bits
 				   => No padding needed.
@@ -553,7 +556,7 @@ vrrp_in_chk_ipsecah(vrrp_t * vrrp, char *buffer)
 	ip->tos = 0;
 	ip->frag_off = 0;
 	ip->check = 0;
-	if (!LIST_ISEMPTY(vrrp->unicast_peer))
+	if (!list_empty(&vrrp->unicast_peer))
 		ip->ttl = 0;
 	memcpy(backup_auth_data, ah->auth_data, sizeof (ah->auth_data));
 	memset(ah->auth_data, 0, sizeof (ah->auth_data));
@@ -566,7 +569,7 @@ vrrp_in_chk_ipsecah(vrrp_t * vrrp, char *buffer)
 		 , digest);
 
 	if (memcmp_constant_time(backup_auth_data, digest, HMAC_MD5_TRUNC) != 0) {
-		log_message(LOG_INFO, "(%s) IPSEC-AH : invalid"
+		log_message_rl(LOG_INFO, "(%s) IPSEC-AH : invalid"
 				      " IPSEC HMAC-MD5 value. Due to fields mutation"
 				      " or bad password !",
 			    vrrp->iname);
@@ -575,7 +578,7 @@ vrrp_in_chk_ipsecah(vrrp_t * vrrp, char *buffer)
 
 	/* Now verify that the SPI value is equal to src IP */
 	if (ah->spi != ip->saddr) {
-		log_message(LOG_INFO, "IPSEC AH : invalid IPSEC SPI value. %d and expect %d",
+		log_message_rl(LOG_INFO, "IPSEC AH : invalid IPSEC SPI value. %d and expect %d",
 			    ip->saddr, ah->spi);
 		return true;
 	}
@@ -587,7 +590,7 @@ vrrp_in_chk_ipsecah(vrrp_t * vrrp, char *buffer)
 	if (ntohl(ah->seq_number) > vrrp->ipsecah_counter.seq_number)
 		vrrp->ipsecah_counter.seq_number = ntohl(ah->seq_number);
 	else {
-		log_message(LOG_INFO, "(%s) IPSEC-AH : sequence number %d"
+		log_message_rl(LOG_INFO, "(%s) IPSEC-AH : sequence number %d"
 					" already processed. Packet dropped. Local(%d)",
 					vrrp->iname, ntohl(ah->seq_number),
 					vrrp->ipsecah_counter.seq_number);
@@ -646,14 +649,14 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 	ipv4_phdr_t ipv4_phdr;
 	uint32_t acc_csum = 0;
 	ip = NULL;
-	struct sockaddr_storage *up_addr;
+	unicast_peer_t *peer;
 	size_t buflen, expected_len;
 #ifdef _WITH_UNICAST_CHKSUM_COMPAT_
 	bool chksum_error;
 #endif
 
 	if (buflen_ret < 0) {
-		log_message(LOG_INFO, "recvmsg returned %zd", buflen_ret);
+		log_message_rl(LOG_INFO, "recvmsg returned %zd", buflen_ret);
 		return VRRP_PACKET_KO;
 	}
 	buflen = (size_t)buflen_ret;
@@ -673,7 +676,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 		 */
 		if (buflen < expected_len) {
 			//报文过短，报文有误
-			log_message(LOG_INFO,
+			log_message_rl(LOG_INFO,
 			       "(%s) ip/vrrp header too short. %zu and expect at least %zu",
 			      vrrp->iname, buflen, expected_len);
 			++vrrp->stats->packet_len_err;
@@ -696,8 +699,8 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 
 		/* MUST verify that the IP TTL is 255 */
 		//ttl必须是255
-		if (LIST_ISEMPTY(vrrp->unicast_peer) && ip->ttl != VRRP_IP_TTL) {
-			log_message(LOG_INFO, "(%s) invalid ttl. %d and expect %d",
+		if (list_empty(&vrrp->unicast_peer) && ip->ttl != VRRP_IP_TTL) {
+			log_message_rl(LOG_INFO, "(%s) invalid ttl. %d and expect %d",
 				vrrp->iname, ip->ttl, VRRP_IP_TTL);
 			++vrrp->stats->ip_ttl_err;
 #ifdef _WITH_SNMP_RFCV3_
@@ -712,7 +715,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 		 * equal to the VRRP header
 		 */
 		if (buflen < sizeof(vrrphdr_t)) {
-			log_message(LOG_INFO,
+			log_message_rl(LOG_INFO,
 			       "(%s) vrrp header too short. %zu and expect at least %zu",
 			      vrrp->iname, buflen, sizeof(vrrphdr_t));
 			++vrrp->stats->packet_len_err;
@@ -736,7 +739,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 		    hd->v2.auth_type != VRRP_AUTH_PASS &&
 #endif
 		    hd->v2.auth_type != VRRP_AUTH_NONE) {
-			log_message(LOG_INFO, "(%s) Invalid auth type: %d", vrrp->iname, hd->v2.auth_type);
+			log_message_rl(LOG_INFO, "(%s) Invalid auth type: %d", vrrp->iname, hd->v2.auth_type);
 			++vrrp->stats->invalid_authtype;
 #ifdef _WITH_SNMP_RFCV2_
 			vrrp_rfcv2_snmp_auth_err_trap(vrrp, ((struct sockaddr_in *)&vrrp->pkt_saddr)->sin_addr, invalidAuthType);
@@ -750,7 +753,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 		 * check the authentication type
 		 */
 		if (vrrp->auth_type != hd->v2.auth_type) {
-			log_message(LOG_INFO, "(%s) received a %d auth, expecting %d!",
+			log_message_rl(LOG_INFO, "(%s) received a %d auth, expecting %d!",
 			       vrrp->iname, hd->v2.auth_type, vrrp->auth_type);
 			++vrrp->stats->authtype_mismatch;
 #ifdef _WITH_SNMP_RFCV2_
@@ -763,7 +766,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 			/* check the authentication if it is a passwd */
 			char *pw = (char *) ip + ntohs(ip->tot_len) - sizeof (vrrp->auth_data);
 			if (memcmp_constant_time(pw, vrrp->auth_data, sizeof(vrrp->auth_data)) != 0) {
-				log_message(LOG_INFO, "(%s) received an invalid passwd!", vrrp->iname);
+				log_message_rl(LOG_INFO, "(%s) received an invalid passwd!", vrrp->iname);
 				++vrrp->stats->auth_failure;
 #ifdef _WITH_SNMP_RFCV2_
 				vrrp_rfcv2_snmp_auth_err_trap(vrrp, ((struct sockaddr_in *)&vrrp->pkt_saddr)->sin_addr, authFailure);
@@ -794,7 +797,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 		 * the locally configured for this virtual router if VRRPv2
 		 */
 		if (vrrp->adver_int != hd->v2.adver_int * TIMER_HZ) {
-			log_message(LOG_INFO, "(%s) advertisement interval mismatch mine=%d sec rcved=%d sec",
+			log_message_rl(LOG_INFO, "(%s) advertisement interval mismatch mine=%d sec rcved=%d sec",
 				vrrp->iname, vrrp->adver_int / TIMER_HZ, adver_int / TIMER_HZ);
 			/* to prevent concurent VRID running => multiple master in 1 VRID */
 			return VRRP_PACKET_DROP;
@@ -804,7 +807,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 
 	/* MUST verify the VRRP version */
 	if ((hd->vers_type >> 4) != vrrp->version) {
-		log_message(LOG_INFO, "(%s) invalid version. %d and expect %d",
+		log_message_rl(LOG_INFO, "(%s) invalid version. %d and expect %d",
 		       vrrp->iname, (hd->vers_type >> 4), vrrp->version);
 #ifdef _WITH_SNMP_RFC_
 		vrrp->stats->vers_err++;
@@ -819,7 +822,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 	/* verify packet type */
 	if ((hd->vers_type & 0x0f) != VRRP_PKT_ADVERT) {
 		//必须为通告报文
-		log_message(LOG_INFO, "(%s) Invalid packet type. %d and expect %d",
+		log_message_rl(LOG_INFO, "(%s) Invalid packet type. %d and expect %d",
 			vrrp->iname, (hd->vers_type & 0x0f), VRRP_PKT_ADVERT);
 		++vrrp->stats->invalid_type_rcvd;
 		return VRRP_PACKET_KO;
@@ -828,7 +831,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 	/* MUST verify that the VRID is valid on the receiving interface_t */
 	if (vrrp->vrid != hd->vrid) {
 		//报文中的vrouter id必须与vrrp的vrouter id相等
-		log_message(LOG_INFO,
+		log_message_rl(LOG_INFO,
 		       "(%s) received VRID mismatch. Received %d, Expected %d",
 		       vrrp->iname, hd->vrid, vrrp->vrid);
 #ifdef _WITH_SNMP_RFC_
@@ -843,14 +846,14 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 
 	if ((LIST_ISEMPTY(vrrp->vip) && hd->naddr > 0) ||
 	    (!LIST_ISEMPTY(vrrp->vip) && LIST_SIZE(vrrp->vip) != hd->naddr)) {
-		log_message(LOG_INFO, "(%s) received an invalid ip number count %d, expected %d!",
+		log_message_rl(LOG_INFO, "(%s) received an invalid ip number count %d, expected %d!",
 			vrrp->iname, hd->naddr, LIST_ISEMPTY(vrrp->vip) ? 0 : LIST_SIZE(vrrp->vip));
 		++vrrp->stats->addr_list_err;
 		return VRRP_PACKET_KO;
 	}
 
 	if (vrrp->family == AF_INET && ntohs(ip->tot_len) != buflen) {
-		log_message(LOG_INFO,
+		log_message_rl(LOG_INFO,
 		       "(%s) ip_tot_len mismatch against received length. %d and received %zu",
 		       vrrp->iname, ntohs(ip->tot_len), buflen);
 		++vrrp->stats->packet_len_err;
@@ -858,7 +861,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 	}
 
 	if (expected_len != buflen) {
-		log_message(LOG_INFO,
+		log_message_rl(LOG_INFO,
 		       "(%s) Received packet length mismatch against expected. %zu and expect %zu",
 		      vrrp->iname, buflen, expected_len);
 		++vrrp->stats->packet_len_err;
@@ -885,7 +888,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 			if (in_csum((uint16_t *) hd, vrrppkt_len, acc_csum, NULL)) {
 #ifdef _WITH_UNICAST_CHKSUM_COMPAT_
 				chksum_error = true;
-				if (!LIST_ISEMPTY(vrrp->unicast_peer) &&
+				if (!list_empty(&vrrp->unicast_peer) &&
 				    vrrp->unicast_chksum_compat == CHKSUM_COMPATIBILITY_NONE &&
 				    ipv4_phdr.dst != global_data->vrrp_mcast_group4.sin_addr.s_addr) {
 					ipv4_phdr.dst = global_data->vrrp_mcast_group4.sin_addr.s_addr;
@@ -905,7 +908,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 				if (chksum_error)
 #endif
 				{
-					log_message(LOG_INFO, "(%s) Invalid VRRPv3 checksum", vrrp->iname);
+					log_message_rl(LOG_INFO, "(%s) Invalid VRRPv3 checksum", vrrp->iname);
 #ifdef _WITH_SNMP_RFC_
 					vrrp->stats->chk_err++;
 #ifdef _WITH_SNMP_RFCV3_
@@ -919,7 +922,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 		} else {
 			vrrppkt_len += VRRP_AUTH_LEN;
 			if (in_csum((uint16_t *) hd, vrrppkt_len, 0, NULL)) {
-				log_message(LOG_INFO, "(%s) Invalid VRRPv2 checksum", vrrp->iname);
+				log_message_rl(LOG_INFO, "(%s) Invalid VRRPv2 checksum", vrrp->iname);
 #ifdef _WITH_SNMP_RFC_
 				vrrp->stats->chk_err++;
 #ifdef _WITH_SNMP_RFCV3_
@@ -948,7 +951,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 				for (e = LIST_HEAD(vrrp->vip); e; ELEMENT_NEXT(e)) {
 					ipaddress = ELEMENT_DATA(e);
 					if (!vrrp_in_chk_vips(vrrp, ipaddress, vips)) {
-						log_message(LOG_INFO, "(%s) ip address associated with VRID %d"
+						log_message_rl(LOG_INFO, "(%s) ip address associated with VRID %d"
 						       " not present in MASTER advert : %s",
 						       vrrp->iname, vrrp->vrid,
 						       inet_ntop2(ipaddress->u.sin.sin_addr.s_addr));
@@ -959,14 +962,13 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 			}
 
 			/* check a unicast source address is in the unicast_peer list */
-			if (global_data->vrrp_check_unicast_src && !LIST_ISEMPTY(vrrp->unicast_peer)) {
-				for (e = LIST_HEAD(vrrp->unicast_peer); e; ELEMENT_NEXT(e)) {
-					up_addr = ELEMENT_DATA(e);
-					if (((struct sockaddr_in *)&vrrp->pkt_saddr)->sin_addr.s_addr == ((struct sockaddr_in *)up_addr)->sin_addr.s_addr)
+			if (global_data->vrrp_check_unicast_src && !list_empty(&vrrp->unicast_peer)) {
+				list_for_each_entry(peer, &vrrp->unicast_peer, e_list) {
+					if (((struct sockaddr_in *)&vrrp->pkt_saddr)->sin_addr.s_addr == ((struct sockaddr_in *)&peer->address)->sin_addr.s_addr)
 						break;
 				}
-				if (!e) {
-					log_message(LOG_INFO, "(%s) unicast source address %s not a unicast peer",
+				if (&peer->e_list == &vrrp->unicast_peer) {
+					log_message_rl(LOG_INFO, "(%s) unicast source address %s not a unicast peer",
 						vrrp->iname, inet_ntop2(((struct sockaddr_in*)&vrrp->pkt_saddr)->sin_addr.s_addr));
 					return VRRP_PACKET_KO;
 				}
@@ -978,7 +980,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 				 * VRID are valid
 				 */
 				if (hd->naddr != LIST_SIZE(vrrp->vip)) {
-					log_message(LOG_INFO,
+					log_message_rl(LOG_INFO,
 						"(%s) receive an invalid ip number count associated with VRID!", vrrp->iname);
 					++vrrp->stats->addr_list_err;
 					return VRRP_PACKET_KO;
@@ -987,7 +989,7 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 				for (e = LIST_HEAD(vrrp->vip); e; ELEMENT_NEXT(e)) {
 					ipaddress = ELEMENT_DATA(e);
 					if (!vrrp_in_chk_vips(vrrp, ipaddress, vips)) {
-						log_message(LOG_INFO, "(%s) ip address associated with VRID %d"
+						log_message_rl(LOG_INFO, "(%s) ip address associated with VRID %d"
 							    " not present in MASTER advert : %s",
 							    vrrp->iname, vrrp->vrid,
 							    inet_ntop(AF_INET6, &ipaddress->u.sin6_addr,
@@ -999,14 +1001,13 @@ vrrp_in_chk(vrrp_t * vrrp, char *buffer, ssize_t buflen_ret, bool check_vip_addr
 			}
 
 			/* check a unicast source address is in the unicast_peer list */
-			if (global_data->vrrp_check_unicast_src && !LIST_ISEMPTY(vrrp->unicast_peer)) {
-				for (e = LIST_HEAD(vrrp->unicast_peer); e; ELEMENT_NEXT(e)) {
-					up_addr = ELEMENT_DATA(e);
-					if (IN6_ARE_ADDR_EQUAL(&((struct sockaddr_in6 *)&vrrp->pkt_saddr)->sin6_addr, &((struct sockaddr_in6 *)up_addr)->sin6_addr))
+			if (global_data->vrrp_check_unicast_src && !list_empty(&vrrp->unicast_peer)) {
+				list_for_each_entry(peer, &vrrp->unicast_peer, e_list) {
+					if (IN6_ARE_ADDR_EQUAL(&((struct sockaddr_in6 *)&vrrp->pkt_saddr)->sin6_addr, &((struct sockaddr_in6 *)&peer->address)->sin6_addr))
 						break;
 				}
-				if (!e) {
-					log_message(LOG_INFO, "(%s) unicast source address %s not a unicast peer",
+				if (&peer->e_list == &vrrp->unicast_peer) {
+					log_message_rl(LOG_INFO, "(%s) unicast source address %s not a unicast peer",
 						vrrp->iname, inet_ntop(AF_INET6, &((struct sockaddr_in6 *)&vrrp->pkt_saddr)->sin6_addr,
 							    addr_str, sizeof(addr_str)));
 					return VRRP_PACKET_KO;
@@ -1063,10 +1064,10 @@ vrrp_build_ip4(vrrp_t *vrrp, char *buffer)
 	ip->saddr = VRRP_PKT_SADDR(vrrp);
 
 	/* If using unicast peers, pick the first one */
-	if (!LIST_ISEMPTY(vrrp->unicast_peer)) {
+	if (!list_empty(&vrrp->unicast_peer)) {
 		//如果采用单播对端，选链表头的地址
-		struct sockaddr_storage* addr = ELEMENT_DATA(LIST_HEAD(vrrp->unicast_peer));
-		ip->daddr = inet_sockaddrip4(addr);
+		unicast_peer_t *peer = list_first_entry(&vrrp->unicast_peer, unicast_peer_t, e_list);
+		ip->daddr = inet_sockaddrip4(&peer->address);
 	}
 	else
 		//否则使用组播地址
@@ -1368,22 +1369,21 @@ vrrp_alloc_send_buffer(vrrp_t * vrrp)
 void
 vrrp_send_adv(vrrp_t * vrrp, uint8_t prio)
 {
-	struct sockaddr_storage *addr;
-	element e;
+	unicast_peer_t *peer;
 
 	/* build the packet */
 	vrrp_update_pkt(vrrp, prio, NULL);
 
-	if (LIST_ISEMPTY(vrrp->unicast_peer))
+	if (list_empty(&vrrp->unicast_peer))
 		vrrp_send_pkt(vrrp, NULL);
 	else {
 		//采用单播发送，故需要遍历每个对端，并为每个单播发送一份幅本
-		LIST_FOREACH(vrrp->unicast_peer, addr, e) {
+		list_for_each_entry(peer, &vrrp->unicast_peer, e_list) {
 			if (vrrp->family == AF_INET)
-				vrrp_update_pkt(vrrp, prio, addr);
-			if (vrrp_send_pkt(vrrp, addr) < 0)
-				log_message(LOG_INFO, "(%s) Cant send advert to %s (%m)"
-						    , vrrp->iname, inet_sockaddrtos(addr));
+				vrrp_update_pkt(vrrp, prio, &peer->address);
+			if (vrrp_send_pkt(vrrp, &peer->address) < 0)
+				log_message_rl(LOG_INFO, "(%s) Cant send advert to %s (%m)"
+						    , vrrp->iname, inet_sockaddrtos(&peer->address));
 		}
 	}
 
@@ -2260,7 +2260,7 @@ open_vrrp_read_socket(sa_family_t family, int proto, interface_t *ifp, bool unic
 static void
 close_vrrp_socket(vrrp_t * vrrp)
 {
-	if (LIST_ISEMPTY(vrrp->unicast_peer))
+	if (list_empty(&vrrp->unicast_peer))
 		//单播列表为空，使vrrp->ifp离开对应组播组
 		if_leave_vrrp_group(vrrp->family, vrrp->fd_in, vrrp->ifp);
 
@@ -2293,7 +2293,7 @@ new_vrrp_socket(vrrp_t * vrrp)
 	ifp = vrrp->ifp;
 #endif
 	//检查是否单播
-	unicast = !LIST_ISEMPTY(vrrp->unicast_peer);
+	unicast = !list_empty(&vrrp->unicast_peer);
 	//创建vrrp 读fd
 	vrrp->fd_in = open_vrrp_read_socket(vrrp->family, proto, ifp, unicast, vrrp->sockets->rx_buf_size);
 	//创建vrrp 写fd
@@ -2303,36 +2303,48 @@ new_vrrp_socket(vrrp_t * vrrp)
 }
 #endif
 
-/* Try to find a VRRP instance */
-static vrrp_t *
-vrrp_exist(vrrp_t *old_vrrp, list *vrrp_list)
+/* A VRRP instance is identified on reload by its VRID, address family
+ * and interface, or the VMAC's base interface */
+static bool
+vrrp_diff_match(const void *old_data, const void *new_data)
 {
-	element e;
-	vrrp_t *vrrp;
+	const vrrp_t *old_vrrp = old_data;
+	const vrrp_t *vrrp = new_data;
 
-	LIST_FOREACH(*vrrp_list, vrrp, e) {
-		if (vrrp->vrid != old_vrrp->vrid ||
-		    vrrp->family != old_vrrp->family)
-			continue;
+	if (vrrp->vrid != old_vrrp->vrid ||
+	    vrrp->family != old_vrrp->family)
+		return false;
 
 #ifndef _HAVE_VRRP_VMAC_
-		if (vrrp->ifp->ifindex == old_vrrp->ifp->ifindex)
-			return vrrp;
+	return vrrp->ifp->ifindex == old_vrrp->ifp->ifindex;
 #else
-		if (__test_bit(VRRP_VMAC_BIT, &vrrp->vmac_flags) != __test_bit(VRRP_VMAC_BIT, &old_vrrp->vmac_flags))
-			continue;
-		if (!__test_bit(VRRP_VMAC_BIT, &vrrp->vmac_flags)) {
-			if (vrrp->ifp->ifindex == old_vrrp->ifp->ifindex)
-				return vrrp;
-			continue;
-		}
+	if (__test_bit(VRRP_VMAC_BIT, &vrrp->vmac_flags) != __test_bit(VRRP_VMAC_BIT, &old_vrrp->vmac_flags))
+		return false;
+	if (!__test_bit(VRRP_VMAC_BIT, &vrrp->vmac_flags))
+		return vrrp->ifp->ifindex == old_vrrp->ifp->ifindex;
 
-		if (vrrp->ifp->base_ifp->ifindex == old_vrrp->ifp->base_ifp->ifindex)
-			return vrrp;
+	return vrrp->ifp->base_ifp->ifindex == old_vrrp->ifp->base_ifp->ifindex;
 #endif
-	}
+}
 
-	return NULL;
+static uint64_t
+vrrp_diff_hash(const void *data)
+{
+	const vrrp_t *vrrp = data;
+	ifindex_t ifindex = vrrp->ifp->ifindex;
+
+#ifdef _HAVE_VRRP_VMAC_
+	if (__test_bit(VRRP_VMAC_BIT, &vrrp->vmac_flags))
+		ifindex = vrrp->ifp->base_ifp->ifindex;
+#endif
+
+	return (uint64_t)ifindex << 32 | (uint64_t)vrrp->family << 8 | vrrp->vrid;
+}
+
+static list_diff_t *
+alloc_vrrp_diff(list vrrp_list)
+{
+	return alloc_list_diff(vrrp_diff_hash, vrrp_diff_match, vrrp_list, NULL);
 }
 
 /* handle terminate state phase 1 */
@@ -2599,7 +2611,7 @@ vrrp_complete_instance(vrrp_t * vrrp)
 		return false;
 
 	/* unicast peers aren't allowed in strict mode if the interface supports multicast */
-	if (vrrp->strict_mode && vrrp->ifp->ifindex && (vrrp->ifp->ifi_flags & IFF_MULTICAST) && !LIST_ISEMPTY(vrrp->unicast_peer)) {
+	if (vrrp->strict_mode && vrrp->ifp->ifindex && (vrrp->ifp->ifi_flags & IFF_MULTICAST) && !list_empty(&vrrp->unicast_peer)) {
 		report_config_error(CONFIG_GENERAL_ERROR, "(%s) Unicast peers are not supported in strict mode", vrrp->iname);
 		return false;
 	}
@@ -2614,7 +2626,7 @@ vrrp_complete_instance(vrrp_t * vrrp)
 #endif
 
 	/* If the interface doesn't support multicast, then we need to use unicast */
-	if (vrrp->ifp->ifindex && !(vrrp->ifp->ifi_flags & IFF_MULTICAST) && LIST_ISEMPTY(vrrp->unicast_peer)) {
+	if (vrrp->ifp->ifindex && !(vrrp->ifp->ifi_flags & IFF_MULTICAST) && list_empty(&vrrp->unicast_peer)) {
 		report_config_error(CONFIG_GENERAL_ERROR, "(%s) interface %s does not support multicast, specify unicast peers - disabling", vrrp->iname, vrrp->ifp->ifname);
 		vrrp->num_script_if_fault++;	/* Stop the vrrp instance running */
 	}
@@ -2627,7 +2639,7 @@ vrrp_complete_instance(vrrp_t * vrrp)
 		report_config_error(CONFIG_GENERAL_ERROR, "(%s) disabling ARP since interface does not support it", vrrp->iname);
 
 	/* If the addresses are IPv6, then the first one must be link local */
-	if (vrrp->family == AF_INET6 && LIST_ISEMPTY(vrrp->unicast_peer) &&
+	if (vrrp->family == AF_INET6 && list_empty(&vrrp->unicast_peer) &&
 		  !IN6_IS_ADDR_LINKLOCAL(&((ip_address_t *)LIST_HEAD(vrrp->vip)->data)->u.sin6_addr)) {
 		report_config_error(CONFIG_GENERAL_ERROR, "(%s) the first IPv6 VIP address must be link local", vrrp->iname);
 	}
@@ -3340,6 +3352,7 @@ vrrp_complete_init(void)
 	size_t max_mtu_len = 0;
 	bool have_master, have_backup;
 	vrrp_script_t *scr;
+	list_diff_t *vrrp_diff = NULL;
 
 	/* Set defaults of not specified, depending on strict mode */
 	if (global_data->vrrp_garp_lower_prio_rep == PARAMETER_UNSET)
@@ -3501,6 +3514,8 @@ vrrp_complete_init(void)
 //   and then go through and set up sync groups in fault or init with counts
 // TODO-PQA
 	/* Set all sync group members to fault state if sync group is in fault state */
+	if (reload)
+		vrrp_diff = alloc_vrrp_diff(old_vrrp_data->vrrp);
 	LIST_FOREACH(vrrp_data->vrrp, vrrp, e) {
 		if (vrrp->state == VRRP_STATE_FAULT ||
 		    (vrrp->sync && vrrp->sync->state == VRRP_STATE_FAULT)) {
@@ -3509,7 +3524,7 @@ vrrp_complete_init(void)
 			/* If we are reloading and the vrrp instance was already
 			 * in fault state, we don't need to notify again */
 			if (reload) {
-				old_vrrp = vrrp_exist(vrrp, &old_vrrp_data->vrrp);
+				old_vrrp = list_diff_find(vrrp_diff, vrrp);
 				if (old_vrrp && old_vrrp->state == VRRP_STATE_FAULT)
 					continue;
 			}
@@ -3519,9 +3534,11 @@ vrrp_complete_init(void)
 			send_instance_notifies(vrrp);
 		}
 	}
+	free_list_diff(&vrrp_diff);
 
 	if (reload) {
 		/* Now step through the old vrrp to set the status on matching new instances */
+		vrrp_diff = alloc_vrrp_diff(vrrp_data->vrrp);
 		LIST_FOREACH(old_vrrp_data->vrrp, old_vrrp, e) {
 			/* We work out for ourselves if the vrrp instance
 			 * should be in fault state, so it doesn't matter
@@ -3529,7 +3546,7 @@ vrrp_complete_init(void)
 			if (old_vrrp->state == VRRP_STATE_FAULT)
 				continue;
 
-			vrrp = vrrp_exist(old_vrrp, &vrrp_data->vrrp);
+			vrrp = list_diff_find(vrrp_diff, old_vrrp);
 			if (vrrp) {
 				/* If we have detected a fault, don't override it */
 				if (vrrp->state == VRRP_STATE_FAULT || vrrp->num_script_init)
@@ -3539,6 +3556,7 @@ vrrp_complete_init(void)
 				vrrp->wantstate = old_vrrp->state;
 			}
 		}
+		free_list_diff(&vrrp_diff);
 
 		/* Now see if any sync groups should be master */
 		LIST_FOREACH(vrrp_data->vrrp_sync_group, sgroup, e) {
@@ -3589,6 +3607,7 @@ vrrp_complete_init(void)
 	LIST_FOREACH_NEXT(vrrp_data->vrrp_script, scr, e, next) {
 		if (LIST_ISEMPTY(scr->tracking_vrrp)) {
 			report_config_error(CONFIG_GENERAL_ERROR, "Warning - script %s is not used", scr->sname);
+			name_table_remove(vrrp_data->vrrp_script_index, scr->sname, scr);
 			free_list_element(vrrp_data->vrrp_script, e);
 		}
 	}
@@ -3705,15 +3724,18 @@ clear_diff_vrrp(void)
 {
 	element e;
 	vrrp_t *vrrp;
+	unsigned num_unchanged = 0;
+	list_diff_t *vrrp_diff = alloc_vrrp_diff(vrrp_data->vrrp);
 
 	LIST_FOREACH(old_vrrp_data->vrrp, vrrp, e) {
 		vrrp_t *new_vrrp;
+		bool unchanged;
 
 		/*
 		 * Try to find this vrrp in the new conf data
 		 * reloaded.
 		 */
-		new_vrrp = vrrp_exist(vrrp, &vrrp_data->vrrp);
+		new_vrrp = list_diff_find(vrrp_diff, vrrp);
 		if (!new_vrrp) {
 			vrrp_restore_interface(vrrp, true, false);
 
@@ -3730,19 +3752,44 @@ clear_diff_vrrp(void)
 #endif
 		} else {
 			/*
-			 * If this vrrp instance exist in new
-			 * data, then perform a VIP|EVIP diff.
+			 * If the instance's configuration block is unchanged, its
+			 * addresses, routes and rules are too, unless they now
+			 * resolve differently. Otherwise perform a VIP|EVIP diff.
 			 */
-			clear_diff_vrrp_vip(vrrp, new_vrrp);
+			unchanged = config_block_unchanged(&vrrp->conf_block, &new_vrrp->conf_block);
+			if (!unchanged && __test_bit(LOG_DETAIL_BIT, &debug)) {
+				char loc_buf[CONFIG_BLOCK_LOCATION_LEN];
+
+				log_message(LOG_INFO, "(%s) configuration at %s has changed", new_vrrp->iname, config_block_location(&new_vrrp->conf_block, loc_buf, sizeof(loc_buf)));
+			}
+
+			if (unchanged && carry_over_addresses(vrrp, new_vrrp)) {
+#ifdef _WITH_FIREWALL_
+				if (vrrp->vipset)
+					new_vrrp->firewall_rules_set = (vrrp->base_priority != VRRP_PRIO_OWNER && !vrrp->accept);
+#endif
+			} else {
+				unchanged = false;
+				clear_diff_vrrp_vip(vrrp, new_vrrp);
+			}
 
 #ifdef _HAVE_FIB_ROUTING_
 			/* virtual routes diff */
-			clear_diff_vrrp_vroutes(vrrp, new_vrrp);
+			if (!unchanged || !carry_over_routes(vrrp->vroutes, new_vrrp->vroutes)) {
+				unchanged = false;
+				clear_diff_vrrp_vroutes(vrrp, new_vrrp);
+			}
 
 			/* virtual rules diff */
-			clear_diff_vrrp_vrules(vrrp, new_vrrp);
+			if (!unchanged || !carry_over_rules(vrrp->vrules, new_vrrp->vrules)) {
+				unchanged = false;
+				clear_diff_vrrp_vrules(vrrp, new_vrrp);
+			}
 #endif
 
+			if (unchanged)
+				num_unchanged++;
+
 #ifdef _HAVE_VRRP_VMAC_
 			/*
 			 * Remove VMAC if it existed in old vrrp instance,
@@ -3769,9 +3816,14 @@ clear_diff_vrrp(void)
 		}
 	}
 
+	free_list_diff(&vrrp_diff);
+
 #ifdef _WITH_FIREWALL_
 //XXX	firewall_close();
 #endif
+
+	if (!LIST_ISEMPTY(vrrp_data->vrrp))
+		log_message(LOG_INFO, "%u of %u VRRP instances unchanged by reload", num_unchanged, LIST_SIZE(vrrp_data->vrrp));
 }
 
 /* Set script status to a sensible value on reload */
@@ -34,7 +34,9 @@
 #include <sys/resource.h>
 
 #ifdef THREAD_DUMP
+#ifdef _WITH_SNMP_
 #include "snmp.h"
+#endif
 #include "scheduler.h"
 #include "smtp.h"
 #include "vrrp_track.h"
@@ -99,6 +101,10 @@ perf_t perf_run = PERF_NONE;
 
 /* local variables */
 static char *vrrp_syslog_ident;
+static mem_arena_t *vrrp_arena;		/* the current configuration generation */
+static timeval_t start_time;		/* of startup, or of the current reload */
+static unsigned long parse_time;
+static unsigned long complete_init_time;
 #ifndef _DEBUG_
 static bool two_phase_terminate;
 #endif
@@ -264,6 +270,7 @@ vrrp_terminate_phase2(int exit_status)
 	free_vrrp_data(vrrp_data);
 	free_vrrp_buffer();
 	free_interface_queue();
+	mem_arena_release(vrrp_arena);
 	free_parent_mallocs_exit();
 
 	/*
@@ -277,6 +284,10 @@ vrrp_terminate_phase2(int exit_status)
 	else
 		log_message(LOG_INFO, "Stopped");
 
+#ifdef _WITH_ASYNC_LOG_
+	set_async_log(0);
+#endif
+
 #ifdef ENABLE_LOG_TO_FILE
 	if (log_file_name)
 		close_log_file();
@@ -436,10 +447,23 @@ stop_vrrp(int status)
 	exit(status);
 }
 
+/* Logged with -D, for scale benchmarks such as test/scale-bench.sh */
+static void
+log_vrrp_timing(void)
+{
+	log_message(LOG_INFO, "VRRP %s took %lu us: parse %lu us, vrrp_complete_init %lu us",
+		    reload ? "reload" : "startup", timer_elapsed(start_time), parse_time, complete_init_time);
+}
+
 /* Daemon init sequence */
 static void
 start_vrrp(data_t *old_global_data)
 {
+	timeval_t phase_start;
+
+	if (!reload)
+		start_time = timer_now();
+
 	/* Clear the flags used for optimising performance */
 	clear_summary_flags();
 
@@ -467,7 +491,14 @@ start_vrrp(data_t *old_global_data)
 	}
 
 	//解析vrrp配置文件
+	phase_start = timer_now();
+	vrrp_arena = mem_arena_new();
+	mem_arena_set(vrrp_arena);
 	init_data(conf_file, vrrp_init_keywords);
+	mem_arena_set(NULL);
+	parse_time = timer_elapsed(phase_start);
+	if (__test_bit(LOG_DETAIL_BIT, &debug))
+		mem_arena_log_stats(vrrp_arena, "Parsed");
 
 	if (non_existent_interface_specified) {
 		report_config_error(CONFIG_BAD_IF, "Non-existent interface specified in configuration");
@@ -555,15 +586,26 @@ start_vrrp(data_t *old_global_data)
 	}
 
 	/* Complete VRRP initialization */
+	phase_start = timer_now();
 	if (!vrrp_complete_init()) {
 		stop_vrrp(KEEPALIVED_EXIT_CONFIG);
 		return;
 	}
+	complete_init_time = timer_elapsed(phase_start);
 
 	/* If we are just testing the configuration, then we terminate now */
 	if (__test_bit(CONFIG_TEST_BIT, &debug))
 		return;
 
+#ifdef _WITH_ASYNC_LOG_
+	/* Start, resize or stop logging from the drain thread */
+	set_async_log(global_data->async_log);
+#endif
+
+	set_log_rate_limits(global_data->log_rate_limit);
+	add_script_spawner_read_thread(master);
+	set_script_vfork(global_data->script_vfork);
+
 	/* Start or stop gratuitous arp/ndisc as appropriate */
 	if (have_ipv4_instance)
 		gratuitous_arp_init();
@@ -615,10 +657,33 @@ start_vrrp(data_t *old_global_data)
 	if (__test_bit(DUMP_CONF_BIT, &debug))
 		dump_data_vrrp(NULL);
 
+	/* Size the scheduler slabs: each instance has an advert timer and
+	 * at most one socket, and each script a timer or child thread */
+	thread_master_prealloc(master,
+			       (LIST_ISEMPTY(vrrp_data->vrrp) ? 0 : LIST_SIZE(vrrp_data->vrrp)) +
+			       (LIST_ISEMPTY(vrrp_data->vrrp_script) ? 0 : LIST_SIZE(vrrp_data->vrrp_script)) +
+			       THREAD_SLAB_CHUNK,
+			       (LIST_ISEMPTY(vrrp_data->vrrp) ? 0 : LIST_SIZE(vrrp_data->vrrp)) +
+			       THREAD_SLAB_CHUNK);
+
 	/* Init & start the VRRP packet dispatcher */
 	thread_add_event(master, vrrp_dispatcher_init, NULL,
 			 VRRP_DISPATCHER);
 
+	/* Select the timer queue implementation */
+	thread_set_timer_wheel(master, global_data->timer_wheel);
+	thread_set_timer_slack(master, global_data->timer_slack * (TIMER_HZ / 1000));
+
+	/* Assign the ready queue classes; dumps requested by signal are bulk */
+	set_vrrp_thread_priorities();
+#ifndef _DEBUG_
+	thread_set_func_priority(master, print_vrrp_data, THREAD_PRIO_BULK);
+	thread_set_func_priority(master, print_vrrp_stats, THREAD_PRIO_BULK);
+#ifdef _WITH_JSON_
+	thread_set_func_priority(master, print_vrrp_json, THREAD_PRIO_BULK);
+#endif
+#endif
+
 	/* Set the process priority and non swappable if configured */
 	set_process_priorities(
 #ifdef _HAVE_SCHED_RT_
@@ -631,6 +696,9 @@ start_vrrp(data_t *old_global_data)
 
 	/* Ensure we can open sufficient file descriptors */
 	set_vrrp_max_fds();
+
+	if (!reload && __test_bit(LOG_DETAIL_BIT, &debug))
+		log_vrrp_timing();
 }
 
 #ifndef _DEBUG_
@@ -729,6 +797,9 @@ vrrp_signal_init(void)
 	signal_set(SIGUSR2, sigusr2_vrrp, NULL);
 #ifdef _WITH_JSON_
 	signal_set(SIGJSON, sigjson_vrrp, NULL);
+#endif
+#ifdef _WITH_ALLOC_PROFILE_
+	signal_set(SIGALLOC, alloc_profile_signal, NULL);
 #endif
 	signal_ignore(SIGPIPE);
 }
@@ -737,6 +808,10 @@ vrrp_signal_init(void)
 static int
 reload_vrrp_thread(__attribute__((unused)) thread_t * thread)
 {
+	mem_arena_t *old_arena;
+
+	start_time = timer_now();
+
 	log_message(LOG_INFO, "Reloading");
 
 	/* Use standard scheduling while reloading */
@@ -781,6 +856,7 @@ reload_vrrp_thread(__attribute__((unused)) thread_t * thread)
 	vrrp_data = NULL;
 	old_global_data = global_data;
 	global_data = NULL;
+	old_arena = vrrp_arena;
 	reset_interface_queue();
 #ifdef _HAVE_FIB_ROUTING_
 	reset_next_rule_priority();
@@ -803,6 +879,14 @@ reload_vrrp_thread(__attribute__((unused)) thread_t * thread)
 
 	free_old_interface_queue();
 
+	/* Nothing refers to the old configuration now */
+	if (__test_bit(LOG_DETAIL_BIT, &debug))
+		mem_arena_log_stats(old_arena, "Releasing");
+	mem_arena_release(old_arena);
+
+	if (__test_bit(LOG_DETAIL_BIT, &debug))
+		log_vrrp_timing();
+
 	UNSET_RELOAD;
 
 	return 0;
@@ -1002,6 +1086,11 @@ start_vrrp_child(void)
 	/* Create the new master thread */
 	//重新创建新的master,先将父节点创建的释放掉
 	thread_destroy_master(master);	/* This destroys any residual settings from the parent */
+
+	/* Start the script spawner while we are small and have few fds open */
+	if (global_data->script_spawner)
+		start_script_spawner();
+
 	master = thread_make_master();
 #endif
 
@@ -187,6 +187,7 @@ free_vscript(void *data)
 {
 	vrrp_script_t *vscript = data;
 
+	coproc_release(&vscript->coproc);
 	free_list(&vscript->tracking_vrrp);
 	FREE(vscript->sname);
 	FREE_PTR(vscript->script.args);
@@ -206,6 +207,9 @@ dump_vscript(FILE *fp, void *data)
 	conf_write(fp, "   Rise = %d", vscript->rise);
 	conf_write(fp, "   Fall = %d", vscript->fall);
 	conf_write(fp, "   Insecure = %s", vscript->insecure ? "yes" : "no");
+	conf_write(fp, "   Persistent = %s", vscript->persistent ? "yes" : "no");
+	if (vscript->coproc.pid)
+		conf_write(fp, "   Persistent script PID = %d", vscript->coproc.pid);
 
 	switch (vscript->init_state) {
 	case SCRIPT_INIT_STATE_INIT:
@@ -327,17 +331,23 @@ dump_sock_pool(FILE *fp, list sock_pool)
 }
 
 static void
-free_unicast_peer(void *data)
+free_unicast_peer_list(list_head_t *l)
 {
-	FREE(data);
+	unicast_peer_t *peer, *peer_tmp;
+
+	list_for_each_entry_safe(peer, peer_tmp, l, e_list) {
+		list_head_del(&peer->e_list);
+		FREE(peer);
+	}
 }
 
 static void
-dump_unicast_peer(FILE *fp, void *data)
+dump_unicast_peer_list(FILE *fp, list_head_t *l)
 {
-	struct sockaddr_storage *peer = data;
+	unicast_peer_t *peer;
 
-	conf_write(fp, "     %s", inet_sockaddrtos(peer));
+	list_for_each_entry(peer, l, e_list)
+		conf_write(fp, "     %s", inet_sockaddrtos(&peer->address));
 }
 
 static void
@@ -346,6 +356,7 @@ free_vrrp(void *data)
 	vrrp_t *vrrp = data;
 
 	FREE(vrrp->iname);
+	free_config_block(&vrrp->conf_block);
 	FREE_PTR(vrrp->send_buffer);
 	free_notify_script(&vrrp->script_backup);
 	free_notify_script(&vrrp->script_master);
@@ -361,7 +372,7 @@ free_vrrp(void *data)
 #ifdef _WITH_BFD_
 	free_list(&vrrp->track_bfd);
 #endif
-	free_list(&vrrp->unicast_peer);
+	free_unicast_peer_list(&vrrp->unicast_peer);
 	free_list(&vrrp->vip);
 	free_list(&vrrp->evip);
 	free_list(&vrrp->vroutes);
@@ -499,10 +510,10 @@ dump_vrrp(FILE *fp, void *data)
 			LIST_SIZE(vrrp->evip));
 		dump_list(fp, vrrp->evip);
 	}
-	if (!LIST_ISEMPTY(vrrp->unicast_peer)) {
-		conf_write(fp, "   Unicast Peer = %d",
-			LIST_SIZE(vrrp->unicast_peer));
-		dump_list(fp, vrrp->unicast_peer);
+	if (!list_empty(&vrrp->unicast_peer)) {
+		conf_write(fp, "   Unicast Peer = %u",
+			list_count(&vrrp->unicast_peer));
+		dump_unicast_peer_list(fp, &vrrp->unicast_peer);
 #ifdef _WITH_UNICAST_CHKSUM_COMPAT_
 		conf_write(fp, "   Unicast checksum compatibility = %s",
 				vrrp->unicast_chksum_compat == CHKSUM_COMPATIBILITY_NONE ? "no" :
@@ -645,6 +656,7 @@ alloc_vrrp(char *iname)
 	new->iname = (char *) MALLOC(size + 1);
 	memcpy(new->iname, iname, size);
 	new->stats = alloc_vrrp_stats();
+	INIT_LIST_HEAD(&new->unicast_peer);
 #ifdef _WITH_FIREWALL_
 	new->accept = PARAMETER_UNSET;
 #endif
@@ -664,6 +676,7 @@ alloc_vrrp(char *iname)
 	new->skip_check_adv_addr = global_data->vrrp_skip_check_adv_addr;
 	new->strict_mode = PARAMETER_UNSET;
 
+	name_table_add(vrrp_data->vrrp_name_index, new->iname, new);
 	list_add(vrrp_data->vrrp, new);//将新创建的vrrp结构加入到vrrp链表中
 }
 
@@ -671,14 +684,12 @@ void
 alloc_vrrp_unicast_peer(vector_t *strvec)
 {
 	vrrp_t *vrrp = LIST_TAIL_DATA(vrrp_data->vrrp);
-	struct sockaddr_storage *peer = NULL;
-
-	if (!LIST_EXISTS(vrrp->unicast_peer))
-		vrrp->unicast_peer = alloc_list(free_unicast_peer, dump_unicast_peer);
+	unicast_peer_t *peer;
 
 	/* Allocate new unicast peer */
-	peer = (struct sockaddr_storage *) MALLOC(sizeof(struct sockaddr_storage));
-	if (inet_stosockaddr(strvec_slot(strvec, 0), NULL, peer)) {
+	PMALLOC(peer);
+	INIT_LIST_HEAD(&peer->e_list);
+	if (inet_stosockaddr(strvec_slot(strvec, 0), NULL, &peer->address)) {
 		report_config_error(CONFIG_GENERAL_ERROR, "Configuration error: VRRP instance[%s] malformed unicast"
 				     " peer address[%s]. Skipping..."
 				   , vrrp->iname, FMT_STR_VSLOT(strvec, 0));
@@ -687,8 +698,8 @@ alloc_vrrp_unicast_peer(vector_t *strvec)
 	}
 
 	if (!vrrp->family)
-		vrrp->family = peer->ss_family;
-	else if (peer->ss_family != vrrp->family) {
+		vrrp->family = peer->address.ss_family;
+	else if (peer->address.ss_family != vrrp->family) {
 		report_config_error(CONFIG_GENERAL_ERROR, "Configuration error: VRRP instance[%s] and unicast peer address"
 				     "[%s] MUST be of the same family !!! Skipping..."
 				   , vrrp->iname, FMT_STR_VSLOT(strvec, 0));
@@ -696,7 +707,7 @@ alloc_vrrp_unicast_peer(vector_t *strvec)
 		return;
 	}
 
-	list_add(vrrp->unicast_peer, peer);
+	list_add_tail(&peer->e_list, &vrrp->unicast_peer);
 }
 
 void
@@ -860,6 +871,7 @@ alloc_vrrp_script(char *sname)
 	new->state = SCRIPT_STATE_IDLE;
 	new->rise = 1;
 	new->fall = 1;
+	name_table_add(vrrp_data->vrrp_script_index, new->sname, new);
 	list_add(vrrp_data->vrrp_script, new);
 }
 
@@ -874,6 +886,7 @@ alloc_vrrp_file(char *fname)
 	new->fname = (char *) MALLOC(size + 1);
 	memcpy(new->fname, fname, size + 1);
 	new->weight = 1;
+	name_table_add(vrrp_data->vrrp_track_file_index, new->fname, new);
 	list_add(vrrp_data->vrrp_track_files, new);
 }
 
@@ -918,6 +931,12 @@ alloc_vrrp_data(void)
 	new->vrrp_track_bfds = alloc_list(free_vrrp_bfd, dump_vrrp_bfd);
 #endif
 	new->vrrp_socket_pool = alloc_list(free_sock, dump_sock);
+	new->vrrp_name_index = alloc_name_table();
+	new->vrrp_script_index = alloc_name_table();
+	new->vrrp_track_file_index = alloc_name_table();
+#ifdef _WITH_BFD_
+	new->vrrp_track_bfd_index = alloc_name_table();
+#endif
 
 	return new;
 }
@@ -937,6 +956,12 @@ free_vrrp_data(vrrp_data_t * data)
 	free_list(&data->vrrp_track_files);
 #ifdef _WITH_BFD_
 	free_list(&data->vrrp_track_bfds);
+#endif
+	free_name_table(&data->vrrp_name_index);
+	free_name_table(&data->vrrp_script_index);
+	free_name_table(&data->vrrp_track_file_index);
+#ifdef _WITH_BFD_
+	free_name_table(&data->vrrp_track_bfd_index);
 #endif
 	FREE(data);
 }
@@ -57,6 +57,8 @@
 #include "keepalived_netlink.h"
 #include "utils.h"
 #include "logger.h"
+#include "memory.h"
+#include "name_table.h"
 #ifdef _HAVE_VRRP_VMAC_
 #include "vrrp_vmac.h"
 #include "bitops.h"
@@ -71,6 +73,7 @@
 
 /* Local vars */
 static list if_queue;//用来记录interface
+static name_table_t *if_name_index;	/* interface_t by ifname */
 static struct ifreq ifr;
 
 static list old_garp_delay;
@@ -103,13 +106,11 @@ interface_t *
 if_get_by_ifname(const char *ifname, if_lookup_t create)
 {
 	interface_t *ifp;
-	element e;
+	mem_arena_t *arena;
 
 	//如果if_queue中存在，则直接返回
-	LIST_FOREACH(if_queue, ifp, e) {
-		if (!strcmp(ifp->ifname, ifname))
-			return ifp;
-	}
+	if ((ifp = name_table_lookup(if_name_index, ifname)))
+		return ifp;
 
 	//如果不容许创建此接口，则报错
 	if (create == IF_NO_CREATE ||
@@ -119,9 +120,11 @@ if_get_by_ifname(const char *ifname, if_lookup_t create)
 		return NULL;
 	}
 
+	/* Interfaces outlive the configuration generation being parsed */
+	arena = mem_arena_set(NULL);
+
 	//否则创建此接口
-	if (!(ifp = MALLOC(sizeof(interface_t))))
-		return NULL;
+	ifp = MALLOC(sizeof(interface_t));
 
 	//设置接口名称，并将其加入到if_queue
 	strcpy(ifp->ifname, ifname);
@@ -130,6 +133,8 @@ if_get_by_ifname(const char *ifname, if_lookup_t create)
 #endif
 	if_add_queue(ifp);
 
+	mem_arena_set(arena);
+
 	if (create == IF_CREATE_IF_DYNAMIC)
 		log_message(LOG_INFO, "Configuration specifies interface %s which doesn't currently exist - will use if created", ifname);
 
@@ -586,13 +591,19 @@ dump_if(FILE *fp, void *data)
 static void
 init_if_queue(void)
 {
+	mem_arena_t *arena = mem_arena_set(NULL);
+
 	if_queue = alloc_list(free_if, dump_if);
+	if_name_index = alloc_name_table();
+
+	mem_arena_set(arena);
 }
 
 //向if_queue中加入interface
 void
 if_add_queue(interface_t * ifp)
 {
+	name_table_add(if_name_index, ifp->ifname, ifp);
 	list_add(if_queue, ifp);
 }
 
@@ -682,8 +693,12 @@ init_interface_linkbeat(void)
 		thread_add_timer(master, if_linkbeat_refresh_thread, ifp, POLLING_DELAY);
 	}
 
-	if (linkbeat_in_use)
+	if (linkbeat_in_use) {
 		log_message(LOG_INFO, "Using MII-BMSR/ETHTOOL NIC polling thread...");
+
+		/* Polling needn't be exact, so can be coalesced with timer_slack */
+		thread_set_func_slack(master, if_linkbeat_refresh_thread);
+	}
 }
 
 /* Interface queue helpers*/
@@ -691,6 +706,7 @@ void
 free_interface_queue(void)
 {
 	free_list(&if_queue);
+	free_name_table(&if_name_index);
 	free_list(&garp_delay);
 }
 
@@ -42,6 +42,7 @@
 #include "utils.h"
 #endif
 #include "parser.h"
+#include "list_diff.h"
 #ifdef _WITH_FIREWALL_
 #include "vrrp_firewall.h"
 #endif
@@ -558,7 +559,7 @@ alloc_ipaddress(list ip_list, vector_t *strvec, interface_t *ifp, bool allow_tra
 	/* Check if there was a missing parameter for a keyword */
 	if (param_missing) {
 		report_config_error(CONFIG_GENERAL_ERROR, "No %s parameter specified for %s", str, FMT_STR_VSLOT(strvec, addr_idx));
-		free(new);
+		FREE(new);
 		return;
 	}
 
@@ -613,62 +614,59 @@ alloc_ipaddress(list ip_list, vector_t *strvec, interface_t *ifp, bool allow_tra
 	list_add(ip_list, new);
 }
 
-/* Find an address in a list */
+/* Addresses are identified by address, prefix, interface, scope and label */
+static bool
+address_diff_match(const void *old_data, const void *new_data)
+{
+	const ip_address_t *old_addr = old_data;
+	const ip_address_t *new_addr = new_data;
+
+	return IP_ISEQ(old_addr, new_addr);
+}
+
+static uint64_t
+address_diff_hash(const void *data)
+{
+	const ip_address_t *ipaddr = data;
+
+	if (IP_IS6(ipaddr))
+		return mem_hash(&ipaddr->u.sin6_addr, sizeof(ipaddr->u.sin6_addr));
+
+	return (uint64_t)ipaddr->ifa.ifa_prefixlen << 32 | ipaddr->u.sin.sin_addr.s_addr;
+}
+
+/* Find an address in the new addresses */
 static bool
-address_exist(vrrp_t *vrrp, ip_address_t *ipaddress)
+address_exist(vrrp_t *vrrp, list_diff_t *diff, ip_address_t *ipaddress)
 {
 	ip_address_t *ipaddr;
-	element e;
-	bool found = false;
 	char addr_str[INET6_ADDRSTRLEN];
 	void *addr;
 
-	LIST_FOREACH(vrrp->vip, ipaddr, e) {
-		if (IP_ISEQ(ipaddr, ipaddress)) {
-			ipaddr->set = ipaddress->set;
+	ipaddr = list_diff_find(diff, ipaddress);
+	if (ipaddr) {
+		ipaddr->set = ipaddress->set;
 #ifdef _WITH_IPTABLES_
-			ipaddr->iptable_rule_set = ipaddress->iptable_rule_set;
+		ipaddr->iptable_rule_set = ipaddress->iptable_rule_set;
 #endif
 #ifdef _WITH_NFTABLES_
-			ipaddr->nftable_rule_set = ipaddress->nftable_rule_set;
+		ipaddr->nftable_rule_set = ipaddress->nftable_rule_set;
 #endif
-			ipaddr->ifa.ifa_index = ipaddress->ifa.ifa_index;
-			found = true;
-			break;
-		}
+		ipaddr->ifa.ifa_index = ipaddress->ifa.ifa_index;
+		return true;
 	}
 
-	if (!found) {
-		LIST_FOREACH(vrrp->evip, ipaddr, e) {
-			if (IP_ISEQ(ipaddr, ipaddress)) {
-				ipaddr->set = ipaddress->set;
-#ifdef _WITH_IPTABLES_
-				ipaddr->iptable_rule_set = ipaddress->iptable_rule_set;
-#endif
-#ifdef _WITH_NFTABLES_
-				ipaddr->nftable_rule_set = ipaddress->nftable_rule_set;
-#endif
-				ipaddr->ifa.ifa_index = ipaddress->ifa.ifa_index;
-				found = true;
-				break;
-			}
-		}
-	}
-
-	if (!found)
-		return false;
-
-	addr = (IP_IS6(ipaddr)) ? (void *) &ipaddr->u.sin6_addr :
-				  (void *) &ipaddr->u.sin.sin_addr;
-	inet_ntop(IP_FAMILY(ipaddr), addr, addr_str, INET6_ADDRSTRLEN);
+	addr = (IP_IS6(ipaddress)) ? (void *) &ipaddress->u.sin6_addr :
+				     (void *) &ipaddress->u.sin.sin_addr;
+	inet_ntop(IP_FAMILY(ipaddress), addr, addr_str, INET6_ADDRSTRLEN);
 
 	log_message(LOG_INFO, "(%s) ip address %s/%d dev %s, no longer exist"
-			    , vrrp->iname
+			    , vrrp->iname ? vrrp->iname : "static"
 			    , addr_str
-			    , ipaddr->ifa.ifa_prefixlen
-			    , ipaddr->ifp->ifname);
+			    , ipaddress->ifa.ifa_prefixlen
+			    , ipaddress->ifp ? ipaddress->ifp->ifname : "(none)");
 
-	return true;
+	return false;
 }
 
 /* Clear diff addresses */
@@ -677,20 +675,80 @@ get_diff_address(vrrp_t *old, vrrp_t *new, list old_addr)
 {
 	ip_address_t *ipaddr;
 	element e;
+	list_diff_t *diff;
 
 	/* No addresses in previous conf */
 	if (LIST_ISEMPTY(old->vip) && LIST_ISEMPTY(old->evip))
 		return;
 
+	/* The VIPs are searched before the eVIPs */
+	diff = alloc_list_diff(address_diff_hash, address_diff_match, new->vip, new->evip);
+
 	LIST_FOREACH(old->vip, ipaddr, e) {
-		if (ipaddr->set && !address_exist(new, ipaddr))
+		if (ipaddr->set && !address_exist(new, diff, ipaddr))
 			list_add(old_addr, ipaddr);
 	}
 
 	LIST_FOREACH(old->evip, ipaddr, e) {
-		if (ipaddr->set && !address_exist(new, ipaddr))
+		if (ipaddr->set && !address_exist(new, diff, ipaddr))
 			list_add(old_addr, ipaddr);
 	}
+
+	free_list_diff(&diff);
+}
+
+static bool
+address_lists_match(list old_addr, list new_addr)
+{
+	element e, ne;
+
+	for (e = LIST_HEAD(old_addr), ne = LIST_HEAD(new_addr); e && ne; ELEMENT_NEXT(e), ELEMENT_NEXT(ne)) {
+		if (!IP_ISEQ((ip_address_t *)ELEMENT_DATA(e), (ip_address_t *)ELEMENT_DATA(ne)))
+			return false;
+	}
+
+	return !e && !ne;
+}
+
+static void
+copy_address_state(list old_addr, list new_addr)
+{
+	ip_address_t *ipaddr, *new_ipaddr;
+	element e, ne;
+
+	for (e = LIST_HEAD(old_addr), ne = LIST_HEAD(new_addr); e; ELEMENT_NEXT(e), ELEMENT_NEXT(ne)) {
+		ipaddr = ELEMENT_DATA(e);
+		new_ipaddr = ELEMENT_DATA(ne);
+		new_ipaddr->set = ipaddr->set;
+#ifdef _WITH_IPTABLES_
+		new_ipaddr->iptable_rule_set = ipaddr->iptable_rule_set;
+#endif
+#ifdef _WITH_NFTABLES_
+		new_ipaddr->nftable_rule_set = ipaddr->nftable_rule_set;
+#endif
+		new_ipaddr->ifa.ifa_index = ipaddr->ifa.ifa_index;
+	}
+}
+
+/* The VIPs and eVIPs of an unchanged configuration block are the same
+ * addresses in the same order, so their state can be carried over without
+ * searching for them. Returns false, and changes nothing, if they didn't
+ * resolve the same, for example because an interface has been recreated. */
+bool
+carry_over_addresses(vrrp_t *old, vrrp_t *new)
+{
+	if (!address_lists_match(old->vip, new->vip) ||
+	    !address_lists_match(old->evip, new->evip))
+		return false;
+
+	/* As in clear_diff_vrrp_vip(), there is nothing installed to carry over */
+	if (!old->vipset)
+		return true;
+
+	copy_address_state(old->vip, new->vip);
+	copy_address_state(old->evip, new->evip);
+
+	return true;
 }
 
 /* Clear diff addresses */
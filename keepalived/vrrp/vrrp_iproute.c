@@ -50,6 +50,7 @@
 #include "rttables.h"
 #include "vrrp_ip_rule_route_parser.h"
 #include "parser.h"
+#include "list_diff.h"
 
 /* Buffer sizes for netlink messages. Increase if needed. */
 #define	RTM_SIZE		1024
@@ -1825,28 +1826,47 @@ err:
 	free_iproute(new);
 }
 
-/* Try to find a route in a list */
+/* The kernel's key to a route is (to, tos, preference, table) */
+static inline bool
+route_is_equal(const ip_route_t *x, const ip_route_t *y)
+{
+	return IP_ISEQ(x->dst, y->dst) &&
+	       x->dst->ifa.ifa_prefixlen == y->dst->ifa.ifa_prefixlen &&
+	       !((x->mask ^ y->mask) & IPROUTE_BIT_METRIC) &&
+	       (!(x->mask & IPROUTE_BIT_METRIC) || x->metric == y->metric) &&
+	       x->table == y->table;
+}
+
+static bool
+route_diff_match(const void *old_data, const void *new_data)
+{
+	return route_is_equal(old_data, new_data);
+}
+
+static uint64_t
+route_diff_hash(const void *data)
+{
+	const ip_route_t *iproute = data;
+	uint64_t hash = (uint64_t)iproute->table << 32 | iproute->dst->ifa.ifa_prefixlen;
+
+	if (IP_IS6(iproute->dst))
+		return hash ^ mem_hash(&iproute->dst->u.sin6_addr, sizeof(iproute->dst->u.sin6_addr));
+
+	return hash ^ (uint64_t)iproute->dst->u.sin.sin_addr.s_addr << 8;
+}
+
+/* Try to find a route in the new routes */
 static bool
-route_exist(list l, ip_route_t *iproute)
+route_exist(list_diff_t *diff, ip_route_t *iproute)
 {
 	ip_route_t *ipr;
-	element e;
 
-	for (e = LIST_HEAD(l); e; ELEMENT_NEXT(e)) {
-		ipr = ELEMENT_DATA(e);
-
-		/* The kernel's key to a route is (to, tos, preference, table) */
-		if (IP_ISEQ(ipr->dst, iproute->dst) &&
-		    ipr->dst->ifa.ifa_prefixlen == iproute->dst->ifa.ifa_prefixlen &&
-		    (!((ipr->mask ^ iproute->mask) & IPROUTE_BIT_METRIC)) &&
-		    (!(ipr->mask & IPROUTE_BIT_METRIC) ||
-		     ipr->metric == iproute->metric) &&
-		    ipr->table == iproute->table) {
-			ipr->set = iproute->set;
-			return true;
-		}
-	}
-	return false;
+	ipr = list_diff_find(diff, iproute);
+	if (!ipr)
+		return false;
+
+	ipr->set = iproute->set;
+	return true;
 }
 
 /* Clear diff routes */
@@ -1855,6 +1875,7 @@ clear_diff_routes(list l, list n)
 {
 	ip_route_t *iproute;
 	element e;
+	list_diff_t *diff;
 
 	/* No route in previous conf */
 	if (LIST_ISEMPTY(l))
@@ -1867,10 +1888,12 @@ clear_diff_routes(list l, list n)
 		return;
 	}
 
+	diff = alloc_list_diff(route_diff_hash, route_diff_match, n, NULL);
+
 	for (e = LIST_HEAD(l); e; ELEMENT_NEXT(e)) {
 		iproute = ELEMENT_DATA(e);
 		if (iproute->set) {
-			if (!route_exist(n, iproute)) {
+			if (!route_exist(diff, iproute)) {
 				log_message(LOG_INFO, "ip route %s/%d ... , no longer exist"
 						    , ipaddresstos(NULL, iproute->dst), iproute->dst->ifa.ifa_prefixlen);
 				netlink_route(iproute, IPROUTE_DEL);
@@ -1883,6 +1906,36 @@ clear_diff_routes(list l, list n)
 			}
 		}
 	}
+
+	free_list_diff(&diff);
+}
+
+/* The routes of an unchanged configuration block are the same routes in
+ * the same order, so their state can be carried over without searching
+ * for them, or replacing them since none of their options have changed.
+ * Returns false, and changes nothing, if they didn't resolve the same, for
+ * example because an interface has been recreated. */
+bool
+carry_over_routes(list l, list n)
+{
+	ip_route_t *iproute, *new_iproute;
+	element e, ne;
+
+	for (e = LIST_HEAD(l), ne = LIST_HEAD(n); e && ne; ELEMENT_NEXT(e), ELEMENT_NEXT(ne)) {
+		iproute = ELEMENT_DATA(e);
+		new_iproute = ELEMENT_DATA(ne);
+		if (!route_is_equal(iproute, new_iproute) ||
+		    !iproute->oif != !new_iproute->oif ||
+		    (iproute->oif && iproute->oif->ifindex != new_iproute->oif->ifindex))
+			return false;
+	}
+	if (e || ne)
+		return false;
+
+	for (e = LIST_HEAD(l), ne = LIST_HEAD(n); e; ELEMENT_NEXT(e), ELEMENT_NEXT(ne))
+		((ip_route_t *)ELEMENT_DATA(ne))->set = ((ip_route_t *)ELEMENT_DATA(e))->set;
+
+	return true;
 }
 
 /* Diff conf handler */
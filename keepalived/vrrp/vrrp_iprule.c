@@ -50,6 +50,7 @@
 #include "rttables.h"
 #include "vrrp_ip_rule_route_parser.h"
 #include "parser.h"
+#include "list_diff.h"
 
 /* Since we will be adding and deleting rules in potentially random
  * orders due to master/backup transitions, we therefore need to
@@ -876,21 +877,34 @@ err:
 	FREE_PTR(new);
 }
 
-/* Try to find a rule in a list */
-static int
-rule_exist(list l, ip_rule_t *iprule)
+static bool
+rule_diff_match(const void *old_data, const void *new_data)
+{
+	return rule_is_equal(old_data, new_data);
+}
+
+/* Rules are usually distinguished by their priority, or failing that
+ * by their selectors */
+static uint64_t
+rule_diff_hash(const void *data)
+{
+	const ip_rule_t *iprule = data;
+
+	return (uint64_t)iprule->priority << 32 ^ (uint64_t)iprule->tos << 24 ^ iprule->fwmark ^ iprule->mask;
+}
+
+/* Try to find a rule in the new rules */
+static bool
+rule_exist(list_diff_t *diff, ip_rule_t *iprule)
 {
 	ip_rule_t *ipr;
-	element e;
 
-	for (e = LIST_HEAD(l); e; ELEMENT_NEXT(e)) {
-		ipr = ELEMENT_DATA(e);
-		if (rule_is_equal(ipr, iprule)) {
-			ipr->set = iprule->set;
-			return 1;
-		}
-	}
-	return 0;
+	ipr = list_diff_find(diff, iprule);
+	if (!ipr)
+		return false;
+
+	ipr->set = iprule->set;
+	return true;
 }
 
 /* Clear diff rules */
@@ -899,6 +913,7 @@ clear_diff_rules(list l, list n)
 {
 	ip_rule_t *iprule;
 	element e;
+	list_diff_t *diff;
 
 	/* No rule in previous conf */
 	if (LIST_ISEMPTY(l))
@@ -911,14 +926,37 @@ clear_diff_rules(list l, list n)
 		return;
 	}
 
+	diff = alloc_list_diff(rule_diff_hash, rule_diff_match, n, NULL);
+
 	for (e = LIST_HEAD(l); e; ELEMENT_NEXT(e)) {
 		iprule = ELEMENT_DATA(e);
-		if (!rule_exist(n, iprule) && iprule->set) {
+		if (!rule_exist(diff, iprule) && iprule->set) {
 			log_message(LOG_INFO, "ip rule %s/%d ... , no longer exist"
 					    , ipaddresstos(NULL, iprule->from_addr), iprule->from_addr->ifa.ifa_prefixlen);
 			netlink_rule(iprule, IPRULE_DEL);
 		}
 	}
+
+	free_list_diff(&diff);
+}
+
+/* As carry_over_routes() */
+bool
+carry_over_rules(list l, list n)
+{
+	element e, ne;
+
+	for (e = LIST_HEAD(l), ne = LIST_HEAD(n); e && ne; ELEMENT_NEXT(e), ELEMENT_NEXT(ne)) {
+		if (!rule_is_equal(ELEMENT_DATA(e), ELEMENT_DATA(ne)))
+			return false;
+	}
+	if (e || ne)
+		return false;
+
+	for (e = LIST_HEAD(l), ne = LIST_HEAD(n); e; ELEMENT_NEXT(e), ELEMENT_NEXT(ne))
+		((ip_rule_t *)ELEMENT_DATA(ne))->set = ((ip_rule_t *)ELEMENT_DATA(e))->set;
+
+	return true;
 }
 
 /* Diff conf handler */
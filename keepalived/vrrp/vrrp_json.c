@@ -38,6 +38,9 @@
 #include "logger.h"
 #include "timer.h"
 #include "utils.h"
+#ifdef _WITH_THREAD_STATS_
+#include "scheduler.h"
+#endif
 
 static inline double
 timeval_to_double(const timeval_t *t)
@@ -46,6 +49,63 @@ timeval_to_double(const timeval_t *t)
 	return (double)t->tv_sec + (double)t->tv_usec / TIMER_HZ_FLOAT;
 }
 
+#ifdef _WITH_THREAD_STATS_
+static struct json_object *
+thread_hist_json(const unsigned long *hist)
+{
+	struct json_object *array = json_object_new_array();
+	unsigned i;
+
+	for (i = 0; i < THREAD_STATS_BUCKETS; i++)
+		json_object_array_add(array, json_object_new_int64((int64_t)hist[i]));
+
+	return array;
+}
+
+static void
+vrrp_print_thread_stats_json(void)
+{
+	FILE *file;
+	struct json_object *array, *func_json;
+	thread_func_stats_t *stats;
+
+	file = fopen_safe("/tmp/keepalived_threads.json", "w");
+	if (!file) {
+		log_message(LOG_INFO, "Can't open /tmp/keepalived_threads.json (%d: %s)",
+			errno, strerror(errno));
+		return;
+	}
+
+	array = json_object_new_array();
+
+	rb_for_each_entry(stats, &master->func_stats, n) {
+		func_json = json_object_new_object();
+		json_object_object_add(func_json, "function",
+			json_object_new_string(get_function_name(stats->func)));
+		json_object_object_add(func_json, "calls",
+			json_object_new_int64((int64_t)stats->count));
+		json_object_object_add(func_json, "run_total_us",
+			json_object_new_int64((int64_t)stats->run_total));
+		json_object_object_add(func_json, "run_max_us",
+			json_object_new_int64((int64_t)stats->run_max));
+		json_object_object_add(func_json, "delay_total_us",
+			json_object_new_int64((int64_t)stats->delay_total));
+		json_object_object_add(func_json, "delay_max_us",
+			json_object_new_int64((int64_t)stats->delay_max));
+		json_object_object_add(func_json, "run_hist",
+			thread_hist_json(stats->run_hist));
+		json_object_object_add(func_json, "delay_hist",
+			thread_hist_json(stats->delay_hist));
+
+		json_object_array_add(array, func_json);
+	}
+
+	fprintf(file, "%s", json_object_to_json_string(array));
+	json_object_put(array);
+	fclose(file);
+}
+#endif
+
 void
 vrrp_print_json(void)
 {
@@ -53,6 +113,10 @@ vrrp_print_json(void)
 	element e;
 	struct json_object *array;
 
+#ifdef _WITH_THREAD_STATS_
+	vrrp_print_thread_stats_json();
+#endif
+
 	if (LIST_ISEMPTY(vrrp_data->vrrp))
 		return;
 
@@ -369,6 +369,13 @@ vrrp_handler(vector_t *strvec)
 	//创建名称为vrrp的实例，并加入vrrp链表
 	alloc_vrrp(iname);
 }
+static void
+vrrp_end_handler(void)
+{
+	vrrp_t *vrrp = LIST_TAIL_DATA(vrrp_data->vrrp);
+
+	get_config_block(&vrrp->conf_block);
+}
 #ifdef _HAVE_VRRP_VMAC_
 static void
 vrrp_vmac_handler(vector_t *strvec)
@@ -1083,6 +1090,13 @@ vrrp_vscript_user_handler(vector_t *strvec)
 	}
 }
 static void
+vrrp_vscript_persistent_handler(__attribute__((unused)) vector_t *strvec)
+{
+	vrrp_script_t *vscript = LIST_TAIL_DATA(vrrp_data->vrrp_script);
+
+	vscript->persistent = true;
+}
+static void
 vrrp_vscript_end_handler(void)
 {
 	vrrp_script_t *vscript = LIST_TAIL_DATA(vrrp_data->vrrp_script);
@@ -1102,6 +1116,7 @@ vrrp_vscript_end_handler(void)
 	}
 
 	if (remove_script) {
+		name_table_remove(vrrp_data->vrrp_script_index, vscript->sname, vscript);
 		free_list_element(vrrp_data->vrrp_script, vrrp_data->vrrp_script->tail);
 		return;
 	}
@@ -1192,6 +1207,7 @@ vrrp_tfile_end_handler(void)
 
 	if (!tfile->file_path) {
 		report_config_error(CONFIG_GENERAL_ERROR, "No file set for track_file %s - removing", tfile->fname);
+		name_table_remove(vrrp_data->vrrp_track_file_index, tfile->fname, tfile);
 		free_list_element(vrrp_data->vrrp_track_files, vrrp_data->vrrp_track_files->tail);
 		return;
 	}
@@ -1453,6 +1469,7 @@ init_vrrp_keywords(bool active)
 	/* VRRP Instance mapping */
 	//安装vrrp_instance命令
 	install_keyword_root("vrrp_instance", &vrrp_handler, active);
+	install_root_end_handler(&vrrp_end_handler);
 #ifdef _HAVE_VRRP_VMAC_
 	install_keyword("use_vmac", &vrrp_vmac_handler);
 	install_keyword("vmac_xmit_base", &vrrp_vmac_xmit_base_handler);
@@ -1533,6 +1550,7 @@ init_vrrp_keywords(bool active)
 	install_keyword("fall", &vrrp_vscript_fall_handler);
 	install_keyword("user", &vrrp_vscript_user_handler);
 	install_keyword("init_fail", &vrrp_vscript_init_fail_handler);
+	install_keyword("persistent", &vrrp_vscript_persistent_handler);
 	install_sublevel_end_handler(&vrrp_vscript_end_handler);
 
 	/* Track file declarations */
@@ -28,6 +28,8 @@
 #include <inttypes.h>
 
 #include "logger.h"
+#include "scheduler.h"
+#include "memory.h"
 
 #include "vrrp.h"
 #include "vrrp_data.h"
@@ -96,5 +98,11 @@ vrrp_print_stats(void)
 		fprintf(file, "    Received: %" PRIu64 "\n", vrrp->stats->pri_zero_rcvd);
 		fprintf(file, "    Sent: %" PRIu64 "\n", vrrp->stats->pri_zero_sent);
 	}
+#ifdef _WITH_THREAD_STATS_
+	dump_thread_stats(master, file);
+#endif
+#ifdef _WITH_ALLOC_PROFILE_
+	alloc_profile_dump(file);
+#endif
 	fclose(file);
 }
@@ -30,6 +30,7 @@
 #endif
 #include <stdint.h>
 #include <stdio.h>
+#include <sys/wait.h>
 
 #include "vrrp_scheduler.h"
 #include "vrrp_track.h"
@@ -102,6 +103,8 @@ static thread_t *bfd_thread;		 /* BFD control pipe read thread */
  */
 
 static int vrrp_script_child_thread(thread_t *);
+static int vrrp_script_coproc_thread(thread_t *);
+static int vrrp_script_coproc_exit_thread(thread_t *);
 static int vrrp_script_thread(thread_t *);
 #ifdef _WITH_BFD_
 static int vrrp_bfd_thread(thread_t *);
@@ -385,16 +388,16 @@ vrrp_register_workers(list l)
 		/* Register a timer thread if interface exists */
 		if (sock->fd_in != -1)
 			//注册vrrp报文的读取时间，自sock->fd_in中读取vrrp报文
-			sock->thread = thread_add_read_sands(master, vrrp_read_dispatcher_thread,
-						       sock, sock->fd_in, vrrp_compute_timer(sock));
+			sock->thread = thread_add_persistent_read_sands(master, vrrp_read_dispatcher_thread,
+						       sock, sock->fd_in, vrrp_compute_timer(sock), false);
 	}
 }
 
 void
 vrrp_thread_add_read(vrrp_t *vrrp)
 {
-	vrrp->sockets->thread = thread_add_read_sands(master, vrrp_read_dispatcher_thread,
-						vrrp->sockets, vrrp->sockets->fd_in, vrrp_compute_timer(vrrp->sockets));
+	vrrp->sockets->thread = thread_add_persistent_read_sands(master, vrrp_read_dispatcher_thread,
+						vrrp->sockets, vrrp->sockets->fd_in, vrrp_compute_timer(vrrp->sockets), false);
 }
 
 /* VRRP dispatcher functions */
@@ -455,7 +458,7 @@ vrrp_create_sockpool(list l)
 			  (__test_bit(VRRP_VMAC_XMITBASE_BIT, &vrrp->vmac_flags)) ? vrrp->ifp->base_ifp :
 #endif
 										    vrrp->ifp;
-		unicast = !LIST_ISEMPTY(vrrp->unicast_peer);
+		unicast = !list_empty(&vrrp->unicast_peer);
 #if defined _WITH_VRRP_AUTH_
 		if (vrrp->auth_type == VRRP_AUTH_AH)
 			proto = IPPROTO_AH;
@@ -865,11 +868,14 @@ vrrp_read_dispatcher_thread(thread_t * thread)
 		//自sock中读取vrrp报文
 		fd = vrrp_dispatcher_read(sock);
 
-	/* register next dispatcher thread */
+	/* The thread stays registered for the next packet, with the
+	 * timeout of the next instance to expire */
 	if (fd != -1)
-		//注册下一次的读事件
-		sock->thread = thread_add_read_sands(thread->master, vrrp_read_dispatcher_thread,
-					       sock, fd, vrrp_compute_timer(sock));
+		thread->sands = *vrrp_compute_timer(sock);
+	else {
+		thread_del_persistent_read(thread);
+		sock->thread = NULL;
+	}
 	return 0;
 }
 
@@ -891,6 +897,20 @@ vrrp_script_thread(thread_t * thread)
 		return 0;
 	}
 
+	if (vscript->persistent) {
+		if (!vscript->coproc.pid &&
+		    coproc_start(thread->master, vrrp_script_coproc_exit_thread, vscript, &vscript->coproc, &vscript->script))
+			return -1;
+
+		/* If the request can't be sent, the script's exit gives the result */
+		if (coproc_request(thread->master, vrrp_script_coproc_thread, vscript, &vscript->coproc,
+				   vscript->sname, (vscript->timeout) ? vscript->timeout : vscript->interval))
+			coproc_kill(&vscript->coproc);
+		vscript->state = SCRIPT_STATE_RUNNING;
+
+		return 0;
+	}
+
 	/* Execute the script in a child process. Parent returns, child doesn't */
 	ret = system_call_script(thread->master, vrrp_script_child_thread,
 				  vscript, (vscript->timeout) ? vscript->timeout : vscript->interval,
@@ -901,65 +921,15 @@ vrrp_script_thread(thread_t * thread)
 	return ret;
 }
 
-static int
-vrrp_script_child_thread(thread_t * thread)
+/* Apply the result of running a script, given as a wait() status */
+static void
+vrrp_script_result(vrrp_script_t *vscript, int wait_status)
 {
-	int wait_status;
-	pid_t pid;
-	vrrp_script_t *vscript = THREAD_ARG(thread);
-	int sig_num;
-	unsigned timeout = 0;
 	char *script_exit_type = NULL;
 	bool script_success;
 	char *reason = NULL;
 	int reason_code;
 
-	if (thread->type == THREAD_CHILD_TIMEOUT) {
-		pid = THREAD_CHILD_PID(thread);
-
-		if (vscript->state == SCRIPT_STATE_RUNNING) {
-			vscript->state = SCRIPT_STATE_REQUESTING_TERMINATION;
-			sig_num = SIGTERM;
-			timeout = 2;
-		} else if (vscript->state == SCRIPT_STATE_REQUESTING_TERMINATION) {
-			vscript->state = SCRIPT_STATE_FORCING_TERMINATION;
-			sig_num = SIGKILL;
-			timeout = 2;
-		} else if (vscript->state == SCRIPT_STATE_FORCING_TERMINATION) {
-			log_message(LOG_INFO, "Child (PID %d) failed to terminate after kill", pid);
-			sig_num = SIGKILL;
-			timeout = 10;	/* Give it longer to terminate */
-		}
-
-		/* Kill it off. */
-		if (timeout) {
-			/* If kill returns an error, we can't kill the process since either the process has terminated,
-			 * or we don't have permission. If we can't kill it, there is no point trying again. */
-			if (kill(-pid, sig_num)) {
-				if (errno == ESRCH) {
-					/* The process does not exist; presumably it
-					 * has just terminated. We should get
-					 * notification of it's termination, so allow
-					 * that to handle it. */
-					timeout = 1;
-				} else {
-					log_message(LOG_INFO, "kill -%d of process %s(%d) with new state %d failed with errno %d", sig_num, vscript->script.args[0], pid, vscript->state, errno);
-					timeout = 1000;
-				}
-			}
-		} else if (vscript->state != SCRIPT_STATE_IDLE) {
-			log_message(LOG_INFO, "Child thread pid %d timeout with unknown script state %d", pid, vscript->state);
-			timeout = 10;	/* We need some timeout */
-		}
-
-		if (timeout)
-			thread_add_child(thread->master, vrrp_script_child_thread, vscript, pid, timeout * TIMER_HZ);
-
-		return 0;
-	}
-
-	wait_status = THREAD_CHILD_STATUS(thread);
-
 	if (WIFEXITED(wait_status)) {
 		int status = WEXITSTATUS(wait_status);
 
@@ -982,14 +952,6 @@ vrrp_script_child_thread(thread_t * thread)
 		vscript->last_status = status;
 	}
 	else if (WIFSIGNALED(wait_status)) {
-		if (vscript->state == SCRIPT_STATE_REQUESTING_TERMINATION && WTERMSIG(wait_status) == SIGTERM) {
-			/* The script terminated due to a SIGTERM, and we sent it a SIGTERM to
-			 * terminate the process. Now make sure any children it created have
-			 * died too. */
-			pid = THREAD_CHILD_PID(thread);
-			kill(-pid, SIGKILL);
-		}
-
 		/* We treat forced termination as a failure */
 		if ((vscript->state == SCRIPT_STATE_REQUESTING_TERMINATION && WTERMSIG(wait_status) == SIGTERM) ||
 		    (vscript->state == SCRIPT_STATE_FORCING_TERMINATION && (WTERMSIG(wait_status) == SIGKILL || WTERMSIG(wait_status) == SIGTERM)))
@@ -1032,6 +994,112 @@ vrrp_script_child_thread(thread_t * thread)
 
 	vscript->state = SCRIPT_STATE_IDLE;
 	vscript->init_state = SCRIPT_INIT_STATE_DONE;
+}
+
+static int
+vrrp_script_child_thread(thread_t * thread)
+{
+	int wait_status;
+	pid_t pid;
+	vrrp_script_t *vscript = THREAD_ARG(thread);
+	int sig_num;
+	unsigned timeout = 0;
+
+	if (thread->type == THREAD_CHILD_TIMEOUT) {
+		pid = THREAD_CHILD_PID(thread);
+
+		if (vscript->state == SCRIPT_STATE_RUNNING) {
+			vscript->state = SCRIPT_STATE_REQUESTING_TERMINATION;
+			sig_num = SIGTERM;
+			timeout = 2;
+		} else if (vscript->state == SCRIPT_STATE_REQUESTING_TERMINATION) {
+			vscript->state = SCRIPT_STATE_FORCING_TERMINATION;
+			sig_num = SIGKILL;
+			timeout = 2;
+		} else if (vscript->state == SCRIPT_STATE_FORCING_TERMINATION) {
+			log_message(LOG_INFO, "Child (PID %d) failed to terminate after kill", pid);
+			sig_num = SIGKILL;
+			timeout = 10;	/* Give it longer to terminate */
+		}
+
+		/* Kill it off. */
+		if (timeout) {
+			/* If kill returns an error, we can't kill the process since either the process has terminated,
+			 * or we don't have permission. If we can't kill it, there is no point trying again. */
+			if (kill(-pid, sig_num)) {
+				if (errno == ESRCH) {
+					/* The process does not exist; presumably it
+					 * has just terminated. We should get
+					 * notification of it's termination, so allow
+					 * that to handle it. */
+					timeout = 1;
+				} else {
+					log_message(LOG_INFO, "kill -%d of process %s(%d) with new state %d failed with errno %d", sig_num, vscript->script.args[0], pid, vscript->state, errno);
+					timeout = 1000;
+				}
+			}
+		} else if (vscript->state != SCRIPT_STATE_IDLE) {
+			log_message(LOG_INFO, "Child thread pid %d timeout with unknown script state %d", pid, vscript->state);
+			timeout = 10;	/* We need some timeout */
+		}
+
+		if (timeout)
+			thread_add_child(thread->master, vrrp_script_child_thread, vscript, pid, timeout * TIMER_HZ);
+
+		return 0;
+	}
+
+	wait_status = THREAD_CHILD_STATUS(thread);
+
+	if (WIFSIGNALED(wait_status) &&
+	    vscript->state == SCRIPT_STATE_REQUESTING_TERMINATION && WTERMSIG(wait_status) == SIGTERM) {
+		/* The script terminated due to a SIGTERM, and we sent it a SIGTERM to
+		 * terminate the process. Now make sure any children it created have
+		 * died too. */
+		pid = THREAD_CHILD_PID(thread);
+		kill(-pid, SIGKILL);
+	}
+
+	vrrp_script_result(vscript, wait_status);
+
+	return 0;
+}
+
+/* The reply of a persistent script is used as its exit status would be */
+static int
+vrrp_script_coproc_thread(thread_t * thread)
+{
+	vrrp_script_t *vscript = THREAD_ARG(thread);
+	int value;
+	int ret;
+
+	ret = coproc_read(thread, &vscript->coproc, &value);
+	if (ret > 0)
+		vrrp_script_result(vscript, W_EXITCODE(value, 0));
+	else if (ret < 0) {
+		/* It is killed, and its exit gives the result */
+		if (thread->type == THREAD_READ_TIMEOUT)
+			vscript->state = SCRIPT_STATE_FORCING_TERMINATION;
+		coproc_kill(&vscript->coproc);
+	}
+
+	return 0;
+}
+
+static int
+vrrp_script_coproc_exit_thread(thread_t * thread)
+{
+	vrrp_script_t *vscript = THREAD_ARG(thread);
+
+	if (thread->type != THREAD_CHILD_TERMINATED ||
+	    THREAD_CHILD_PID(thread) != vscript->coproc.pid)
+		return 0;
+
+	coproc_exited(&vscript->coproc, THREAD_CHILD_STATUS(thread));
+
+	/* If it exited while a request was outstanding, its exit status is the result */
+	if (vscript->state != SCRIPT_STATE_IDLE)
+		vrrp_script_result(vscript, THREAD_CHILD_STATUS(thread));
 
 	return 0;
 }
@@ -1174,6 +1242,19 @@ dump_threads(void)
 }
 #endif
 
+/* Adverts must not wait behind bulk work, or backups will take over. Track
+ * script intervals needn't be exact, so can be coalesced with timer_slack. */
+void
+set_vrrp_thread_priorities(void)
+{
+	thread_set_func_priority(master, vrrp_read_dispatcher_thread, THREAD_PRIO_CRITICAL);
+	thread_set_func_priority(master, vrrp_script_child_thread, THREAD_PRIO_BULK);
+	thread_set_func_priority(master, vrrp_script_coproc_thread, THREAD_PRIO_BULK);
+	thread_set_func_priority(master, vrrp_script_coproc_exit_thread, THREAD_PRIO_BULK);
+	thread_set_func_priority(master, child_killed_thread, THREAD_PRIO_BULK);
+	thread_set_func_slack(master, vrrp_script_thread);
+}
+
 #ifdef THREAD_DUMP
 void
 register_vrrp_scheduler_addresses(void)
@@ -1183,6 +1264,8 @@ register_vrrp_scheduler_addresses(void)
 	register_thread_address("vrrp_gratuitous_arp_thread", vrrp_gratuitous_arp_thread);
 	register_thread_address("vrrp_lower_prio_gratuitous_arp_thread", vrrp_lower_prio_gratuitous_arp_thread);
 	register_thread_address("vrrp_script_child_thread", vrrp_script_child_thread);
+	register_thread_address("vrrp_script_coproc_thread", vrrp_script_coproc_thread);
+	register_thread_address("vrrp_script_coproc_exit_thread", vrrp_script_coproc_exit_thread);
 	register_thread_address("vrrp_script_thread", vrrp_script_thread);
 	register_thread_address("vrrp_read_dispatcher_thread", vrrp_read_dispatcher_thread);
 #ifdef _WITH_BFD_
@@ -36,16 +36,7 @@
 vrrp_t *
 vrrp_get_instance(char *iname)
 {
-	vrrp_t *vrrp;
-	list l = vrrp_data->vrrp;
-	element e;
-
-	for (e = LIST_HEAD(l); e; ELEMENT_NEXT(e)) {
-		vrrp = ELEMENT_DATA(e);
-		if (strcmp(vrrp->iname, iname) == 0)
-			return vrrp;
-	}
-	return NULL;
+	return name_table_lookup(vrrp_data->vrrp_name_index, iname);
 }
 
 /* Set instances group pointer */
@@ -154,18 +154,7 @@ alloc_group_track_if(vrrp_sgroup_t *sgroup, vector_t *strvec)
 vrrp_script_t *
 find_script_by_name(char *name)
 {
-	element e;
-	vrrp_script_t *scr;
-
-	if (LIST_ISEMPTY(vrrp_data->vrrp_script))
-		return NULL;
-
-	for (e = LIST_HEAD(vrrp_data->vrrp_script); e; ELEMENT_NEXT(e)) {
-		scr = ELEMENT_DATA(e);
-		if (!strcmp(scr->sname, name))
-			return scr;
-	}
-	return NULL;
+	return name_table_lookup(vrrp_data->vrrp_script_index, name);
 }
 
 /* Track script dump */
@@ -293,18 +282,7 @@ alloc_group_track_script(vrrp_sgroup_t *sgroup, vector_t *strvec)
 vrrp_tracked_file_t *
 find_tracked_file_by_name(const char *name)
 {
-	element e;
-	vrrp_tracked_file_t *file;
-
-	if (LIST_ISEMPTY(vrrp_data->vrrp_track_files))
-		return NULL;
-
-	for (e = LIST_HEAD(vrrp_data->vrrp_track_files); e; ELEMENT_NEXT(e)) {
-		file = ELEMENT_DATA(e);
-		if (!strcmp(file->fname, name))
-			return file;
-	}
-	return NULL;
+	return name_table_lookup(vrrp_data->vrrp_track_file_index, name);
 }
 
 /* Track file dump */
@@ -435,14 +413,7 @@ alloc_group_track_file(vrrp_sgroup_t *sgroup, vector_t *strvec)
 vrrp_tracked_bfd_t *
 find_vrrp_tracked_bfd_by_name(const char *name)
 {
-	element e;
-	vrrp_tracked_bfd_t *bfd;
-
-	LIST_FOREACH(vrrp_data->vrrp_track_bfds, bfd, e) {
-		if (!strcmp(bfd->bname, name))
-			return bfd;
-	}
-	return NULL;
+	return name_table_lookup(vrrp_data->vrrp_track_bfd_index, name);
 }
 
 /* Track bfd dump */
@@ -872,6 +843,7 @@ remove_track_file(list track_files, element e)
 		}
 	}
 
+	name_table_remove(vrrp_data->vrrp_track_file_index, tfile->fname, tfile);
 	free_list_element(track_files, e);
 }
 
@@ -0,0 +1,210 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        Minimal io_uring support, used by the scheduler in place
+ *              of epoll. The rings are set up and driven with the raw
+ *              system calls, so there is no dependency on liburing.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2001-2018 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "io_uring.h"
+#include "memory.h"
+#include "logger.h"
+
+/* Global vars */
+pid_t uring_pid;
+
+static void
+uring_atfork_child(void)
+{
+	uring_pid = getpid();
+}
+
+static inline int
+sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int
+sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+uring_t *
+uring_init(unsigned entries)
+{
+	struct io_uring_params p;
+	uring_t *ring;
+	int fd;
+
+	if (!uring_pid) {
+		uring_pid = getpid();
+		pthread_atfork(NULL, NULL, uring_atfork_child);
+	}
+
+	memset(&p, 0, sizeof(p));
+	fd = sys_io_uring_setup(entries, &p);
+	if (fd < 0)
+		return NULL;
+
+	/* The poll requests we use need the kernel to own the SQEs once
+	 * submitted, and to keep completions it can't post yet */
+	if (!(p.features & IORING_FEAT_NODROP) ||
+	    !(p.features & IORING_FEAT_SUBMIT_STABLE)) {
+		close(fd);
+		errno = ENOTSUP;
+		return NULL;
+	}
+
+	PMALLOC(ring);
+	ring->fd = fd;
+	ring->pid = uring_pid;
+
+	ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_ring_size > ring->sq_ring_size)
+			ring->sq_ring_size = ring->cq_ring_size;
+		ring->cq_ring_size = ring->sq_ring_size;
+	}
+
+	ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+			     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (ring->sq_ring == MAP_FAILED)
+		goto err;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		ring->cq_ring = ring->sq_ring;
+	else {
+		ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+				     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (ring->cq_ring == MAP_FAILED) {
+			ring->cq_ring = NULL;
+			goto err;
+		}
+	}
+
+	ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+			  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		ring->sqes = NULL;
+		goto err;
+	}
+
+	ring->sq_head = (unsigned *)((char *)ring->sq_ring + p.sq_off.head);
+	ring->sq_tail = (unsigned *)((char *)ring->sq_ring + p.sq_off.tail);
+	ring->sq_mask = *(unsigned *)((char *)ring->sq_ring + p.sq_off.ring_mask);
+	ring->sq_entries = p.sq_entries;
+	ring->sq_array = (unsigned *)((char *)ring->sq_ring + p.sq_off.array);
+
+	ring->cq_head = (unsigned *)((char *)ring->cq_ring + p.cq_off.head);
+	ring->cq_tail = (unsigned *)((char *)ring->cq_ring + p.cq_off.tail);
+	ring->cq_mask = *(unsigned *)((char *)ring->cq_ring + p.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)((char *)ring->cq_ring + p.cq_off.cqes);
+
+	return ring;
+
+err:
+	if (ring->sq_ring == MAP_FAILED)
+		ring->sq_ring = NULL;
+	uring_destroy(ring);
+	return NULL;
+}
+
+void
+uring_destroy(uring_t *ring)
+{
+	if (ring->sqes)
+		munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_ring && ring->cq_ring != ring->sq_ring)
+		munmap(ring->cq_ring, ring->cq_ring_size);
+	if (ring->sq_ring)
+		munmap(ring->sq_ring, ring->sq_ring_size);
+	close(ring->fd);
+	FREE(ring);
+}
+
+/* Returns a zeroed SQE to fill in. The SQEs are only passed to the kernel by
+ * uring_enter(), unless the submission queue is full. */
+struct io_uring_sqe *
+uring_get_sqe(uring_t *ring)
+{
+	struct io_uring_sqe *sqe;
+	unsigned tail = *ring->sq_tail;
+	unsigned index;
+
+	if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+		if (uring_enter(ring, 0) < 0 && errno != EINTR)
+			log_message(LOG_INFO, "io_uring: error flushing submission queue (%m)");
+		if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries)
+			return NULL;
+	}
+
+	index = tail & ring->sq_mask;
+	sqe = &ring->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	ring->sq_array[index] = index;
+
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	ring->sq_queued++;
+
+	return sqe;
+}
+
+/* Submit the queued SQEs and, if wait_nr is not 0, wait for that many
+ * completions */
+int
+uring_enter(uring_t *ring, unsigned wait_nr)
+{
+	int ret;
+
+	ret = sys_io_uring_enter(ring->fd, ring->sq_queued, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0);
+	if (ret >= 0)
+		ring->sq_queued -= (unsigned)ret < ring->sq_queued ? (unsigned)ret : ring->sq_queued;
+
+	return ret;
+}
+
+struct io_uring_cqe *
+uring_peek_cqe(uring_t *ring)
+{
+	unsigned head = *ring->cq_head;
+
+	if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+		return NULL;
+
+	return &ring->cqes[head & ring->cq_mask];
+}
+
+void
+uring_cqe_seen(uring_t *ring)
+{
+	__atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
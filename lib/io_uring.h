@@ -0,0 +1,86 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        io_uring.c include file.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2001-2018 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#ifndef _IO_URING_H
+#define _IO_URING_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <linux/io_uring.h>
+
+/* Headers from before Linux 5.13 lack multishot polls; the kernel may
+ * still reject them at run time */
+#ifndef IORING_POLL_ADD_MULTI
+#define IORING_POLL_ADD_MULTI	(1U << 0)
+#endif
+#ifndef IORING_CQE_F_MORE
+#define IORING_CQE_F_MORE	(1U << 1)
+#endif
+
+/* A minimal io_uring, driven directly through the system calls */
+typedef struct _uring {
+	int			fd;
+	pid_t			pid;		/* of the process that set it up */
+
+	/* Submission queue */
+	unsigned		*sq_head;
+	unsigned		*sq_tail;
+	unsigned		sq_mask;
+	unsigned		sq_entries;
+	unsigned		*sq_array;
+	struct io_uring_sqe	*sqes;
+	unsigned		sq_queued;	/* SQEs not yet passed to the kernel */
+
+	/* Completion queue */
+	unsigned		*cq_head;
+	unsigned		*cq_tail;
+	unsigned		cq_mask;
+	struct io_uring_cqe	*cqes;
+
+	void			*sq_ring;
+	size_t			sq_ring_size;
+	void			*cq_ring;
+	size_t			cq_ring_size;
+	size_t			sqes_size;
+} uring_t;
+
+/* Global vars */
+extern pid_t uring_pid;
+
+/* After a fork the child shares the parent's rings, and must not submit
+ * anything on them */
+static inline bool
+uring_owned(const uring_t *ring)
+{
+	return ring->pid == uring_pid;
+}
+
+/* Prototypes */
+extern uring_t *uring_init(unsigned);
+extern void uring_destroy(uring_t *);
+extern struct io_uring_sqe *uring_get_sqe(uring_t *);
+extern int uring_enter(uring_t *, unsigned);
+extern struct io_uring_cqe *uring_peek_cqe(uring_t *);
+extern void uring_cqe_seen(uring_t *);
+
+#endif
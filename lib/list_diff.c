@@ -0,0 +1,122 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        Matching old and new objects on reload.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2001-2017 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+
+#include "config.h"
+
+#include "list_diff.h"
+#include "memory.h"
+
+static inline unsigned
+list_diff_bucket(const list_diff_t *diff, uint64_t hash)
+{
+	return (unsigned)((hash * 0x9e3779b97f4a7c15ULL) >> (64 - diff->bits));
+}
+
+static void
+list_diff_add(list_diff_t *diff, list l)
+{
+	element e;
+
+	for (e = LIST_HEAD(l); e; ELEMENT_NEXT(e))
+		diff->entries[diff->count++].data = ELEMENT_DATA(e);
+}
+
+/* Index the objects of new_list, and then of new_list2, which may be NULL */
+list_diff_t *
+alloc_list_diff(list_diff_hash_fn hash, list_diff_match_fn match, list new_list, list new_list2)
+{
+	list_diff_t *diff;
+	unsigned size = 0;
+	unsigned i;
+	uint64_t h;
+
+	PMALLOC(diff);
+	diff->hash = hash;
+	diff->match = match;
+
+	if (!LIST_ISEMPTY(new_list))
+		size += LIST_SIZE(new_list);
+	if (!LIST_ISEMPTY(new_list2))
+		size += LIST_SIZE(new_list2);
+	if (!size)
+		return diff;
+
+	diff->entries = MALLOC(size * sizeof(*diff->entries));
+	list_diff_add(diff, new_list);
+	list_diff_add(diff, new_list2);
+
+	if (diff->count < LIST_DIFF_MIN_HASH)
+		return diff;
+
+	for (diff->bits = 1; (1U << diff->bits) < diff->count; diff->bits++);
+	diff->buckets = MALLOC(sizeof(*diff->buckets) << diff->bits);
+
+	/* Adding from the end keeps each bucket in list order */
+	for (i = diff->count; i-- > 0; ) {
+		h = diff->entries[i].hash = hash(diff->entries[i].data);
+		diff->entries[i].next = diff->buckets[list_diff_bucket(diff, h)];
+		diff->buckets[list_diff_bucket(diff, h)] = i + 1;
+	}
+
+	return diff;
+}
+
+void
+free_list_diff(list_diff_t **diffp)
+{
+	list_diff_t *diff = *diffp;
+
+	if (!diff)
+		return;
+
+	FREE_PTR(diff->entries);
+	FREE_PTR(diff->buckets);
+	FREE(diff);
+	*diffp = NULL;
+}
+
+/* Returns the first indexed object that matches old_obj, or NULL */
+void *
+list_diff_find(const list_diff_t *diff, const void *old_obj)
+{
+	const list_diff_entry_t *entry;
+	uint64_t h;
+	unsigned i;
+
+	if (!diff->bits) {
+		for (i = 0; i < diff->count; i++) {
+			if (diff->match(old_obj, diff->entries[i].data))
+				return diff->entries[i].data;
+		}
+		return NULL;
+	}
+
+	h = diff->hash(old_obj);
+	for (i = diff->buckets[list_diff_bucket(diff, h)]; i; i = entry->next) {
+		entry = &diff->entries[i - 1];
+		if (entry->hash == h && diff->match(old_obj, entry->data))
+			return entry->data;
+	}
+
+	return NULL;
+}
@@ -0,0 +1,65 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        list_diff.c include file.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2001-2017 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+
+#ifndef _LIST_DIFF_H
+#define _LIST_DIFF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "list.h"
+
+/* Finds the objects of an old configuration in a new one when reloading.
+ * Each object type supplies a hash of the fields that identify it, and a
+ * match function (usually its _ISEQ test) which is only called for new
+ * objects with the same hash. The hash need not be well mixed; packing
+ * the identifying fields into it is enough. The new objects are indexed once, so
+ * matching every old object takes linear rather than quadratic time.
+ * As with a scan of the list, the first matching object is found. */
+typedef uint64_t (*list_diff_hash_fn)(const void *);
+typedef bool (*list_diff_match_fn)(const void *, const void *);
+
+typedef struct _list_diff_entry {
+	void			*data;
+	uint64_t		hash;
+	unsigned		next;		/* 1 + index of next entry in bucket */
+} list_diff_entry_t;
+
+typedef struct _list_diff {
+	list_diff_hash_fn	hash;
+	list_diff_match_fn	match;
+	list_diff_entry_t	*entries;	/* in list order */
+	unsigned		count;
+	unsigned		*buckets;	/* 1 + index of first entry, or 0 */
+	unsigned		bits;		/* 0 if too few entries to hash */
+} list_diff_t;
+
+/* Lists shorter than this are just scanned */
+#define LIST_DIFF_MIN_HASH	8
+
+/* Prototypes defs */
+extern list_diff_t *alloc_list_diff(list_diff_hash_fn, list_diff_match_fn, list, list);
+extern void free_list_diff(list_diff_t **);
+extern void *list_diff_find(const list_diff_t *, const void *);
+
+#endif
@@ -204,6 +204,21 @@ static inline int list_empty(const struct list_head *head)
 	return head->next == head;
 }
 
+/**
+ * list_count - count the entries in a list
+ * @head: the list to count.
+ */
+static inline unsigned list_count(const struct list_head *head)
+{
+	const struct list_head *pos;
+	unsigned count = 0;
+
+	for (pos = head->next; pos != head; pos = pos->next)
+		count++;
+
+	return count;
+}
+
 static inline void __list_splice(struct list_head *list,
 				 struct list_head *head)
 {
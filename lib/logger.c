@@ -29,10 +29,20 @@
 #include <fcntl.h>
 #include <string.h>
 #include <memory.h>
+#include <errno.h>
+#ifdef _WITH_ASYNC_LOG_
+#include <pthread.h>
+#include <stdlib.h>
+#include <signal.h>
+#endif
 
 #include "logger.h"
 #include "bitops.h"
 #include "utils.h"
+#include "timer.h"
+#ifdef _WITH_ASYNC_LOG_
+#include "memory.h"
+#endif
 
 /* Boolean flag - send messages to console as well as syslog */
 static bool log_console = false;
@@ -44,6 +54,52 @@ static FILE *log_file;
 bool always_flush_log_file;
 #endif
 
+#ifdef _WITH_ASYNC_LOG_
+/* With async_log, callers format their messages into a ring of fixed size
+ * entries, and a drain thread writes them to syslog, the log file and the
+ * console, so that a slow or backed up syslog socket doesn't hold up the
+ * VRRP or checker process. If the ring is full the message is dropped, and
+ * the number dropped is logged once the drain thread catches up.
+ *
+ * The head and tail are free running counts of the entries written and
+ * drained. Entries between the tail and the head belong to the drain
+ * thread until it advances the tail. */
+typedef struct _async_log_entry {
+	int		facility;
+	time_t		time;
+	char		text[2 * MAX_LOG_MSG + 1];
+} async_log_entry_t;
+
+static async_log_entry_t *async_log_ring;
+static unsigned async_log_slots;
+static unsigned async_log_head;
+static unsigned async_log_tail;
+static unsigned async_log_dropped;
+static bool async_log_running;
+static bool async_log_stopping;
+static bool async_log_waiting;		/* drain thread is waiting for entries */
+static pthread_t async_log_thread;
+static pthread_mutex_t async_log_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t async_log_cond = PTHREAD_COND_INITIALIZER;
+
+/* Held while writing to the log file, so it isn't closed under the drain thread */
+static pthread_mutex_t log_write_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOG_WRITE_LOCK()	pthread_mutex_lock(&log_write_lock)
+#define LOG_WRITE_UNLOCK()	pthread_mutex_unlock(&log_write_lock)
+#else
+#define LOG_WRITE_LOCK()
+#define LOG_WRITE_UNLOCK()
+#endif
+
+const char * const log_priority_names[LOG_DEBUG + 1] = {
+	"emerg", "alert", "crit", "err", "warning", "notice", "info", "debug"
+};
+
+/* Limits for log_message_rl(), indexed by priority */
+static log_rate_limit_t log_rate_limits[LOG_DEBUG + 1] = {
+	[0 ... LOG_DEBUG] = { LOG_RATE_DEFAULT, LOG_BURST_DEFAULT }
+};
+
 void
 enable_console_log(void)
 {
@@ -60,10 +116,12 @@ set_flush_log_file(void)
 void
 close_log_file(void)
 {
+	LOG_WRITE_LOCK();
 	if (log_file) {
 		fclose(log_file);
 		log_file = NULL;
 	}
+	LOG_WRITE_UNLOCK();
 }
 
 void
@@ -71,22 +129,21 @@ open_log_file(const char *name, const char *prog, const char *namespace, const c
 {
 	char *file_name;
 
-	if (log_file) {
-		fclose(log_file);
-		log_file = NULL;
-	}
+	close_log_file();
 
 	if (!name)
 		return;
 
 	file_name = make_file_name(name, prog, namespace, instance);
 
+	LOG_WRITE_LOCK();
 	log_file = fopen_safe(file_name, "a");
 	if (log_file) {
 		int n = fileno(log_file);
 		fcntl(n, F_SETFD, FD_CLOEXEC | fcntl(n, F_GETFD));
 		fcntl(n, F_SETFL, O_NONBLOCK | fcntl(n, F_GETFL));
 	}
+	LOG_WRITE_UNLOCK();
 
 	FREE(file_name);
 }
@@ -94,8 +151,10 @@ open_log_file(const char *name, const char *prog, const char *namespace, const c
 void
 flush_log_file(void)
 {
+	LOG_WRITE_LOCK();
 	if (log_file)
 		fflush(log_file);
+	LOG_WRITE_UNLOCK();
 }
 
 void
@@ -106,10 +165,218 @@ update_log_file_perms(mode_t umask_bits)
 }
 #endif
 
+#ifdef _WITH_ASYNC_LOG_
+/* Called by the drain thread, with log_write_lock held */
+static void
+async_log_write(const async_log_entry_t *entry)
+{
+	static time_t last_time;
+	static char timestamp[64];
+	struct tm tm;
+
+	if (
+#ifdef ENABLE_LOG_TO_FILE
+	    log_file ||
+#endif
+			(__test_bit(DONT_FORK_BIT, &debug) && log_console)) {
+		/* The timestamp only changes once a second */
+		if (entry->time != last_time) {
+			localtime_r(&entry->time, &tm);
+			strftime(timestamp, sizeof(timestamp), "%c", &tm);
+			last_time = entry->time;
+		}
+
+		if (log_console && __test_bit(DONT_FORK_BIT, &debug))
+			fprintf(stderr, "%s: %s\n", timestamp, entry->text);
+#ifdef ENABLE_LOG_TO_FILE
+		if (log_file) {
+			fprintf(log_file, "%s: %s\n", timestamp, entry->text);
+			if (always_flush_log_file)
+				fflush(log_file);
+		}
+#endif
+	}
+
+	if (!__test_bit(NO_SYSLOG_BIT, &debug))
+		syslog(entry->facility, "%s", entry->text);
+}
+
+static void *
+async_log_drain(__attribute__((unused)) void *arg)
+{
+	async_log_entry_t dropped_entry = { .facility = LOG_WARNING };
+	unsigned head, tail, dropped;
+
+	pthread_mutex_lock(&async_log_lock);
+	for (;;) {
+		while (async_log_head == async_log_tail && !async_log_dropped && !async_log_stopping) {
+			async_log_waiting = true;
+			pthread_cond_wait(&async_log_cond, &async_log_lock);
+		}
+		async_log_waiting = false;
+
+		/* When stopping, everything logged so far is written first */
+		if (async_log_head == async_log_tail && !async_log_dropped)
+			break;
+
+		head = async_log_head;
+		tail = async_log_tail;
+		dropped = async_log_dropped;
+		async_log_dropped = 0;
+		pthread_mutex_unlock(&async_log_lock);
+
+		LOG_WRITE_LOCK();
+		for (; tail != head; tail++)
+			async_log_write(&async_log_ring[tail % async_log_slots]);
+		if (dropped) {
+			dropped_entry.time = time(NULL);
+			snprintf(dropped_entry.text, sizeof(dropped_entry.text), "Log buffer full - %u messages dropped", dropped);
+			async_log_write(&dropped_entry);
+		}
+		LOG_WRITE_UNLOCK();
+
+		pthread_mutex_lock(&async_log_lock);
+		async_log_tail = tail;
+	}
+	pthread_mutex_unlock(&async_log_lock);
+
+	return NULL;
+}
+
+/* Returns false if the message should be logged synchronously */
+static bool
+async_log_message(int facility, const char *format, va_list args)
+{
+	char text[sizeof(async_log_ring->text)];
+	async_log_entry_t *entry;
+	size_t len;
+
+	/* Format before taking the lock. The time is the scheduler's, which is
+	 * updated each time round its loop, if this thread has one. */
+	len = (size_t)vsnprintf(text, sizeof(text), format, args);
+	if (len >= sizeof(text))
+		len = sizeof(text) - 1;
+
+	pthread_mutex_lock(&async_log_lock);
+	if (!async_log_running || async_log_stopping) {
+		pthread_mutex_unlock(&async_log_lock);
+		return false;
+	}
+
+	if (async_log_head - async_log_tail >= async_log_slots)
+		async_log_dropped++;
+	else {
+		entry = &async_log_ring[async_log_head % async_log_slots];
+		entry->facility = facility;
+		entry->time = time_now.tv_sec ? time_now.tv_sec : time(NULL);
+		memcpy(entry->text, text, len + 1);
+		async_log_head++;
+	}
+
+	/* Only wake the drain thread if it is waiting */
+	if (async_log_waiting) {
+		async_log_waiting = false;
+		pthread_cond_signal(&async_log_cond);
+	}
+	pthread_mutex_unlock(&async_log_lock);
+
+	return true;
+}
+
+/* A child process has no drain thread, and the locks may have been held
+ * by the parent's drain thread when fork() was called */
+static void
+async_log_child(void)
+{
+	pthread_mutex_init(&async_log_lock, NULL);
+	pthread_cond_init(&async_log_cond, NULL);
+	pthread_mutex_init(&log_write_lock, NULL);
+	async_log_running = false;
+	async_log_stopping = false;
+	async_log_waiting = false;
+	async_log_head = async_log_tail = async_log_dropped = 0;
+}
+
+static void
+async_log_exit(void)
+{
+	set_async_log(0);
+}
+
+/* Start logging through a ring of slots entries, or stop if slots is 0.
+ * Stopping writes out any messages not yet logged. */
+void
+set_async_log(unsigned slots)
+{
+	static bool registered;
+	sigset_t sigs, old_sigs;
+	int ret;
+
+	if (async_log_running) {
+		if (slots == async_log_slots)
+			return;
+
+		pthread_mutex_lock(&async_log_lock);
+		async_log_stopping = true;
+		pthread_cond_signal(&async_log_cond);
+		pthread_mutex_unlock(&async_log_lock);
+		pthread_join(async_log_thread, NULL);
+
+		async_log_running = false;
+		async_log_stopping = false;
+	}
+
+	if (slots != async_log_slots) {
+		FREE_PTR(async_log_ring);
+		async_log_slots = 0;
+	}
+
+	if (!slots)
+		return;
+
+	if (!registered) {
+		pthread_atfork(NULL, NULL, async_log_child);
+		atexit(async_log_exit);
+		registered = true;
+	}
+
+	if (!async_log_ring) {
+		async_log_ring = MALLOC(slots * sizeof(*async_log_ring));
+		async_log_slots = slots;
+	}
+	async_log_head = async_log_tail = async_log_dropped = 0;
+
+	/* Signals are handled by the main thread */
+	sigfillset(&sigs);
+	pthread_sigmask(SIG_BLOCK, &sigs, &old_sigs);
+	ret = pthread_create(&async_log_thread, NULL, async_log_drain, NULL);
+	pthread_sigmask(SIG_SETMASK, &old_sigs, NULL);
+
+	if (ret) {
+		log_message(LOG_INFO, "Unable to start asynchronous logging - error %d", ret);
+		return;
+	}
+
+	async_log_running = true;
+}
+#endif
+
 //日志输出
 void
 vlog_message(const int facility, const char* format, va_list args)
 {
+#ifdef _WITH_ASYNC_LOG_
+	if (async_log_running) {
+		va_list args1;
+		bool queued;
+
+		va_copy(args1, args);
+		queued = async_log_message(facility, format, args1);
+		va_end(args1);
+		if (queued)
+			return;
+	}
+#endif
 #if !HAVE_VSYSLOG
 	char buf[MAX_LOG_MSG+1];
 
@@ -174,6 +441,58 @@ log_message(const int facility, const char *format, ...)
 	va_end(args);
 }
 
+void
+set_log_rate_limits(const log_rate_limit_t *limits)
+{
+	memcpy(log_rate_limits, limits, sizeof(log_rate_limits));
+}
+
+/* Token bucket for a call site of log_message_rl(). Each message costs
+ * TIMER_HZ tokens, and rate * TIMER_HZ tokens are added each second, up
+ * to burst messages' worth. The scheduler's time is used if this thread
+ * has one, so a burst handled in one pass of the scheduler loop is not
+ * refilled part way through. */
+bool
+log_ratelimit(log_ratelimit_t *rl, int priority, const char *func)
+{
+	const log_rate_limit_t *limit = &log_rate_limits[LOG_PRI(priority)];
+	uint64_t full, now, elapsed;
+	int saved_errno;
+
+	if (!limit->rate)
+		return true;
+
+	now = timer_long(time_now.tv_sec ? time_now : timer_now());
+	full = (uint64_t)(limit->burst ? limit->burst : 1) * TIMER_HZ;
+
+	if (!rl->last)
+		rl->tokens = full;
+	else if (now > rl->last) {
+		elapsed = now - rl->last;
+		if (elapsed >= full / limit->rate)
+			rl->tokens = full;
+		else if ((rl->tokens += elapsed * limit->rate) > full)
+			rl->tokens = full;
+	}
+	rl->last = now;
+
+	if (rl->tokens < TIMER_HZ) {
+		rl->suppressed++;
+		return false;
+	}
+	rl->tokens -= TIMER_HZ;
+
+	if (rl->suppressed) {
+		/* The caller's message may use %m */
+		saved_errno = errno;
+		log_message(priority, "%s: %u messages suppressed", func, rl->suppressed);
+		errno = saved_errno;
+		rl->suppressed = 0;
+	}
+
+	return true;
+}
+
 //配置文件输出
 void
 conf_write(FILE *fp, const char *format, ...)
@@ -29,9 +29,48 @@
 #ifdef ENABLE_LOG_TO_FILE
 #include <sys/stat.h>
 #endif
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timer.h"
 
 #define	MAX_LOG_MSG	255
 
+#ifdef _WITH_ASYNC_LOG_
+#define ASYNC_LOG_DEFAULT_SLOTS	1024
+#define ASYNC_LOG_MIN_SLOTS	16
+#define ASYNC_LOG_MAX_SLOTS	1048576
+#endif
+
+/* Default limits for log_message_rl(), per priority */
+#define LOG_RATE_DEFAULT	10	/* messages per second */
+#define LOG_BURST_DEFAULT	100
+
+typedef struct _log_rate_limit {
+	unsigned	rate;		/* messages per second, 0 for no limit */
+	unsigned	burst;
+} log_rate_limit_t;
+
+/* Token bucket of a log_message_rl() call site */
+typedef struct _log_ratelimit {
+	uint64_t	tokens;		/* a message costs TIMER_HZ */
+	uint64_t	last;		/* usecs */
+	unsigned	suppressed;
+} log_ratelimit_t;
+
+/* As log_message(), but each call site is limited to the rate set for the
+ * priority, and reports how many messages it suppressed when it next logs */
+#define log_ratelimit_ok(priority)							\
+	({										\
+		static THREAD_LOCAL log_ratelimit_t log_ratelimit_state;			\
+		log_ratelimit(&log_ratelimit_state, priority, __func__);		\
+	})
+#define log_message_rl(priority, ...)							\
+	do {										\
+		if (log_ratelimit_ok(priority))						\
+			log_message(priority, __VA_ARGS__);				\
+	} while (0)
+
 #ifdef ENABLE_LOG_TO_FILE
 extern char *log_file_name;
 #endif
@@ -44,10 +83,17 @@ extern void open_log_file(const char *, const char *, const char *, const char *
 extern void flush_log_file(void);
 extern void update_log_file_perms(mode_t);
 #endif
+#ifdef _WITH_ASYNC_LOG_
+extern void set_async_log(unsigned);
+#endif
 extern void vlog_message(const int facility, const char* format, va_list args)
 	__attribute__ ((format (printf, 2, 0)));
 extern void log_message(int priority, const char* format, ...)
 	__attribute__ ((format (printf, 2, 3)));
+extern const char * const log_priority_names[LOG_DEBUG + 1];
+
+extern void set_log_rate_limits(const log_rate_limit_t *);
+extern bool log_ratelimit(log_ratelimit_t *, int, const char *);
 extern void conf_write(FILE *fp, const char *format, ...)
 	__attribute__ ((format (printf, 2, 3)));
 
@@ -36,6 +36,15 @@
 
 #include <errno.h>
 #include <string.h>
+#if !defined _MEM_CHECK_ && defined _WITH_CHECKER_THREADS_
+#include <pthread.h>
+#endif
+#ifdef _WITH_ALLOC_PROFILE_
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#endif
 
 #include "memory.h"
 #include "utils.h"
@@ -79,10 +88,679 @@ xalloc(unsigned long size)
 	return mem;
 }
 
+#ifndef _MEM_CHECK_
+/* Configuration generation arenas.
+ *
+ * Everything allocated while a configuration is being parsed lives as long
+ * as that configuration, so it is carved out of large chunks owned by the
+ * generation instead of being malloc'd object by object. FREE() of an
+ * object in an arena just counts it (small objects are recycled while the
+ * arena is still being filled), and the whole generation is given back in
+ * one go by mem_arena_release() once the reload has finished with it.
+ *
+ * Each object is preceded by its rounded size, so that REALLOC can move it
+ * out of the arena. */
+#define ARENA_ALIGN		16
+#define ARENA_HDR		sizeof(size_t)
+#define ARENA_CHUNK_MIN		(64 * 1024)
+#define ARENA_CHUNK_MAX		(1024 * 1024)
+#define ARENA_REUSE_MAX		512		/* largest unit put on a free list */
+
+typedef struct _mem_arena_chunk {
+	struct _mem_arena_chunk	*next;
+	size_t			size;
+	char			data[] __attribute__((aligned(ARENA_ALIGN)));
+} mem_arena_chunk_t;
+
+struct _mem_arena {
+	char			*next;		/* bump pointer in the current chunk */
+	char			*end;
+	size_t			chunk_size;	/* size of the next chunk */
+	mem_arena_chunk_t	*chunks;
+	void			*free_list[ARENA_REUSE_MAX / ARENA_ALIGN + 1];
+	mem_arena_stats_t	stats;
+};
+
+/* Address ranges of all arena chunks, sorted, so FREE can tell arena
+ * objects from heap ones */
+typedef struct _arena_range {
+	const char		*start;
+	const char		*end;
+	mem_arena_t		*arena;
+} arena_range_t;
+
+static arena_range_t *arena_ranges;
+static unsigned arena_ranges_num;
+static unsigned arena_ranges_max;
+static const char *arena_lo, *arena_hi;
+static unsigned arena_generation;
+
+/* Only the thread parsing the configuration allocates from an arena */
+static THREAD_LOCAL mem_arena_t *current_arena;
+
+#ifdef _WITH_CHECKER_THREADS_
+/* Checker worker threads FREE heap memory while the range table may be updated */
+static pthread_mutex_t arena_lock = PTHREAD_MUTEX_INITIALIZER;
+#define arena_table_lock()	pthread_mutex_lock(&arena_lock)
+#define arena_table_unlock()	pthread_mutex_unlock(&arena_lock)
+#else
+#define arena_table_lock()
+#define arena_table_unlock()
+#endif
+
+/* The bounds are also read without the lock, by arena_may_own() */
+static void
+arena_bounds_update(void)
+{
+	__atomic_store_n(&arena_lo, arena_ranges_num ? arena_ranges[0].start : NULL, __ATOMIC_RELAXED);
+	__atomic_store_n(&arena_hi, arena_ranges_num ? arena_ranges[arena_ranges_num - 1].end : NULL, __ATOMIC_RELAXED);
+}
+
+/* Whether p might be in an arena, checked without taking the lock, so that
+ * frees of heap memory (all a checker worker thread ever frees) don't
+ * serialise. A chunk is added before any pointer into it can reach another
+ * thread, and a pointer into an arena being released is not valid, so a
+ * pointer outside the bounds is never an arena object. */
+static inline bool
+arena_may_own(const void *p)
+{
+	const char *lo = __atomic_load_n(&arena_lo, __ATOMIC_RELAXED);
+
+	return lo && (const char *)p >= lo && (const char *)p < __atomic_load_n(&arena_hi, __ATOMIC_RELAXED);
+}
+
+static void
+arena_range_add(mem_arena_t *arena, mem_arena_chunk_t *chunk)
+{
+	arena_range_t *ranges;
+	unsigned i;
+
+	arena_table_lock();
+
+	if (arena_ranges_num == arena_ranges_max) {
+		ranges = realloc(arena_ranges, (arena_ranges_max + 32) * sizeof(*ranges));
+		if (!ranges) {
+			log_message(LOG_INFO, "Keepalived arena range table error - %s", strerror(errno));
+			exit(KEEPALIVED_EXIT_NO_MEMORY);
+		}
+		arena_ranges = ranges;
+		arena_ranges_max += 32;
+	}
+
+	for (i = arena_ranges_num; i > 0 && arena_ranges[i - 1].start > (char *)chunk; i--)
+		arena_ranges[i] = arena_ranges[i - 1];
+	arena_ranges[i].start = (char *)chunk;
+	arena_ranges[i].end = (char *)chunk + sizeof(*chunk) + chunk->size;
+	arena_ranges[i].arena = arena;
+	arena_ranges_num++;
+
+	arena_bounds_update();
+
+	arena_table_unlock();
+}
+
+/* Must be called with the range table locked */
+static mem_arena_t *
+arena_owner(const void *p)
+{
+	unsigned lo = 0, hi = arena_ranges_num, mid;
+
+	if (!arena_ranges_num || (const char *)p < arena_lo || (const char *)p >= arena_hi)
+		return NULL;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if ((const char *)p < arena_ranges[mid].start)
+			hi = mid;
+		else if ((const char *)p >= arena_ranges[mid].end)
+			lo = mid + 1;
+		else
+			return arena_ranges[mid].arena;
+	}
+
+	return NULL;
+}
+
+static mem_arena_chunk_t *
+arena_chunk_new(mem_arena_t *arena, size_t size)
+{
+	/* calloc, since fresh space is handed out without clearing it. Large
+	 * chunks come straight from mmap, so this costs nothing extra. */
+	mem_arena_chunk_t *chunk = calloc(1, sizeof(*chunk) + size);
+
+	if (!chunk) {
+		log_message(LOG_INFO, "Keepalived arena chunk error - %s", strerror(errno));
+		exit(KEEPALIVED_EXIT_NO_MEMORY);
+	}
+
+	chunk->size = size;
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+	arena->stats.chunks++;
+	arena->stats.reserved += sizeof(*chunk) + size;
+	arena_range_add(arena, chunk);
+
+	return chunk;
+}
+
+static void *
+arena_alloc(mem_arena_t *arena, unsigned long size)
+{
+	size_t unit = (size + ARENA_HDR + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	mem_arena_chunk_t *chunk;
+	char *hdr;
+	void *obj;
+
+	arena->stats.objects++;
+
+	if (unit <= ARENA_REUSE_MAX && (obj = arena->free_list[unit / ARENA_ALIGN])) {
+		arena->free_list[unit / ARENA_ALIGN] = *(void **)obj;
+		memset(obj, 0, unit - ARENA_HDR);
+		arena->stats.reused++;
+		return obj;
+	}
+
+	arena->stats.used += unit;
+
+	if (unit > (size_t)(arena->end - arena->next)) {
+		if (unit + ARENA_HDR > arena->chunk_size / 4) {
+			/* Give large objects a chunk of their own, and keep
+			 * filling the current one */
+			chunk = arena_chunk_new(arena, unit + ARENA_HDR);
+			hdr = chunk->data + ARENA_HDR;
+			*(size_t *)hdr = unit;
+			return hdr + ARENA_HDR;
+		}
+
+		chunk = arena_chunk_new(arena, arena->chunk_size);
+		if (arena->chunk_size < ARENA_CHUNK_MAX)
+			arena->chunk_size *= 2;
+
+		/* Keep objects aligned after their size header */
+		arena->next = chunk->data + ARENA_ALIGN - ARENA_HDR;
+		arena->end = chunk->data + chunk->size;
+	}
+
+	hdr = arena->next;
+	arena->next += unit;
+	*(size_t *)hdr = unit;
+
+	return hdr + ARENA_HDR;
+}
+
+mem_arena_t *
+mem_arena_new(void)
+{
+	mem_arena_t *arena = calloc(1, sizeof(*arena));
+
+	if (!arena) {
+		log_message(LOG_INFO, "Keepalived arena error - %s", strerror(errno));
+		exit(KEEPALIVED_EXIT_NO_MEMORY);
+	}
+
+	arena->chunk_size = ARENA_CHUNK_MIN;
+	arena->stats.generation = ++arena_generation;
+
+	return arena;
+}
+
+/* Make allocations on this thread come from arena (or the heap if NULL),
+ * returning the arena previously in use */
+mem_arena_t *
+mem_arena_set(mem_arena_t *arena)
+{
+	mem_arena_t *prev = current_arena;
+
+	current_arena = arena;
+
+	return prev;
+}
+
+void
+mem_arena_release(mem_arena_t *arena)
+{
+	mem_arena_chunk_t *chunk, *next;
+	unsigned i, j;
+
+	if (!arena)
+		return;
+
+	if (current_arena == arena)
+		current_arena = NULL;
+
+	arena_table_lock();
+	for (i = j = 0; i < arena_ranges_num; i++) {
+		if (arena_ranges[i].arena != arena)
+			arena_ranges[j++] = arena_ranges[i];
+	}
+	arena_ranges_num = j;
+	arena_bounds_update();
+	arena_table_unlock();
+
+	for (chunk = arena->chunks; chunk; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+
+	free(arena);
+}
+
+void
+mem_arena_get_stats(const mem_arena_t *arena, mem_arena_stats_t *stats)
+{
+	if (arena)
+		*stats = arena->stats;
+	else
+		memset(stats, 0, sizeof(*stats));
+}
+
+void
+mem_free(void *p)
+{
+	mem_arena_t *arena;
+	size_t unit;
+
+	if (!p)
+		return;
+
+	if (!arena_may_own(p)) {
+		free(p);
+		return;
+	}
+
+	arena_table_lock();
+	arena = arena_owner(p);
+	if (arena) {
+		arena->stats.frees++;
+
+		/* Recycle small objects while the generation is still being built */
+		unit = *(size_t *)((char *)p - ARENA_HDR);
+		if (arena == current_arena && unit <= ARENA_REUSE_MAX) {
+			*(void **)p = arena->free_list[unit / ARENA_ALIGN];
+			arena->free_list[unit / ARENA_ALIGN] = p;
+		}
+	}
+	arena_table_unlock();
+
+	if (!arena)
+		free(p);
+}
+
+void *
+mem_realloc(void *p, size_t size)
+{
+	mem_arena_t *arena;
+	size_t old_size;
+	void *new;
+
+	if (!p)
+		return current_arena ? arena_alloc(current_arena, size) : realloc(p, size);
+
+	if (!arena_may_own(p))
+		return realloc(p, size);
+
+	arena_table_lock();
+	arena = arena_owner(p);
+	arena_table_unlock();
+
+	if (!arena)
+		return realloc(p, size);
+
+	/* Move it to wherever new allocations are currently coming from */
+	old_size = *(size_t *)((char *)p - ARENA_HDR) - ARENA_HDR;
+	new = zalloc(size);
+	memcpy(new, p, old_size < size ? old_size : size);
+	mem_free(p);
+
+	return new;
+}
+#else
+/* The memory checker tracks every allocation itself, so arenas are not used */
+mem_arena_t *
+mem_arena_new(void)
+{
+	return NULL;
+}
+
+mem_arena_t *
+mem_arena_set(__attribute__((unused)) mem_arena_t *arena)
+{
+	return NULL;
+}
+
+void
+mem_arena_release(__attribute__((unused)) mem_arena_t *arena)
+{
+}
+
+void
+mem_arena_get_stats(__attribute__((unused)) const mem_arena_t *arena, mem_arena_stats_t *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+}
+#endif
+
+void
+mem_arena_log_stats(const mem_arena_t *arena, const char *what)
+{
+	mem_arena_stats_t stats;
+
+	if (!arena)
+		return;
+
+	mem_arena_get_stats(arena, &stats);
+	log_message(LOG_INFO, "%s configuration generation %u: %zu bytes used of %zu in %u chunks,"
+			      " %lu objects (%lu reused), %lu frees",
+			what, stats.generation, stats.used, stats.reserved, stats.chunks,
+			stats.objects, stats.reused, stats.frees);
+}
+
+#ifdef _WITH_ALLOC_PROFILE_
+/* Sampling allocation profiler.
+ *
+ * On average one allocation in every alloc_profile_interval bytes is
+ * sampled, and stands for that many bytes (or its own size if larger).
+ * For each call site we keep the estimated bytes and objects allocated,
+ * and how many of them are still live, so that leaks and growth show up
+ * by comparing successive dumps. Only sampled pointers are remembered, so
+ * everything else costs a counter update on MALLOC and a hash lookup on
+ * FREE, and nothing at all while profiling is off. */
+#define ALLOC_SITE_HASH		256
+#define ALLOC_SAMPLE_HASH	1024
+#define ALLOC_PROFILE_TOP	25
+
+typedef struct _alloc_site {
+	struct _alloc_site	*next;
+	const char		*file;
+	const char		*func;
+	int			line;
+	unsigned long		samples;
+	unsigned long long	bytes;		/* estimated bytes allocated */
+	unsigned long long	objects;	/* estimated objects allocated */
+	long long		live_bytes;
+	long long		live_objects;
+} alloc_site_t;
+
+typedef struct _alloc_sample {
+	struct _alloc_sample	*next;
+	const void		*ptr;
+	alloc_site_t		*site;
+	size_t			bytes;		/* what this sample stands for */
+	size_t			objects;
+} alloc_sample_t;
+
+bool alloc_profile_active;
+size_t alloc_profile_interval = ALLOC_PROFILE_INTERVAL;
+
+static alloc_site_t *alloc_sites[ALLOC_SITE_HASH];
+static unsigned alloc_sites_num;
+static alloc_sample_t *alloc_samples[ALLOC_SAMPLE_HASH];
+static unsigned long alloc_samples_live;
+
+static THREAD_LOCAL long alloc_sample_countdown;
+static THREAD_LOCAL uint64_t alloc_rand_state;
+
+#ifdef _WITH_CHECKER_THREADS_
+static pthread_mutex_t alloc_profile_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define alloc_profile_lock()	pthread_mutex_lock(&alloc_profile_mutex)
+#define alloc_profile_unlock()	pthread_mutex_unlock(&alloc_profile_mutex)
+#else
+#define alloc_profile_lock()
+#define alloc_profile_unlock()
+#endif
+
+/* Uniform in [1, 2 * interval], so sampling doesn't lock on to
+ * allocation patterns */
+static long
+alloc_sample_next(void)
+{
+	uint64_t x = alloc_rand_state;
+
+	if (!x)
+		x = ((uint64_t)getpid() << 32) ^ (uintptr_t)&alloc_rand_state ^ (uint64_t)time(NULL);
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	alloc_rand_state = x;
+
+	return (long)(x % (2 * alloc_profile_interval)) + 1;
+}
+
+static inline unsigned
+alloc_sample_hash(const void *p)
+{
+	return (unsigned)(((uintptr_t)p >> 4) ^ ((uintptr_t)p >> 14)) % ALLOC_SAMPLE_HASH;
+}
+
+static alloc_site_t *
+alloc_site_get(const char *file, const char *func, int line)
+{
+	alloc_site_t **head = &alloc_sites[(unsigned)line % ALLOC_SITE_HASH];
+	alloc_site_t *site;
+
+	for (site = *head; site; site = site->next) {
+		if (site->line == line && (site->file == file || !strcmp(site->file, file)))
+			return site;
+	}
+
+	/* Not MALLOC, since this could otherwise end up in a config arena */
+	if (!(site = calloc(1, sizeof(*site))))
+		return NULL;
+	site->file = file;
+	site->func = func;
+	site->line = line;
+	site->next = *head;
+	*head = site;
+	alloc_sites_num++;
+
+	return site;
+}
+
+static void
+alloc_profile_sample(const void *p, size_t size, const char *file, const char *func, int line)
+{
+	alloc_sample_t *sample;
+	alloc_site_t *site;
+	unsigned h;
+
+	alloc_sample_countdown = alloc_sample_next();
+
+	if (!p)
+		return;
+
+	alloc_profile_lock();
+	if (!alloc_profile_active ||
+	    !(site = alloc_site_get(file, func, line)) ||
+	    !(sample = malloc(sizeof(*sample)))) {
+		alloc_profile_unlock();
+		return;
+	}
+
+	sample->ptr = p;
+	sample->site = site;
+	sample->bytes = size > alloc_profile_interval ? size : alloc_profile_interval;
+	sample->objects = size ? (sample->bytes + size - 1) / size : 1;
+
+	site->samples++;
+	site->bytes += sample->bytes;
+	site->objects += sample->objects;
+	site->live_bytes += (long long)sample->bytes;
+	site->live_objects += (long long)sample->objects;
+
+	h = alloc_sample_hash(p);
+	sample->next = alloc_samples[h];
+	alloc_samples[h] = sample;
+	alloc_samples_live++;
+	alloc_profile_unlock();
+}
+
+static void
+alloc_profile_unsample(const void *p)
+{
+	alloc_sample_t **sp, *sample;
+
+	alloc_profile_lock();
+	if (alloc_samples_live) {
+		for (sp = &alloc_samples[alloc_sample_hash(p)]; (sample = *sp); sp = &sample->next) {
+			if (sample->ptr != p)
+				continue;
+
+			sample->site->live_bytes -= (long long)sample->bytes;
+			sample->site->live_objects -= (long long)sample->objects;
+			*sp = sample->next;
+			free(sample);
+			alloc_samples_live--;
+			break;
+		}
+	}
+	alloc_profile_unlock();
+}
+
+void *
+alloc_profile_malloc(size_t size, const char *file, const char *func, int line)
+{
+	void *p = zalloc(size);
+
+	if ((alloc_sample_countdown -= (long)size) <= 0)
+		alloc_profile_sample(p, size, file, func, line);
+
+	return p;
+}
+
+void
+alloc_profile_free(void *p)
+{
+	if (p)
+		alloc_profile_unsample(p);
+	mem_free(p);
+}
+
+void *
+alloc_profile_realloc(void *p, size_t size, const char *file, const char *func, int line)
+{
+	void *new;
+
+	if (p)
+		alloc_profile_unsample(p);
+
+	new = mem_realloc(p, size);
+
+	if ((alloc_sample_countdown -= (long)size) <= 0)
+		alloc_profile_sample(new, size, file, func, line);
+
+	return new;
+}
+
+/* Stopping the profiler forgets the sampled pointers, so the live figures
+ * stay as they were at that point, but the per site totals are kept. */
+void
+alloc_profile_enable(bool enable)
+{
+	alloc_sample_t *sample, *next;
+	unsigned i;
+
+	alloc_profile_lock();
+	if (enable) {
+		alloc_sample_countdown = alloc_sample_next();
+		alloc_profile_active = true;
+	} else {
+		alloc_profile_active = false;
+		for (i = 0; i < ALLOC_SAMPLE_HASH; i++) {
+			for (sample = alloc_samples[i]; sample; sample = next) {
+				next = sample->next;
+				free(sample);
+			}
+			alloc_samples[i] = NULL;
+		}
+		alloc_samples_live = 0;
+	}
+	alloc_profile_unlock();
+}
+
+void
+alloc_profile_signal(__attribute__((unused)) void *v, __attribute__((unused)) int sig)
+{
+	alloc_profile_enable(!alloc_profile_active);
+
+	log_message(LOG_INFO, "Allocation profiling %s for process(%d)",
+		    alloc_profile_active ? "started" : "stopped", getpid());
+}
+
+static int
+alloc_site_cmp(const void *a, const void *b)
+{
+	const alloc_site_t *s1 = *(const alloc_site_t * const *)a;
+	const alloc_site_t *s2 = *(const alloc_site_t * const *)b;
+
+	if (s1->live_bytes != s2->live_bytes)
+		return s1->live_bytes < s2->live_bytes ? 1 : -1;
+	if (s1->bytes != s2->bytes)
+		return s1->bytes < s2->bytes ? 1 : -1;
+	return 0;
+}
+
+/* Write the call sites holding the most sampled memory */
+void
+alloc_profile_dump(FILE *fp)
+{
+	alloc_site_t **sites, *site;
+	long long live_bytes = 0;
+	unsigned long long bytes = 0;
+	unsigned i, n = 0;
+
+	alloc_profile_lock();
+
+	if (!alloc_sites_num) {
+		alloc_profile_unlock();
+		return;
+	}
+
+	if (!(sites = malloc(alloc_sites_num * sizeof(*sites)))) {
+		alloc_profile_unlock();
+		return;
+	}
+
+	for (i = 0; i < ALLOC_SITE_HASH; i++) {
+		for (site = alloc_sites[i]; site; site = site->next) {
+			sites[n++] = site;
+			live_bytes += site->live_bytes;
+			bytes += site->bytes;
+		}
+	}
+
+	qsort(sites, n, sizeof(*sites), alloc_site_cmp);
+
+	fprintf(fp, "\nAllocation profile (%s, one sample per %zu bytes, %lu live samples)\n",
+		alloc_profile_active ? "running" : "stopped", alloc_profile_interval, alloc_samples_live);
+	fprintf(fp, "  Estimated %lld bytes live, %llu bytes allocated, from %u call sites\n",
+		live_bytes, bytes, n);
+	fprintf(fp, "  %12s %10s %14s %12s %8s  %s\n",
+		"live bytes", "live objs", "total bytes", "total objs", "samples", "call site");
+	for (i = 0; i < n && i < ALLOC_PROFILE_TOP; i++) {
+		site = sites[i];
+		fprintf(fp, "  %12lld %10lld %14llu %12llu %8lu  %s:%d %s()\n",
+			site->live_bytes, site->live_objects, site->bytes, site->objects,
+			site->samples, site->file, site->line, site->func);
+	}
+
+	alloc_profile_unlock();
+
+	free(sites);
+}
+#endif
+
 void *
 zalloc(unsigned long size)
 {
-	void *mem = xalloc(size);
+	void *mem;
+
+#ifndef _MEM_CHECK_
+	if (current_arena)
+		return arena_alloc(current_arena, size);
+#endif
+
+	mem = xalloc(size);
 
 	if (mem)
 		memset(mem, 0, size);
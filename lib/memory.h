@@ -33,6 +33,10 @@
 #include <sys/stat.h>
 #else
 #include <stdlib.h>
+#ifdef _WITH_ALLOC_PROFILE_
+#include <stdbool.h>
+#include <stdio.h>
+#endif
 #endif
 
 /* Local defines */
@@ -65,13 +69,61 @@ extern void update_mem_check_log_perms(mode_t);
 #else
 
 extern void *zalloc(unsigned long size);
+extern void mem_free(void *);
+extern void *mem_realloc(void *, size_t);
+
+#ifdef _WITH_ALLOC_PROFILE_
+/* Default mean number of bytes allocated between samples */
+#define ALLOC_PROFILE_INTERVAL	(64 * 1024)
+
+#define MALLOC(n)    ( alloc_profile_active ? \
+		       alloc_profile_malloc((n), (__FILE__), (__FUNCTION__), (__LINE__)) : \
+		       zalloc(n) )
+#define FREE(p)      ( (alloc_profile_active ? alloc_profile_free(p) : mem_free(p)), \
+		       (p) = NULL )
+#define REALLOC(p,n) ( alloc_profile_active ? \
+		       alloc_profile_realloc((p), (n), (__FILE__), (__FUNCTION__), (__LINE__)) : \
+		       mem_realloc((p),(n)) )
 
+extern bool alloc_profile_active;
+extern size_t alloc_profile_interval;
+
+/* Allocation profiler prototypes defs */
+extern void *alloc_profile_malloc(size_t, const char *, const char *, int)
+		__attribute__((alloc_size(1))) __attribute__((malloc));
+extern void alloc_profile_free(void *);
+extern void *alloc_profile_realloc(void *, size_t, const char *, const char *, int)
+		__attribute__((alloc_size(2)));
+extern void alloc_profile_enable(bool);
+extern void alloc_profile_signal(void *, int);
+extern void alloc_profile_dump(FILE *);
+#else
 #define MALLOC(n)    (zalloc(n))
-#define FREE(p)      (free(p), (p) = NULL)
-#define REALLOC(p,n) (realloc((p),(n)))
+#define FREE(p)      (mem_free(p), (p) = NULL)
+#define REALLOC(p,n) (mem_realloc((p),(n)))
+#endif
 
 #endif
 
+/* Configuration generation arenas */
+typedef struct _mem_arena mem_arena_t;
+
+typedef struct _mem_arena_stats {
+	unsigned		generation;
+	unsigned		chunks;
+	size_t			reserved;	/* bytes obtained for chunks */
+	size_t			used;		/* bytes handed out, including headers */
+	unsigned long		objects;
+	unsigned long		reused;		/* objects allocated from freed space */
+	unsigned long		frees;		/* FREEs left to the arena release */
+} mem_arena_stats_t;
+
+extern mem_arena_t *mem_arena_new(void);
+extern mem_arena_t *mem_arena_set(mem_arena_t *);
+extern void mem_arena_release(mem_arena_t *);
+extern void mem_arena_get_stats(const mem_arena_t *, mem_arena_stats_t *);
+extern void mem_arena_log_stats(const mem_arena_t *, const char *);
+
 /* Common defines */
 #define PMALLOC(p)	{ p = MALLOC(sizeof(*p)); }
 #define FREE_PTR(p)	{ if (p) { FREE(p);} }
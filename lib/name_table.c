@@ -0,0 +1,163 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        Hash table of objects keyed on their name.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2001-2017 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "name_table.h"
+#include "memory.h"
+
+/* FNV-1a */
+static uint32_t
+name_hash(const char *name)
+{
+	uint32_t h = 2166136261U;
+
+	while (*name) {
+		h ^= (unsigned char)*name++;
+		h *= 16777619U;
+	}
+
+	return h;
+}
+
+static inline name_entry_t **
+name_table_bucket(const name_table_t *table, uint32_t hash)
+{
+	return &table->buckets[hash & ((1U << table->bits) - 1)];
+}
+
+/* Append, so that entries with the same name stay in the order added */
+static void
+name_table_insert(name_table_t *table, name_entry_t *entry)
+{
+	name_entry_t **ep;
+
+	for (ep = name_table_bucket(table, entry->hash); *ep; ep = &(*ep)->next);
+	entry->next = NULL;
+	*ep = entry;
+}
+
+static void
+name_table_grow(name_table_t *table)
+{
+	name_entry_t **old_buckets = table->buckets;
+	unsigned old_size = 1U << table->bits;
+	name_entry_t *entry, *next;
+	unsigned i;
+
+	table->bits++;
+	table->buckets = MALLOC(sizeof(name_entry_t *) << table->bits);
+
+	for (i = 0; i < old_size; i++) {
+		for (entry = old_buckets[i]; entry; entry = next) {
+			next = entry->next;
+			name_table_insert(table, entry);
+		}
+	}
+
+	FREE(old_buckets);
+}
+
+name_table_t *
+alloc_name_table(void)
+{
+	name_table_t *table;
+
+	PMALLOC(table);
+	table->bits = NAME_TABLE_MIN_BITS;
+	table->buckets = MALLOC(sizeof(name_entry_t *) << table->bits);
+
+	return table;
+}
+
+void
+free_name_table(name_table_t **tablep)
+{
+	name_table_t *table = *tablep;
+	name_entry_t *entry, *next;
+	unsigned i;
+
+	if (!table)
+		return;
+
+	for (i = 0; i < 1U << table->bits; i++) {
+		for (entry = table->buckets[i]; entry; entry = next) {
+			next = entry->next;
+			FREE(entry);
+		}
+	}
+
+	FREE(table->buckets);
+	FREE(table);
+	*tablep = NULL;
+}
+
+void
+name_table_add(name_table_t *table, const char *name, void *data)
+{
+	size_t len = strlen(name);
+	name_entry_t *entry;
+
+	if (table->count >= 1U << table->bits)
+		name_table_grow(table);
+
+	entry = MALLOC(sizeof(name_entry_t) + len + 1);
+	memcpy(entry->name, name, len);
+	entry->data = data;
+	entry->hash = name_hash(name);
+
+	name_table_insert(table, entry);
+	table->count++;
+}
+
+/* Removes the entry for data added under name */
+void
+name_table_remove(name_table_t *table, const char *name, const void *data)
+{
+	uint32_t hash = name_hash(name);
+	name_entry_t **ep, *entry;
+
+	for (ep = name_table_bucket(table, hash); (entry = *ep); ep = &entry->next) {
+		if (entry->data == data && entry->hash == hash && !strcmp(entry->name, name)) {
+			*ep = entry->next;
+			FREE(entry);
+			table->count--;
+			return;
+		}
+	}
+}
+
+void *
+name_table_lookup(const name_table_t *table, const char *name)
+{
+	uint32_t hash = name_hash(name);
+	name_entry_t *entry;
+
+	for (entry = *name_table_bucket(table, hash); entry; entry = entry->next) {
+		if (entry->hash == hash && !strcmp(entry->name, name))
+			return entry->data;
+	}
+
+	return NULL;
+}
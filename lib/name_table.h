@@ -0,0 +1,54 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        name_table.c include file.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2001-2017 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#ifndef _NAME_TABLE_H
+#define _NAME_TABLE_H
+
+#include <stdint.h>
+
+/* Hash table of objects keyed on their name. The table keeps its own
+ * copy of each name, so an object may be renamed or freed once it has
+ * been removed from the table. The same name may be added more than
+ * once; a lookup returns the object that was added first. */
+typedef struct _name_entry {
+	struct _name_entry	*next;
+	void			*data;
+	uint32_t		hash;
+	char			name[];
+} name_entry_t;
+
+typedef struct _name_table {
+	name_entry_t		**buckets;
+	unsigned		bits;		/* log2 of the number of buckets */
+	unsigned		count;
+} name_table_t;
+
+#define NAME_TABLE_MIN_BITS	4
+
+/* Prototypes defs */
+extern name_table_t *alloc_name_table(void);
+extern void free_name_table(name_table_t **);
+extern void name_table_add(name_table_t *, const char *, void *);
+extern void name_table_remove(name_table_t *, const char *, const void *);
+extern void *name_table_lookup(const name_table_t *, const char *);
+
+#endif
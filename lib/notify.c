@@ -34,6 +34,13 @@
 #include <sys/resource.h>
 #include <limits.h>
 #include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <dirent.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <assert.h>
 
 #include "notify.h"
 #include "signals.h"
@@ -43,6 +50,7 @@
 #include "parser.h"
 #include "keepalived_magic.h"
 #include "scheduler.h"
+#include "bitops.h"
 
 /* Default user/group for script execution */
 uid_t default_script_uid;
@@ -343,12 +351,505 @@ system_call(const notify_script_t* script)
 	exit(0);
 }
 
+/* The script spawner is a small process forked by the VRRP and checker
+ * processes before they read their configuration. Scripts are forked from
+ * it rather than from the process that runs them, which can be very large,
+ * so that each fork only has to copy the spawner's small page tables.
+ *
+ * A request is a spawn_req_t followed by the script's args, each NUL
+ * terminated. Notify scripts have extra args after num_args, so all the
+ * args up to the terminating NULL are sent. If a reply is wanted, the
+ * spawner replies with the pid of the script, or -1 and the fork errno.
+ * Whenever a script exits, the spawner sends its wait status, which is
+ * handled as though the script were our own child. Timeouts are still
+ * handled by our child threads. */
+#define SPAWN_MSG_MAX	(16 * 1024)
+
+typedef struct _spawn_req {
+	uid_t	uid;
+	gid_t	gid;
+	int	flags;
+	int	num_args;
+	int	total_args;	/* including any after num_args */
+	bool	want_reply;
+} spawn_req_t;
+
+typedef struct _spawn_rep {
+	pid_t	pid;
+	int	status;		/* wait status, or errno if pid is -1 */
+	bool	exited;
+} spawn_rep_t;
+
+static int spawner_fd = -1;
+static pid_t spawner_pid;
+static thread_t *spawner_thread;
+
+static void
+spawner_sigchld(__attribute__((unused)) int sig)
+{
+	/* Only needed to interrupt ppoll() */
+}
+
+static void
+spawner_run(char *buf, size_t len, int fd)
+{
+	spawn_req_t req;
+	spawn_rep_t rep = { .pid = -1, .status = EINVAL };
+	notify_script_t script;
+	char *p, *end = buf + len;
+	sigset_t sset;
+	int i;
+
+	if (len < sizeof(req))
+		return;
+	memcpy(&req, buf, sizeof(req));
+
+	if (req.total_args <= 0 || req.num_args > req.total_args ||
+	    (size_t)req.total_args > len - sizeof(req)) {
+		if (req.want_reply)
+			send(fd, &rep, sizeof(rep), MSG_NOSIGNAL);
+		return;
+	}
+
+	script.args = MALLOC((size_t)(req.total_args + 1) * sizeof(char *));
+	for (i = 0, p = buf + sizeof(req); i < req.total_args && p < end; i++) {
+		script.args[i] = p;
+		p += strnlen(p, (size_t)(end - p)) + 1;
+	}
+	if (i < req.total_args || p > end) {
+		FREE(script.args);
+		if (req.want_reply)
+			send(fd, &rep, sizeof(rep), MSG_NOSIGNAL);
+		return;
+	}
+	script.num_args = req.num_args;
+	script.flags = req.flags;
+	script.uid = req.uid;
+	script.gid = req.gid;
+
+#ifdef ENABLE_LOG_TO_FILE
+	if (log_file_name)
+		flush_log_file();
+#endif
+
+	rep.pid = fork();
+	if (!rep.pid) {
+		/* Script process */
+		close(fd);
+		signal(SIGCHLD, SIG_DFL);
+		sigemptyset(&sset);
+		sigprocmask(SIG_SETMASK, &sset, NULL);
+
+		system_call(&script);
+	}
+
+	if (rep.pid == -1) {
+		rep.status = errno;
+		log_message(LOG_INFO, "Script spawner failed fork process (%m)");
+	}
+	FREE(script.args);
+
+	if (req.want_reply)
+		send(fd, &rep, sizeof(rep), MSG_NOSIGNAL);
+}
+
+static void __attribute__ ((noreturn))
+script_spawner(int fd)
+{
+	char buf[SPAWN_MSG_MAX];
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	struct sigaction sa;
+	sigset_t sset;
+	spawn_rep_t rep = { .exited = true };
+	ssize_t len;
+	DIR *dir;
+	struct dirent *d;
+	int n;
+
+	/* Exit if the VRRP or checker process dies */
+	prctl(PR_SET_PDEATHSIG, SIGTERM);
+
+	signal_handler_script();
+
+	/* Don't let scripts inherit anything left open by our parent */
+	if ((dir = opendir("/proc/self/fd"))) {
+		while ((d = readdir(dir))) {
+			n = atoi(d->d_name);
+			if (n > STDERR_FILENO && n != dirfd(dir))
+				fcntl(n, F_SETFD, FD_CLOEXEC);
+		}
+		closedir(dir);
+	}
+
+	/* SIGCHLD is only delivered while we are waiting in ppoll() */
+	sa.sa_handler = spawner_sigchld;
+	sa.sa_flags = SA_NOCLDSTOP;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGCHLD, &sa, NULL);
+	sigemptyset(&sset);
+	sigaddset(&sset, SIGCHLD);
+	sigprocmask(SIG_BLOCK, &sset, NULL);
+	sigemptyset(&sset);
+
+	while (true) {
+		pfd.revents = 0;
+		if (ppoll(&pfd, 1, NULL, &sset) == -1 && errno != EINTR)
+			exit(1);
+
+		while ((rep.pid = waitpid(-1, &rep.status, WNOHANG)) > 0)
+			send(fd, &rep, sizeof(rep), MSG_NOSIGNAL);
+
+		if (pfd.revents & POLLIN) {
+			len = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+			if (len == 0)
+				exit(0);
+			if (len > 0)
+				spawner_run(buf, (size_t)len, fd);
+		} else if (pfd.revents & (POLLHUP | POLLERR))
+			exit(0);
+	}
+}
+
+/* This should be called as early as possible, while the process is small */
+void
+start_script_spawner(void)
+{
+	int fds[2];
+	pid_t pid;
+
+	if (spawner_fd != -1)
+		return;
+
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds)) {
+		log_message(LOG_INFO, "Unable to create script spawner socket (%m)");
+		return;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		log_message(LOG_INFO, "Failed fork script spawner (%m)");
+		close(fds[0]);
+		close(fds[1]);
+		return;
+	}
+
+	if (!pid) {
+#ifdef _MEM_CHECK_
+		skip_mem_dump();
+#endif
+		close(fds[0]);
+		script_spawner(fds[1]);
+	}
+
+	close(fds[1]);
+	spawner_fd = fds[0];
+	spawner_pid = pid;
+
+	log_message(LOG_INFO, "Started script spawner, pid %d", pid);
+}
+
+/* thread is the spawner's read thread if we are running in it */
+static void
+stop_script_spawner(thread_t *thread)
+{
+	log_message(LOG_INFO, "Script spawner %d failed - forking scripts directly", spawner_pid);
+
+	if (thread)
+		thread_close_fd(thread);
+	else {
+		if (spawner_thread)
+			thread_cancel(spawner_thread);
+		close(spawner_fd);
+	}
+	spawner_thread = NULL;
+	spawner_fd = -1;
+	kill(spawner_pid, SIGKILL);
+}
+
+/* Handle the replies from the spawner. If started is set, wait for the
+ * reply to our request, otherwise process what has been received.
+ * Returns false if the spawner has failed. */
+static bool
+spawner_recv(spawn_rep_t *started)
+{
+	struct pollfd pfd = { .fd = spawner_fd, .events = POLLIN };
+	spawn_rep_t rep;
+	ssize_t len;
+	int ret;
+
+	while (true) {
+		if (started) {
+			/* The spawner only has to fork, so doesn't take long */
+			ret = poll(&pfd, 1, 1000);
+			if (ret == -1 && errno == EINTR)
+				continue;
+			if (ret <= 0)
+				return false;
+		}
+
+		len = recv(spawner_fd, &rep, sizeof(rep), MSG_DONTWAIT);
+		if (len == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return !started;
+			return false;
+		}
+		if (len != sizeof(rep))
+			return false;
+
+		if (rep.exited)
+			process_child_termination(rep.pid, rep.status);
+		else if (started) {
+			*started = rep;
+			return true;
+		}
+	}
+}
+
+static int
+script_spawner_thread(thread_t *thread)
+{
+	spawner_thread = NULL;
+
+	if (!spawner_recv(NULL)) {
+		stop_script_spawner(thread);
+		return 0;
+	}
+
+	spawner_thread = thread_add_read(thread->master, script_spawner_thread, NULL, spawner_fd, TIMER_NEVER);
+
+	return 0;
+}
+
+/* Must be called again after thread_cleanup_master() */
+void
+add_script_spawner_read_thread(thread_master_t *m)
+{
+	if (spawner_fd != -1)
+		spawner_thread = thread_add_read(m, script_spawner_thread, NULL, spawner_fd, TIMER_NEVER);
+}
+
+/* Ask the spawner to run a script. Returns the pid of the script, or 0 if
+ * no reply is wanted; -1 means the script must be forked by the caller. */
+static pid_t
+spawner_exec(const notify_script_t *script, bool want_reply)
+{
+	char buf[SPAWN_MSG_MAX];
+	spawn_req_t req = {
+		.uid = script->uid,
+		.gid = script->gid,
+		.flags = script->flags,
+		.num_args = script->num_args,
+		.want_reply = want_reply,
+	};
+	spawn_rep_t rep;
+	size_t len = sizeof(req), arg_len;
+	int i;
+
+	for (i = 0; script->args[i]; i++) {
+		arg_len = strlen(script->args[i]) + 1;
+		if (len + arg_len > sizeof(buf))
+			return -1;
+		memcpy(buf + len, script->args[i], arg_len);
+		len += arg_len;
+	}
+	req.total_args = i;
+	memcpy(buf, &req, sizeof(req));
+
+	if (send(spawner_fd, buf, len, MSG_DONTWAIT | MSG_NOSIGNAL) != (ssize_t)len) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK)
+			stop_script_spawner(NULL);
+		return -1;
+	}
+
+	if (!want_reply)
+		return 0;
+
+	if (!spawner_recv(&rep)) {
+		stop_script_spawner(NULL);
+		return -1;
+	}
+
+	if (rep.pid == -1) {
+		errno = rep.status;
+		return -1;
+	}
+
+	return rep.pid;
+}
+
+
+/* Scripts that can be exec'd directly can be started with
+ * clone(CLONE_VM | CLONE_VFORK), so that the child shares our memory until
+ * it execs, rather than fork() having to copy our page tables. The child
+ * only makes system calls, and reports any failure back in vfork_args_t,
+ * so that we can log it.
+ *
+ * The child runs on the static vfork_stack, so only the main thread may
+ * call vfork_script(). */
+#define VFORK_STACK_SIZE	(64 * 1024)
+
+/* The glibc set*id() wrappers signal every thread to apply the change to
+ * them too, which must not happen in a child sharing our memory, so as
+ * glibc's own posix_spawn() does, make the system calls directly. */
+#ifdef SYS_setresgid32
+#define VFORK_SYS_setresgid	SYS_setresgid32
+#define VFORK_SYS_setresuid	SYS_setresuid32
+#define VFORK_SYS_setgroups	SYS_setgroups32
+#else
+#define VFORK_SYS_setresgid	SYS_setresgid
+#define VFORK_SYS_setresuid	SYS_setresuid
+#define VFORK_SYS_setgroups	SYS_setgroups
+#endif
+
+typedef enum {
+	VFORK_OK,
+	VFORK_SETGID,
+	VFORK_SETGROUPS,
+	VFORK_SETUID,
+	VFORK_EXEC,
+} vfork_step_t;
+
+typedef struct _vfork_args {
+	const notify_script_t *script;
+	vfork_step_t	failed;
+	int		err;
+} vfork_args_t;
+
+static bool script_vfork;
+static char vfork_stack[VFORK_STACK_SIZE] __attribute__((aligned(16)));
+
+void
+set_script_vfork(bool enable)
+{
+	script_vfork = enable;
+}
+
+static int
+vfork_child(void *arg)
+{
+	vfork_args_t *va = arg;
+	const notify_script_t *script = va->script;
+	struct sigaction dfl;
+	sigset_t sset;
+	int sig, fd;
+
+	/* Our own process group, so all the script's children can be killed */
+	setpgid(0, 0);
+
+	/* If keepalived dies, we want the script to die */
+	prctl(PR_SET_PDEATHSIG, SIGTERM);
+
+	/* If we have increased our priority, set it to default for the script,
+	 * as set_privileges() does. cur_prio is shared with the parent, so
+	 * don't update it here. */
+	if (getpriority(PRIO_PROCESS, 0) < 0)
+		setpriority(PRIO_PROCESS, 0, 0);
+
+	if (script->gid) {
+		if (syscall(VFORK_SYS_setresgid, script->gid, script->gid, script->gid)) {
+			va->failed = VFORK_SETGID;
+			goto fail;
+		}
+
+		/* Clear any extra supplementary groups */
+		if (syscall(VFORK_SYS_setgroups, 1, &script->gid)) {
+			va->failed = VFORK_SETGROUPS;
+			goto fail;
+		}
+	}
+
+	if (script->uid && syscall(VFORK_SYS_setresuid, script->uid, script->uid, script->uid)) {
+		va->failed = VFORK_SETUID;
+		goto fail;
+	}
+
+	/* Without CLONE_SIGHAND the handlers are our own copy */
+	dfl.sa_handler = SIG_DFL;
+	dfl.sa_flags = 0;
+	sigemptyset(&dfl.sa_mask);
+	for (sig = 1; sig <= SIGRTMAX; sig++)
+		sigaction(sig, &dfl, NULL);
+	sigemptyset(&sset);
+	sigprocmask(SIG_SETMASK, &sset, NULL);
+
+	if (__test_bit(DONT_FORK_BIT, &debug)) {
+		fd = open("/dev/null", O_RDWR);
+		if (fd != -1) {
+			dup2(fd, STDIN_FILENO);
+			dup2(fd, STDOUT_FILENO);
+			dup2(fd, STDERR_FILENO);
+			if (fd > STDERR_FILENO)
+				close(fd);
+		}
+	}
+
+	execve(script->args[0], script->args, environ);
+	va->failed = VFORK_EXEC;
+
+fail:
+	va->err = errno;
+	_exit(0);
+}
+
+static pid_t
+vfork_script(const notify_script_t *script)
+{
+	vfork_args_t va = { .script = script };
+	sigset_t all_sigs, old_set;
+	pid_t pid;
+
+	/* vfork_stack is not per thread */
+	assert(syscall(SYS_gettid) == getpid());
+
+	/* Don't let any signal handler run in the child while it shares our memory */
+	sigfillset(&all_sigs);
+	sigmask_func(SIG_SETMASK, &all_sigs, &old_set);
+	pid = clone(vfork_child, vfork_stack + VFORK_STACK_SIZE, CLONE_VM | CLONE_VFORK | SIGCHLD, &va);
+	sigmask_func(SIG_SETMASK, &old_set, NULL);
+
+	if (pid < 0) {
+		log_message(LOG_INFO, "Failed fork process");
+		return -1;
+	}
+
+	/* As local_fork() does */
+	reset_process_priorities();
+
+	errno = va.err;
+	switch (va.failed) {
+	case VFORK_OK:
+		break;
+	case VFORK_SETGID:
+		log_message(LOG_ALERT, "Couldn't setgid: %d (%m)", script->gid);
+		break;
+	case VFORK_SETGROUPS:
+		log_message(LOG_ALERT, "Couldn't setgroups: %d (%m)", script->gid);
+		break;
+	case VFORK_SETUID:
+		log_message(LOG_ALERT, "Couldn't setuid: %d (%m)", script->uid);
+		break;
+	case VFORK_EXEC:
+		log_message(LOG_ALERT, "Error exec-ing command '%s', error %d: %m", script->args[0], va.err);
+		break;
+	}
+
+	return pid;
+}
+
 /* Execute external script/program */
 int
 notify_exec(const notify_script_t *script)
 {
 	pid_t pid;
 
+	if (spawner_fd != -1 && !spawner_exec(script, false))
+		return 0;
+
+	if (script_vfork && (script->flags & SC_EXECABLE))
+		return vfork_script(script) < 0 ? -1 : 0;
+
 #ifdef ENABLE_LOG_TO_FILE
 	if (log_file_name)
 		flush_log_file();
@@ -382,6 +883,18 @@ system_call_script(thread_master_t *m, int (*func) (thread_t *), void * arg, uns
 {
 	pid_t pid;
 
+	if (spawner_fd != -1 && (pid = spawner_exec(script, true)) > 0) {
+		thread_add_child(m, func, arg, pid, timer);
+		return 0;
+	}
+
+	if (script_vfork && (script->flags & SC_EXECABLE)) {
+		if ((pid = vfork_script(script)) < 0)
+			return -1;
+		thread_add_child(m, func, arg, pid, timer);
+		return 0;
+	}
+
 	/* Daemonization to not degrade our scheduling timer */
 #ifdef ENABLE_LOG_TO_FILE
 	if (log_file_name)
@@ -412,14 +925,234 @@ system_call_script(thread_master_t *m, int (*func) (thread_t *), void * arg, uns
 	exit(0); /* Script errors aren't server errors */
 }
 
+/* Start a persistent script, with pipes to its stdin and stdout. func is
+ * run when it exits. */
+int
+coproc_start(thread_master_t *m, int (*func) (thread_t *), void *arg, script_coproc_t *coproc, const notify_script_t *script)
+{
+	int in_pipe[2], out_pipe[2];
+	pid_t pid;
+
+	if (pipe2(in_pipe, O_CLOEXEC)) {
+		log_message(LOG_INFO, "Unable to create pipe for persistent script %s - %m", script->args[0]);
+		return -1;
+	}
+	if (pipe2(out_pipe, O_CLOEXEC)) {
+		log_message(LOG_INFO, "Unable to create pipe for persistent script %s - %m", script->args[0]);
+		close(in_pipe[0]);
+		close(in_pipe[1]);
+		return -1;
+	}
+
+#ifdef ENABLE_LOG_TO_FILE
+	if (log_file_name)
+		flush_log_file();
+#endif
+
+	pid = local_fork();
+
+	if (pid < 0) {
+		log_message(LOG_INFO, "Failed fork process");
+		close(in_pipe[0]);
+		close(in_pipe[1]);
+		close(out_pipe[0]);
+		close(out_pipe[1]);
+		return -1;
+	}
+
+	if (pid) {
+		/* Also set here, so that the process group can be killed at once */
+		setpgid(pid, pid);
+
+		close(in_pipe[0]);
+		close(out_pipe[1]);
+
+		/* Only our ends are non-blocking; the script's must block */
+		fcntl(in_pipe[1], F_SETFL, fcntl(in_pipe[1], F_GETFL) | O_NONBLOCK);
+		fcntl(out_pipe[0], F_SETFL, fcntl(out_pipe[0], F_GETFL) | O_NONBLOCK);
+
+		coproc->pid = pid;
+		coproc->in_fd = in_pipe[1];
+		coproc->out_fd = out_pipe[0];
+		coproc->script = script;
+		coproc->read_thread = NULL;
+		coproc->len = 0;
+
+		thread_add_child(m, func, arg, pid, TIMER_NEVER);
+
+		return 0;
+	}
+
+	/* Child process */
+#ifdef _MEM_CHECK_
+	skip_mem_dump();
+#endif
+
+	setpgid(0, 0);
+
+	if (set_privileges(script->uid, script->gid))
+		exit(0);
+
+	/* After set_privileges(), which can point stdin and stdout at /dev/null.
+	 * dup2() clears FD_CLOEXEC on the new fds. */
+	if (dup2(in_pipe[0], STDIN_FILENO) == -1 ||
+	    dup2(out_pipe[1], STDOUT_FILENO) == -1) {
+		log_message(LOG_ALERT, "Unable to set stdin/stdout of persistent script %s - %m", script->args[0]);
+		exit(0);
+	}
+
+	if (script->flags & SC_EXECABLE)
+		execve(script->args[0], script->args, environ);
+	else
+		execl("/bin/sh", "sh", "-c", cmd_str(script), NULL);
+
+	log_message(LOG_ALERT, "Error exec-ing persistent script '%s', error %d: %m", script->args[0], errno);
+
+	exit(0);
+}
+
+/* Send a request line to a persistent script, and wait up to timer for its
+ * reply, running func when it arrives or the wait times out. */
+int
+coproc_request(thread_master_t *m, int (*func) (thread_t *), void *arg, script_coproc_t *coproc, const char *request, unsigned long timer)
+{
+	char buf[256];
+	int len;
+
+	/* Anything left over from an earlier reply is discarded */
+	coproc->len = 0;
+
+	len = snprintf(buf, sizeof(buf), "%s\n", request);
+	if (len >= (int)sizeof(buf)) {
+		buf[sizeof(buf) - 2] = '\n';
+		len = sizeof(buf) - 1;
+	}
+
+	/* A request is shorter than PIPE_BUF, so is written whole or not at all */
+	if (write(coproc->in_fd, buf, (size_t)len) != len) {
+		log_message_rl(LOG_INFO, "Unable to send request to persistent script %s - %s",
+			       coproc->script->args[0], errno == EAGAIN ? "it is not reading its requests" : strerror(errno));
+		return -1;
+	}
+
+	coproc->read_thread = thread_add_read(m, func, arg, coproc->out_fd, timer);
+
+	return 0;
+}
+
+/* Read the reply of a persistent script, from its read thread. Returns 1 with
+ * the value replied, 0 if the reply is incomplete, in which case the read
+ * thread has been added again, or -1 on time out, EOF or an invalid reply. */
+int
+coproc_read(thread_t *thread, script_coproc_t *coproc, int *value)
+{
+	ssize_t len;
+	char *end, *nl;
+	long val;
+
+	coproc->read_thread = NULL;
+
+	if (thread->type == THREAD_READ_TIMEOUT) {
+		thread_del_read(thread);
+		return -1;
+	}
+
+	len = read(coproc->out_fd, coproc->buf + coproc->len, sizeof(coproc->buf) - 1 - coproc->len);
+	if (len == -1 && (errno == EAGAIN || errno == EINTR)) {
+		coproc->read_thread = thread_add_read_sands(thread->master, thread->func, thread->arg, coproc->out_fd, &thread->sands);
+		return 0;
+	}
+	if (len <= 0) {
+		thread_del_read(thread);
+		return -1;
+	}
+
+	coproc->len += (size_t)len;
+	coproc->buf[coproc->len] = '\0';
+
+	if (!(nl = strchr(coproc->buf, '\n'))) {
+		if (coproc->len < sizeof(coproc->buf) - 1) {
+			coproc->read_thread = thread_add_read_sands(thread->master, thread->func, thread->arg, coproc->out_fd, &thread->sands);
+			return 0;
+		}
+	} else {
+		*nl = '\0';
+		val = strtol(coproc->buf, &end, 10);
+		if (end != coproc->buf && (!*end || *end == '\r') && val >= 0 && val <= 255) {
+			thread_del_read(thread);
+			*value = (int)val;
+			return 1;
+		}
+	}
+
+	thread_del_read(thread);
+
+	log_message_rl(LOG_INFO, "Invalid reply '%.*s' from persistent script %s",
+		       (int)strcspn(coproc->buf, "\n"), coproc->buf, coproc->script->args[0]);
+
+	return -1;
+}
+
+/* The script's exit, reported to the func given to coproc_start(), releases it */
+void
+coproc_kill(script_coproc_t *coproc)
+{
+	if (coproc->pid)
+		kill(-coproc->pid, SIGKILL);
+}
+
+/* Called when the script has exited. It is started again for the next request. */
+void
+coproc_exited(script_coproc_t *coproc, int wait_status)
+{
+	if (!coproc->pid)
+		return;
+
+	if (WIFEXITED(wait_status))
+		log_message_rl(LOG_INFO, "Persistent script %s (PID %d) exited with status %d",
+			       coproc->script->args[0], coproc->pid, WEXITSTATUS(wait_status));
+	else if (WIFSIGNALED(wait_status))
+		log_message_rl(LOG_INFO, "Persistent script %s (PID %d) exited due to signal %d",
+			       coproc->script->args[0], coproc->pid, WTERMSIG(wait_status));
+
+	if (coproc->read_thread) {
+		thread_cancel(coproc->read_thread);
+		coproc->read_thread = NULL;
+	}
+	close(coproc->in_fd);
+	close(coproc->out_fd);
+	coproc->pid = 0;
+}
+
+/* Release a persistent script when its configuration is freed, after its
+ * threads have been destroyed on shutdown or reload. */
+void
+coproc_release(script_coproc_t *coproc)
+{
+	if (!coproc->pid)
+		return;
+
+	/* It may already have exited, and been reaped */
+	if (getpgid(coproc->pid) == coproc->pid)
+		kill(-coproc->pid, SIGKILL);
+
+	close(coproc->in_fd);
+	close(coproc->out_fd);
+	coproc->pid = 0;
+}
+
 int
 child_killed_thread(thread_t *thread)
 {
 	thread_master_t *m = thread->master;
+	pid_t pgid;
 
 	/* If the child didn't die, then force it */
-	if (thread->type == THREAD_CHILD_TIMEOUT)
-		kill(-getpgid(thread->u.c.pid), SIGKILL);
+	if (thread->type == THREAD_CHILD_TIMEOUT) {
+		pgid = getpgid(thread->u.c.pid);
+		if (pgid > 0)
+			kill(-pgid, SIGKILL);
+	}
 
 	/* If all children have died, we can now complete the
 	 * termination process */
@@ -450,6 +1183,9 @@ script_killall(thread_master_t *m, int signo, bool requeue)
 	//通过信号signo通知所有子进程
 	rb_for_each_entry_cached(thread, &m->child, n) {
 		c_pgid = getpgid(thread->u.c.pid);
+		/* A script run by the spawner may have been reaped already */
+		if (c_pgid == -1)
+			continue;
 		if (c_pgid != p_pgid)
 			kill(-c_pgid, signo);
 		else {
@@ -64,6 +64,19 @@ typedef struct _notify_script {
 	gid_t	gid;		/* gid of group to execute script */
 } notify_script_t;
 
+/* A persistent script, or co-process, is started once and then sent a
+ * request line on its stdin each time it is to be run. It replies with a
+ * line on its stdout holding the value it would otherwise have exited with. */
+typedef struct _script_coproc {
+	pid_t		pid;		/* 0 if not running; the fds are only valid if set */
+	int		in_fd;		/* script's stdin */
+	int		out_fd;		/* script's stdout */
+	const notify_script_t *script;
+	thread_t	*read_thread;
+	size_t		len;		/* of the reply read so far */
+	char		buf[16];
+} script_coproc_t;
+
 /* notify_fifo details */
 typedef struct _notify_fifo {
 	char	*name;
@@ -97,6 +110,15 @@ extern void notify_fifo_close(notify_fifo_t*, notify_fifo_t*);
 extern int system_call_script(thread_master_t *, int (*)(thread_t *), void *, unsigned long, notify_script_t *);
 extern int notify_exec(const notify_script_t *);
 extern int child_killed_thread(thread_t *);
+extern void start_script_spawner(void);
+extern void add_script_spawner_read_thread(thread_master_t *);
+extern void set_script_vfork(bool);
+extern int coproc_start(thread_master_t *, int (*)(thread_t *), void *, script_coproc_t *, const notify_script_t *);
+extern int coproc_request(thread_master_t *, int (*)(thread_t *), void *, script_coproc_t *, const char *, unsigned long);
+extern int coproc_read(thread_t *, script_coproc_t *, int *);
+extern void coproc_kill(script_coproc_t *);
+extern void coproc_exited(script_coproc_t *, int);
+extern void coproc_release(script_coproc_t *);
 extern void script_killall(thread_master_t *, int, bool);
 extern int check_script_secure(notify_script_t *, magic_t);
 extern int check_notify_script_secure(notify_script_t **, magic_t);
@@ -71,16 +71,25 @@ typedef struct _defs {
 	char *(*fn)(void);
 } def_t;
 
+/* A configuration file read into memory */
+typedef struct _conf_stream {
+	const char *buf;
+	size_t len;
+	size_t pos;
+} conf_stream_t;
+
 /* global vars */
 vector_t *keywords;//存放全局的关键字
 char *config_id;
 const char *WHITE_SPACE = WHITE_SPACE_STR;
 
 /* local vars */
-static vector_t *current_keywords;
-static FILE *current_stream;//记录当前正在解析的配置文件file
+static name_table_t *keywords_index;	/* root keywords hashed by string */
+static name_table_t *current_keywords;
+static conf_stream_t current_stream;//记录当前正在解析的配置文件
 static const char *current_file_name;//记录正在解析的配置文件名称（如果只有一个配置文件，则不赋值）
 static size_t current_file_line_no;//记录正在解析的配置文件行号
+static const char *current_file_path;	/* even if current_file_name isn't set */
 static int sublevel = 0;
 static int skip_sublevel = 0;
 static list multiline_stack;
@@ -352,7 +361,7 @@ read_unsigned_base_strvec(const vector_t *strvec, size_t index, int base, unsign
 
 //存入keyword
 static void
-keyword_alloc(vector_t *keywords_vec, const char *string, void (*handler) (vector_t *), bool active)
+keyword_alloc(vector_t *keywords_vec, name_table_t **index, const char *string, void (*handler) (vector_t *), bool active)
 {
 	keyword_t *keyword;
 
@@ -366,6 +375,11 @@ keyword_alloc(vector_t *keywords_vec, const char *string, void (*handler) (vecto
 	keyword->active = active;
 
 	vector_set_slot(keywords_vec, keyword);
+
+	/* The vector keeps the keywords in order, the index is for lookup */
+	if (!*index)
+		*index = alloc_name_table();
+	name_table_add(*index, string, keyword);
 }
 
 //将string存为keywords_vec中第sublevel层的最后一个
@@ -395,7 +409,7 @@ keyword_alloc_sub(vector_t *keywords_vec, const char *string, void (*handler) (v
 
 	/* add new sub keyword */
 	//将关键字存入sub中
-	keyword_alloc(keyword->sub, string, handler, true);
+	keyword_alloc(keyword->sub, &keyword->sub_index, string, handler, true);
 }
 
 /* Exported helpers */
@@ -419,7 +433,7 @@ install_keyword_root(const char *string, void (*handler) (vector_t *), bool acti
 {
 	/* If the root keyword is inactive, the handler will still be called,
 	 * but with a NULL strvec */
-	keyword_alloc(keywords, string, handler, active);
+	keyword_alloc(keywords, &keywords_index, string, handler, active);
 }
 
 void
@@ -498,6 +512,7 @@ free_keywords(vector_t *keywords_vec)
 		keyword_vec = vector_slot(keywords_vec, i);
 		if (keyword_vec->sub)
 			free_keywords(keyword_vec->sub);
+		free_name_table(&keyword_vec->sub_index);
 		FREE(keyword_vec);
 	}
 	vector_free(keywords_vec);
@@ -884,19 +899,43 @@ dump_definitions(void)
 static int kw_level;
 static int block_depth;
 
+/* The lines read so far of the innermost block, and the block whose
+ * close handler is being run */
+static uint64_t block_hash;
+static uint64_t prev_block_hash;
+static const char *closed_block_file;
+static size_t closed_block_line;
+static uint64_t closed_block_hash;
+
+static inline uint64_t
+block_hash_add(uint64_t hash, uint64_t val)
+{
+	return (hash * 1099511628211ULL) ^ val;
+}
+
+static void
+block_hash_line(const char *buf, size_t len)
+{
+	prev_block_hash = block_hash;
+	block_hash = block_hash_add(block_hash, mem_hash(buf, len));
+}
+
 static bool
-process_stream(vector_t *keywords_vec, int need_bob)
+process_stream(name_table_t *kw_index, int need_bob)
 {
 	unsigned int i;
 	keyword_t *keyword_vec;
 	char *str;
 	char *buf;
 	vector_t *strvec;
-	vector_t *prev_keywords = current_keywords;
-	current_keywords = keywords_vec;
+	name_table_t *prev_keywords = current_keywords;
+	current_keywords = kw_index;
 	int bob_needed = 0;
 	bool ret_err = false;
 	bool ret;
+	uint64_t outer_hash, sub_hash;
+	const char *block_file;
+	size_t block_line;
 
 	buf = MALLOC(MAXBUF);
 	//读一行数据，展开$指明的变量，处理include指令
@@ -969,6 +1008,7 @@ process_stream(vector_t *keywords_vec, int need_bob)
 		if (!strncmp(str, "~SEQ", 4)) {
 			if (!add_seq(buf))
 				report_config_error(CONFIG_GENERAL_ERROR, "Invalid ~SEQ specification '%s'", buf);
+			block_hash = prev_block_hash;
 			free_strvec(strvec);
 #ifdef PARSER_DEBUG
 			dump_definitions();
@@ -977,64 +1017,74 @@ process_stream(vector_t *keywords_vec, int need_bob)
 			continue;
 		}
 
-		//将str与keywords_vec中的值进行匹配，匹配命令
-		for (i = 0; i < vector_size(keywords_vec); i++) {
-			keyword_vec = vector_slot(keywords_vec, i);
-
-			if (!strcmp(keyword_vec->string, str)) {
-				//str与keyword_vec匹配成功
-				if (!keyword_vec->active) {
-					if (!strcmp(vector_slot(strvec, vector_size(strvec)-1), BOB))
-						skip_sublevel = 1;
-					else
-						skip_sublevel = -1;
-
-					/* Sometimes a process wants to know if another process
-					 * has any of a type of configuration. For example, there
-					 * is no point starting the VRRP process of there are no
-					 * vrrp instances, and so the parent process would be
-					 * interested in that. */
-					if (keyword_vec->handler)
-						(*keyword_vec->handler)(NULL);
-				}
+		//将str与kw_index中的值进行匹配，匹配命令
+		keyword_vec = kw_index ? name_table_lookup(kw_index, str) : NULL;
+		if (!keyword_vec) {
+			report_config_error(CONFIG_UNKNOWN_KEYWORD, "Unknown keyword '%s'", str);
+			free_strvec(strvec);
+			continue;
+		}
 
-				/* There is an inconsistency here. 'static_ipaddress' for example
-				 * does not have sub levels, but needs a '{' */
-				if (keyword_vec->sub) {
-					/* Remove a trailing '{' */
-					char *bob = vector_slot(strvec, vector_size(strvec)-1) ;
-					if (!strcmp(bob, BOB)) {
-						vector_unset(strvec, vector_size(strvec)-1);
-						FREE(bob);
-						bob_needed = 0;
-					}
-					else
-						bob_needed = 1;
-				}
+		//str与keyword_vec匹配成功
+		if (!keyword_vec->active) {
+			if (!strcmp(vector_slot(strvec, vector_size(strvec)-1), BOB))
+				skip_sublevel = 1;
+			else
+				skip_sublevel = -1;
+
+			/* Sometimes a process wants to know if another process
+			 * has any of a type of configuration. For example, there
+			 * is no point starting the VRRP process of there are no
+			 * vrrp instances, and so the parent process would be
+			 * interested in that. */
+			if (keyword_vec->handler)
+				(*keyword_vec->handler)(NULL);
+		}
 
-				//与keyword_vec匹配，调用回调，传入本行解析的strvec
-				if (keyword_vec->active && keyword_vec->handler) {
-					buf_extern = buf;	/* In case the raw line wants to be accessed */
-					(*keyword_vec->handler) (strvec);
-				}
+		/* There is an inconsistency here. 'static_ipaddress' for example
+		 * does not have sub levels, but needs a '{' */
+		if (keyword_vec->sub) {
+			/* Remove a trailing '{' */
+			char *bob = vector_slot(strvec, vector_size(strvec)-1) ;
+			if (!strcmp(bob, BOB)) {
+				vector_unset(strvec, vector_size(strvec)-1);
+				FREE(bob);
+				bob_needed = 0;
+			}
+			else
+				bob_needed = 1;
+		}
 
-				//如果此keyword_vec有内部命令，则递归处理
-				if (keyword_vec->sub) {
-					kw_level++;
-					ret = process_stream(keyword_vec->sub, bob_needed);
-					kw_level--;
+		//与keyword_vec匹配，调用回调，传入本行解析的strvec
+		if (keyword_vec->active && keyword_vec->handler) {
+			buf_extern = buf;	/* In case the raw line wants to be accessed */
+			(*keyword_vec->handler) (strvec);
+		}
 
-					/* We mustn't run any close handler if the block was skipped */
-					if (!ret && keyword_vec->active && keyword_vec->sub_close_handler)
-						(*keyword_vec->sub_close_handler) ();
-				}
-				break;
+		//如果此keyword_vec有内部命令，则递归处理
+		if (keyword_vec->sub) {
+			block_file = current_file_path;
+			block_line = current_file_line_no;
+			outer_hash = block_hash;
+			block_hash = 0;
+
+			kw_level++;
+			ret = process_stream(keyword_vec->sub_index, bob_needed);
+			kw_level--;
+
+			/* The block's lines are part of the enclosing block */
+			sub_hash = block_hash;
+			block_hash = block_hash_add(outer_hash, sub_hash);
+
+			/* We mustn't run any close handler if the block was skipped */
+			if (!ret && keyword_vec->active && keyword_vec->sub_close_handler) {
+				closed_block_file = block_file;
+				closed_block_line = block_line;
+				closed_block_hash = sub_hash;
+				(*keyword_vec->sub_close_handler) ();
 			}
 		}
 
-		if (i >= vector_size(keywords_vec))
-			report_config_error(CONFIG_UNKNOWN_KEYWORD, "Unknown keyword '%s'", str);
-
 		free_strvec(strvec);
 	}
 
@@ -1046,12 +1096,16 @@ process_stream(vector_t *keywords_vec, int need_bob)
 static bool
 read_conf_file(const char *conf_file)
 {
-	FILE *stream;
+	int fd;
+	char *file_buf;
+	size_t file_len;
+	ssize_t len;
 	glob_t globbuf;
 	size_t i;
 	int	res;
 	struct stat stb;
 	unsigned num_matches = 0;
+	const char *prev_file_path = current_file_path;
 
 	globbuf.gl_offs = 0;
 	//首先按conf_file通配配置文件
@@ -1079,9 +1133,9 @@ read_conf_file(const char *conf_file)
 		}
 
 		log_message(LOG_INFO, "Opening file '%s'.", globbuf.gl_pathv[i]);
-		stream = fopen(globbuf.gl_pathv[i], "r");
+		fd = open(globbuf.gl_pathv[i], O_RDONLY | O_CLOEXEC);
 		//跳过打不开的文件
-		if (!stream) {
+		if (fd == -1) {
 			log_message(LOG_INFO, "Configuration file '%s' open problem (%s) - skipping"
 				       , globbuf.gl_pathv[i], strerror(errno));
 			continue;
@@ -1089,23 +1143,55 @@ read_conf_file(const char *conf_file)
 
 		/* Make sure what we have opened is a regular file, and not for example a directory or executable */
 		//跳过非规则文件，跳过有执行权限的文件
-		if (fstat(fileno(stream), &stb) ||
+		if (fstat(fd, &stb) ||
 		    !S_ISREG(stb.st_mode) ||
 		    (stb.st_mode & (S_IXUSR | S_IXGRP | S_IXOTH))) {
 			log_message(LOG_INFO, "Configuration file '%s' is not a regular non-executable file - skipping", globbuf.gl_pathv[i]);
-			fclose(stream);
+			close(fd);
+			continue;
+		}
+
+		/* Lines are scanned straight out of a buffer holding the whole
+		 * file rather than through stdio. The file is read rather than
+		 * mapped, since a mapping of a file truncated while it is being
+		 * parsed raises SIGBUS; if the file is truncated while being read
+		 * the parse just ends early, as it did with stdio. The buffer isn't
+		 * allocated with MALLOC(), since it would then stay in any
+		 * configuration arena until the arena is released. */
+		file_buf = NULL;
+		file_len = 0;
+		if (stb.st_size && !(file_buf = malloc((size_t)stb.st_size))) {
+			log_message(LOG_INFO, "Configuration file '%s' too large to read - skipping"
+				       , globbuf.gl_pathv[i]);
+			close(fd);
 			continue;
 		}
+		while (file_len < (size_t)stb.st_size) {
+			len = read(fd, file_buf + file_len, (size_t)stb.st_size - file_len);
+			if (len == -1 && errno == EINTR)
+				continue;
+			if (len <= 0) {
+				if (len == -1)
+					log_message(LOG_INFO, "Configuration file '%s' read problem (%s)"
+						       , globbuf.gl_pathv[i], strerror(errno));
+				break;
+			}
+			file_len += (size_t)len;
+		}
+		close(fd);
 
 		//匹配数加1
 		num_matches++;
 
-		current_stream = stream;//当前stream
+		current_stream.buf = file_buf;//当前stream
+		current_stream.len = file_len;
+		current_stream.pos = 0;
 
 		/* We only want to report the file name if there is more than one file used */
 		if (current_file_name || globbuf.gl_pathc > 1)
 			current_file_name = globbuf.gl_pathv[i];//当前配置文件名称
 		current_file_line_no = 0;//当前配置文件行号
+		current_file_path = globbuf.gl_pathv[i];
 
 		//记录旧的工作目录，以便一会切回来
 		int curdir_fd = -1;
@@ -1132,7 +1218,7 @@ read_conf_file(const char *conf_file)
 
 		//配置文件解析
 		process_stream(current_keywords, 0);
-		fclose(stream);
+		free(file_buf);
 
 		free_list(&seq_list);
 
@@ -1142,11 +1228,15 @@ read_conf_file(const char *conf_file)
 			if ((res = fchdir(curdir_fd)))
 				log_message(LOG_INFO, "Failed to restore previous directory after include");
 			close(curdir_fd);
-			if (res)
+			if (res) {
+				current_file_path = prev_file_path;
 				return true;
+			}
 		}
 	}
 
+	current_file_path = prev_file_path;
+
 	globfree(&globbuf);
 
 	if (!num_matches)
@@ -1225,7 +1315,7 @@ check_include(char *buf)
 {
 	vector_t *strvec;
 	bool ret = false;
-	FILE *prev_stream;
+	conf_stream_t prev_stream;
 	const char *prev_file_name;
 	size_t prev_file_line_no;
 
@@ -1630,6 +1720,50 @@ decomment(char *str)
 	}
 }
 
+/* Copy the next non-blank line of the file's buffer into buf, without
+ * its end of line chars or leading whitespace. As with fgets(), a line
+ * longer than size - 1 is returned in pieces. */
+static bool
+read_stream_line(char *buf, size_t size)
+{
+	const char *line, *end, *eol;
+	size_t len;
+
+	do {
+		if (current_stream.pos >= current_stream.len)
+			return false;
+
+		line = current_stream.buf + current_stream.pos;
+		end = current_stream.buf + current_stream.len;
+		if ((size_t)(end - line) > size - 1)
+			end = line + size - 1;
+
+		if ((eol = memchr(line, '\n', (size_t)(end - line)))) {
+			current_stream.pos += (size_t)(eol - line) + 1;
+			current_file_line_no++;//增加行号
+		} else {
+			current_stream.pos += (size_t)(end - line);
+			eol = end;
+		}
+
+		/* Remove end of line chars */
+		while (eol > line && eol[-1] == '\r')
+			eol--;
+
+		/* Skip blank lines */
+	} while (eol == line);
+
+	/* decomment() would only have to move the line down */
+	while (line < eol && (*line == ' ' || *line == '\t'))
+		line++;
+
+	len = (size_t)(eol - line);
+	memcpy(buf, line, len);
+	buf[len] = '\0';
+
+	return true;
+}
+
 static bool
 read_line(char *buf, size_t size)
 {
@@ -1691,30 +1825,14 @@ read_line(char *buf, size_t size)
 			}
 		}
 		else {
-retry:
 			//自当前配置文件中读取一行数据
-			if (!fgets(buf, (int)size, current_stream))
+			if (!read_stream_line(buf, size))
 			{
 				eof = true;
 				buf[0] = '\0';
 				break;
 			}
 
-			/* Check if we have read the end of a line */
-			len = strlen(buf);
-			if (buf[0] && buf[len-1] == '\n')
-				current_file_line_no++;//增加行号
-
-			/* Remove end of line chars */
-			while (len && (buf[len-1] == '\n' || buf[len-1] == '\r'))
-				len--;
-
-			/* Skip blank lines */
-			if (!len)
-				goto retry;
-
-			buf[len] = '\0';
-
 			decomment(buf);
 		}
 
@@ -1866,6 +1984,9 @@ retry:
 	log_message(LOG_INFO, "read_line(%d): '%s'", block_depth, buf);
 #endif
 
+	if (!eof)
+		block_hash_line(buf, strlen(buf));
+
 	return !eof;
 }
 
@@ -2019,6 +2140,47 @@ void skip_block(bool need_block_start)
 		skip_sublevel = 1;
 }
 
+/* For a block's close handler to record where the block was read from
+ * and a hash of its lines, after definitions, ~SEQ and includes have been
+ * expanded. The lines of nested blocks, including those read by handlers
+ * such as for virtual_ipaddress, are part of the hash. */
+void
+get_config_block(config_block_t *block)
+{
+	if (closed_block_file) {
+		block->file_name = MALLOC(strlen(closed_block_file) + 1);
+		strcpy(block->file_name, closed_block_file);
+	} else
+		block->file_name = NULL;
+	block->line_no = closed_block_line;
+	block->hash = closed_block_hash;
+}
+
+void
+free_config_block(config_block_t *block)
+{
+	FREE_PTR(block->file_name);
+}
+
+/* A block read identically before and after a reload */
+bool
+config_block_unchanged(const config_block_t *old, const config_block_t *new)
+{
+	return old->hash && old->hash == new->hash;
+}
+
+/* Format where a block starts into buf, for logging */
+const char *
+config_block_location(const config_block_t *block, char *buf, size_t len)
+{
+	if (block->file_name)
+		snprintf(buf, len, "%s:%zu", block->file_name, block->line_no);
+	else
+		snprintf(buf, len, "line %zu", block->line_no);
+
+	return buf;
+}
+
 /* Data initialization */
 void
 init_data(const char *conf_file, vector_t * (*init_keywords) (void))
@@ -2037,7 +2199,7 @@ init_data(const char *conf_file, vector_t * (*init_keywords) (void))
 #endif
 
 	/* Stream handling */
-	current_keywords = keywords;
+	current_keywords = keywords_index;
 
 	current_file_name = NULL;
 	current_file_line_no = 0;
@@ -2062,6 +2224,7 @@ init_data(const char *conf_file, vector_t * (*init_keywords) (void))
 	endpwent();
 
 	free_keywords(keywords);
+	free_name_table(&keywords_index);
 	free_parser_data();
 #ifdef _WITH_VRRP_
 	clear_rt_names();
@@ -27,9 +27,11 @@
 #include <sys/types.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <limits.h>
 
 /* local includes */
 #include "vector.h"
+#include "name_table.h"
 
 /* Global definitions */
 #define KEEPALIVED_CONFIG_FILE	DEFAULT_CONFIG_FILE
@@ -70,10 +72,22 @@ typedef struct _keyword {
 	const char *string;//关键字的字面值
 	void (*handler) (vector_t *);//处理函数
 	vector_t *sub;//本关键字的下面keyword,这样将形成一棵树
+	name_table_t *sub_index;	/* sub keywords hashed by string */
 	void (*sub_close_handler) (void);
 	bool active;//如果此项不会true，则sub中无值
 } keyword_t;
 
+/* Where a configuration block was read from, and a hash of its lines
+ * after preprocessing, so that a reload can tell if it has changed */
+typedef struct _config_block {
+	char		*file_name;	/* as matched by the include */
+	size_t		line_no;
+	uint64_t	hash;
+} config_block_t;
+
+/* Buffer size for config_block_location(): "file:line" */
+#define CONFIG_BLOCK_LOCATION_LEN	(PATH_MAX + 22)
+
 /* global vars exported */
 extern vector_t *keywords;
 extern char *config_id;
@@ -114,6 +128,10 @@ extern void *set_value(vector_t *);
 extern bool read_timer(vector_t *, size_t, unsigned long *, unsigned long, unsigned long, bool);
 extern int check_true_false(char *);
 extern void skip_block(bool);
+extern void get_config_block(config_block_t *);
+extern void free_config_block(config_block_t *);
+extern bool config_block_unchanged(const config_block_t *, const config_block_t *);
+extern const char *config_block_location(const config_block_t *, char *, size_t);
 extern void init_data(const char *, vector_t * (*init_keywords) (void));
 
 #endif
@@ -42,6 +42,15 @@
 #endif
 #include <sys/utsname.h>
 #include <linux/version.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stddef.h>
+#ifdef _WITH_IO_URING_
+#include <poll.h>
+#endif
+#ifdef _WITH_THREAD_TRACE_
+#include <fcntl.h>
+#endif
 
 #include "scheduler.h"
 #include "memory.h"
@@ -58,6 +67,22 @@
 #include "assert_debug.h"
 
 
+/* Header of a contiguous chunk of thread_t or thread_event_t */
+typedef struct _thread_slab_chunk {
+	list_head_t e;
+	size_t size;
+	char objs[] __attribute__((aligned(sizeof(void *))));
+} thread_slab_chunk_t;
+
+/* Ready queue class of a thread function, and whether its timers can be
+ * coalesced */
+typedef struct _func_prio {
+	int (*func)(thread_t *);
+	thread_prio_t prio;
+	bool slack;
+	rb_node_t n;
+} func_prio_t;
+
 #ifdef THREAD_DUMP
 typedef struct _func_det {
 	const char *name;
@@ -67,7 +92,7 @@ typedef struct _func_det {
 #endif
 
 /* global vars */
-thread_master_t *master = NULL;
+THREAD_LOCAL thread_master_t *master = NULL;
 #ifndef _DEBUG_
 prog_type_t prog_type;		/* Parent/VRRP/Checker process */
 #endif
@@ -76,7 +101,7 @@ bool snmp_running;		/* True if this process is running SNMP */
 #endif
 
 /* local variables */
-static bool shutting_down;
+static THREAD_LOCAL bool shutting_down;
 static int sav_argc;
 static char **sav_argv;
 #ifdef _EPOLL_DEBUG_
@@ -85,6 +110,9 @@ bool do_epoll_debug;
 #ifdef _EPOLL_THREAD_DUMP_
 bool do_epoll_thread_dump;
 #endif
+#ifdef _WITH_THREAD_TRACE_
+const char *thread_trace_dir;	/* record scheduler traces here if set */
+#endif
 #ifdef THREAD_DUMP
 static rb_root_t funcs = RB_ROOT;
 #endif
@@ -93,6 +121,10 @@ static void (*extra_threads_debug)(void);
 #endif
 
 
+#ifdef _WITH_SNMP_
+static int snmp_read_thread(thread_t *);
+#endif
+
 /* Function that returns prog_name if pid is a known child */
 static char const * (*child_finder_name)(pid_t);
 
@@ -134,7 +166,7 @@ function_cmp(const func_det_t *func1, const func_det_t *func2)
 	return 0;
 }
 
-static const char *
+const char *
 get_function_name(int (*func)(thread_t *))
 {
 	func_det_t func_det = { .func = func };
@@ -206,6 +238,290 @@ set_extra_threads_debug(void (*func)(void))
 }
 #endif
 
+#ifdef _WITH_THREAD_STATS_
+static inline unsigned
+thread_stats_bucket(unsigned long usecs)
+{
+	unsigned bucket;
+
+	if (!usecs)
+		return 0;
+
+	bucket = (unsigned)(sizeof(usecs) * CHAR_BIT) - (unsigned)__builtin_clzl(usecs);
+
+	return bucket < THREAD_STATS_BUCKETS ? bucket : THREAD_STATS_BUCKETS - 1;
+}
+
+static int
+thread_func_stats_cmp(const thread_func_stats_t *s1, const thread_func_stats_t *s2)
+{
+	if (s1->func < s2->func)
+		return -1;
+	if (s1->func > s2->func)
+		return 1;
+	return 0;
+}
+
+static void
+thread_stats_update(thread_master_t *m, int (*func)(thread_t *), timeval_t ready, timeval_t start, timeval_t end)
+{
+	thread_func_stats_t key = { .func = func };
+	thread_func_stats_t *stats;
+	timeval_t diff;
+	unsigned long run, delay;
+
+	stats = rb_search(&m->func_stats, &key, n, thread_func_stats_cmp);
+	if (!stats) {
+		stats = (thread_func_stats_t *)MALLOC(sizeof(thread_func_stats_t));
+		stats->func = func;
+		rb_insert_sort(&m->func_stats, stats, n, thread_func_stats_cmp);
+	}
+
+	stats->count++;
+
+	timersub(&end, &start, &diff);
+	run = timer_long(diff);
+	stats->run_total += run;
+	if (run > stats->run_max)
+		stats->run_max = run;
+	stats->run_hist[thread_stats_bucket(run)]++;
+
+	/* Threads that were never queued, or whose timer fired early, have
+	 * no delay */
+	if (!ready.tv_sec || timercmp(&start, &ready, <))
+		delay = 0;
+	else {
+		timersub(&start, &ready, &diff);
+		delay = timer_long(diff);
+	}
+	stats->delay_total += delay;
+	if (delay > stats->delay_max)
+		stats->delay_max = delay;
+	stats->delay_hist[thread_stats_bucket(delay)]++;
+}
+
+static void
+thread_stats_destroy(thread_master_t *m)
+{
+	thread_func_stats_t *stats, *stats_tmp;
+
+	rb_for_each_entry_safe(stats, stats_tmp, &m->func_stats, n) {
+		rb_erase(&stats->n, &m->func_stats);
+		FREE(stats);
+	}
+}
+
+static void
+thread_stats_hist_dump(const unsigned long *hist, const char *type, FILE *fp)
+{
+	char buf[THREAD_STATS_BUCKETS * 24];
+	size_t len = 0;
+	unsigned i;
+
+	for (i = 0; i < THREAD_STATS_BUCKETS; i++) {
+		if (!hist[i])
+			continue;
+		if (i < THREAD_STATS_BUCKETS - 1)
+			len += (size_t)snprintf(buf + len, sizeof(buf) - len, " <%luus:%lu", 1UL << i, hist[i]);
+		else
+			len += (size_t)snprintf(buf + len, sizeof(buf) - len, " >=%luus:%lu", 1UL << (i - 1), hist[i]);
+		if (len >= sizeof(buf))
+			break;
+	}
+
+	conf_write(fp, "   %s histogram:%s", type, len ? buf : " none");
+}
+
+void
+dump_thread_stats(thread_master_t *m, FILE *fp)
+{
+	thread_func_stats_t *stats;
+
+	conf_write(fp, "----[ Begin thread_stats ]----");
+	conf_write(fp, " timer wakeups %lu, timers expired %lu (%.2f per wakeup), timers coalesced %lu, timer slack %luus",
+		   m->timer_wakeups, m->timer_expired,
+		   m->timer_wakeups ? (double)m->timer_expired / m->timer_wakeups : 0.0,
+		   m->timer_coalesced, m->timer_slack);
+	rb_for_each_entry(stats, &m->func_stats, n) {
+		conf_write(fp, " %s(): calls %lu, run avg %" PRIu64 "us max %luus, delay avg %" PRIu64 "us max %luus",
+			   get_function_name(stats->func), stats->count,
+			   stats->run_total / stats->count, stats->run_max,
+			   stats->delay_total / stats->count, stats->delay_max);
+		thread_stats_hist_dump(stats->run_hist, "run  ", fp);
+		thread_stats_hist_dump(stats->delay_hist, "delay", fp);
+	}
+	conf_write(fp, "----[ End thread_stats ]----");
+}
+
+/* Record when a thread became runnable. Timers are runnable from when
+ * they expire, everything else from when the scheduler noticed it. */
+static inline void
+thread_set_ready_time(thread_t *thread, int type)
+{
+	if (type == THREAD_READY || type == THREAD_READ_TIMEOUT ||
+	    type == THREAD_WRITE_TIMEOUT || type == THREAD_CHILD_TIMEOUT)
+		thread->ready_time = thread->sands;
+	else
+		thread->ready_time = time_now;
+}
+#endif
+
+static int
+func_prio_cmp(const func_prio_t *p1, const func_prio_t *p2)
+{
+	if (p1->func < p2->func)
+		return -1;
+	if (p1->func > p2->func)
+		return 1;
+	return 0;
+}
+
+static thread_prio_t
+thread_get_priority(thread_master_t *m, int (*func)(thread_t *))
+{
+	func_prio_t key = { .func = func };
+	func_prio_t *match;
+
+	if (RB_EMPTY_ROOT(&m->func_prio))
+		return THREAD_PRIO_NORMAL;
+
+	match = rb_search(&m->func_prio, &key, n, func_prio_cmp);
+
+	return match ? match->prio : THREAD_PRIO_NORMAL;
+}
+
+/* Set the ready queue class used for threads running func */
+void
+thread_set_func_priority(thread_master_t *m, int (*func)(thread_t *), thread_prio_t prio)
+{
+	func_prio_t key = { .func = func };
+	func_prio_t *match;
+
+	match = rb_search(&m->func_prio, &key, n, func_prio_cmp);
+	if (match) {
+		match->prio = prio;
+		return;
+	}
+
+	match = (func_prio_t *)MALLOC(sizeof(func_prio_t));
+	match->func = func;
+	match->prio = prio;
+	rb_insert_sort(&m->func_prio, match, n, func_prio_cmp);
+}
+
+/* Allow the timers of func to be delayed by up to the master's timer slack,
+ * so that they can expire together. Not for anything that must be exact,
+ * such as VRRP adverts. */
+void
+thread_set_func_slack(thread_master_t *m, int (*func)(thread_t *))
+{
+	func_prio_t key = { .func = func };
+	func_prio_t *match;
+
+	match = rb_search(&m->func_prio, &key, n, func_prio_cmp);
+	if (match) {
+		match->slack = true;
+		return;
+	}
+
+	match = (func_prio_t *)MALLOC(sizeof(func_prio_t));
+	match->func = func;
+	match->prio = THREAD_PRIO_NORMAL;
+	match->slack = true;
+	rb_insert_sort(&m->func_prio, match, n, func_prio_cmp);
+}
+
+static bool
+thread_get_slack(thread_master_t *m, int (*func)(thread_t *))
+{
+	func_prio_t key = { .func = func };
+	func_prio_t *match;
+
+	if (!m->timer_slack || RB_EMPTY_ROOT(&m->func_prio))
+		return false;
+
+	match = rb_search(&m->func_prio, &key, n, func_prio_cmp);
+
+	return match && match->slack;
+}
+
+/* Set the timer slack in micro-seconds, 0 to disable coalescing. Only
+ * affects timers added afterwards. */
+void
+thread_set_timer_slack(thread_master_t *m, unsigned long slack)
+{
+	m->timer_slack = slack;
+}
+
+/* Round the expiry of a timer that can be delayed up to the next multiple of
+ * the timer slack. All such timers due within the same slack period then
+ * expire at the same time, and need only one wakeup. */
+static void
+thread_timer_coalesce(thread_master_t *m, timeval_t *sands)
+{
+	uint64_t usecs, rounded;
+
+	usecs = (uint64_t)sands->tv_sec * TIMER_HZ + (uint64_t)sands->tv_usec;
+	rounded = (usecs + m->timer_slack - 1) / m->timer_slack * m->timer_slack;
+	if (rounded == usecs)
+		return;
+
+	sands->tv_sec = (time_t)(rounded / TIMER_HZ);
+	sands->tv_usec = (suseconds_t)(rounded % TIMER_HZ);
+#ifdef _WITH_THREAD_STATS_
+	m->timer_coalesced++;
+#endif
+}
+
+static void
+thread_destroy_func_priorities(thread_master_t *m)
+{
+	func_prio_t *prio, *prio_tmp;
+
+	rb_for_each_entry_safe(prio, prio_tmp, &m->func_prio, n) {
+		rb_erase(&prio->n, &m->func_prio);
+		FREE(prio);
+	}
+}
+
+/* Queue a runnable thread on the ready queue of its class */
+static inline void
+thread_add_ready(thread_master_t *m, thread_t *thread)
+{
+	INIT_LIST_HEAD(&thread->next);
+	list_add_tail(&thread->next, &m->ready[thread_get_priority(m, thread->func)]);
+}
+
+/* Select the ready queue to run next. The highest class with a ready
+ * thread runs, unless a lower class has been passed over
+ * THREAD_PRIO_STARVE_LIMIT times, in which case it gets one turn. */
+static list_head_t *
+thread_next_ready_queue(thread_master_t *m)
+{
+	int prio, top = -1;
+
+	for (prio = THREAD_PRIO_BULK; prio >= THREAD_PRIO_CRITICAL; prio--) {
+		if (list_empty(&m->ready[prio]))
+			continue;
+		if (m->ready_skipped[prio] >= THREAD_PRIO_STARVE_LIMIT) {
+			m->ready_skipped[prio] = 0;
+			return &m->ready[prio];
+		}
+		top = prio;
+	}
+
+	if (top < 0)
+		return NULL;
+
+	m->ready_skipped[top] = 0;
+	for (prio = top + 1; prio < THREAD_PRIO_MAX; prio++) {
+		if (!list_empty(&m->ready[prio]))
+			m->ready_skipped[prio]++;
+	}
+
+	return &m->ready[top];
+}
+
 /* Move ready thread into ready queue */
 static int
 thread_move_ready(thread_master_t *m, rb_root_cached_t *root, thread_t *thread, int type)
@@ -213,10 +529,12 @@ thread_move_ready(thread_master_t *m, rb_root_cached_t *root, thread_t *thread,
 	//将thread自root中移除
 	rb_erase_cached(&thread->n, root);
 	//初始化next指针，并将thread加入到ready链上
-	INIT_LIST_HEAD(&thread->next);
-	list_add_tail(&thread->next, &m->ready);//将thread加入到ready链上
+	thread_add_ready(m, thread);
 	if (thread->type != THREAD_TIMER_SHUTDOWN)
 		thread->type = type;
+#ifdef _WITH_THREAD_STATS_
+	thread_set_ready_time(thread, type);
+#endif
 	return 0;
 }
 
@@ -235,6 +553,15 @@ thread_rb_move_ready(thread_master_t *m, rb_root_cached_t *root, int type)
 			thread->event->read = NULL;
 		else if (type == THREAD_WRITE_TIMEOUT)
 			thread->event->write = NULL;
+		else if (type == THREAD_CHILD_TIMEOUT) {
+			/* The timeout function may kill the child and wait
+			 * for it again with a new child thread */
+			rb_erase(&thread->rb_data, &m->child_pid);
+		}
+#ifdef _WITH_THREAD_STATS_
+		else if (type == THREAD_READY)
+			m->timer_expired++;
+#endif
 		thread_move_ready(m, root, thread, type);
 	}
 }
@@ -262,6 +589,268 @@ thread_update_timer(rb_root_cached_t *root, timeval_t *timer_min)
 		*timer_min = first->sands;
 }
 
+/* Timer wheel. Timer threads are hashed by expiry tick into a hierarchy
+ * of wheels, giving O(1) insert, cancel and expiry. Expiry is still checked
+ * against the exact sands value for the current tick, so timers fire no
+ * earlier and no later than with the rb tree. */
+static inline bool
+timer_wheel_disabled(const timeval_t *sands)
+{
+	/* TIMER_NEVER via timer_add_long() gives LONG_MAX, which would overflow the tick */
+	return sands->tv_sec == TIMER_DISABLED ||
+	       sands->tv_sec > LONG_MAX / (long)(TIMER_HZ / TIMER_WHEEL_TICK);
+}
+
+static inline uint64_t
+timer_wheel_tick(const timeval_t *sands)
+{
+	return (uint64_t)sands->tv_sec * (TIMER_HZ / TIMER_WHEEL_TICK) +
+	       (uint64_t)sands->tv_usec / TIMER_WHEEL_TICK;
+}
+
+static timer_wheel_t *
+timer_wheel_new(void)
+{
+	timer_wheel_t *w;
+	unsigned level, i;
+
+	w = (timer_wheel_t *) MALLOC(sizeof(timer_wheel_t));
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		for (i = 0; i < TIMER_WHEEL_SLOTS; i++)
+			INIT_LIST_HEAD(&w->slot[level][i]);
+	}
+	INIT_LIST_HEAD(&w->disabled);
+
+	set_time_now();
+	w->now = timer_wheel_tick(&time_now);
+	w->next_valid = true;
+
+	return w;
+}
+
+static void
+timer_wheel_add(timer_wheel_t *w, thread_t *thread)
+{
+	uint64_t expires, delta;
+	unsigned level, idx;
+
+	if (timer_wheel_disabled(&thread->sands)) {
+		list_add_tail(&thread->next, &w->disabled);
+		return;
+	}
+
+	/* An empty wheel may not have been run for a while */
+	if (!w->count && timer_wheel_tick(&time_now) > w->now)
+		w->now = timer_wheel_tick(&time_now);
+
+	expires = timer_wheel_tick(&thread->sands);
+	if (expires < w->now)
+		expires = w->now;
+	delta = expires - w->now;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+		if (delta < (uint64_t)1 << (TIMER_WHEEL_BITS * (level + 1)))
+			break;
+	}
+
+	/* Beyond the span of the wheel, park it in the furthest slot. It
+	 * will be re-inserted when that slot is cascaded. */
+	if (delta >> (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+		expires = w->now + ((uint64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+
+	idx = (expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+	list_add_tail(&thread->next, &w->slot[level][idx]);
+	__set_bit(idx, w->map[level]);
+	w->count++;
+
+	if (w->next_valid &&
+	    (!timerisset(&w->next) || timercmp(&thread->sands, &w->next, <)))
+		w->next = thread->sands;
+}
+
+static void
+timer_wheel_del(timer_wheel_t *w, thread_t *thread)
+{
+	/* The slot bitmap is cleared lazily when the slot is next searched */
+	list_head_del(&thread->next);
+
+	if (timer_wheel_disabled(&thread->sands))
+		return;
+
+	if (!--w->count) {
+		timerclear(&w->next);
+		w->next_valid = true;
+	}
+	else if (w->next_valid && timercmp(&thread->sands, &w->next, ==))
+		w->next_valid = false;
+}
+
+/* Find the first non-empty slot of a level, searching circularly from start */
+static int
+timer_wheel_next_slot(timer_wheel_t *w, unsigned level, unsigned start)
+{
+	unsigned long *map = w->map[level];
+	unsigned long bits;
+	unsigned word;
+	unsigned n;
+	unsigned idx;
+
+	for (n = 0; n <= TIMER_WHEEL_MAP_LONGS; n++) {
+		word = (BIT_WORD(start) + n) % TIMER_WHEEL_MAP_LONGS;
+		bits = map[word];
+		if (n == 0)
+			bits &= ~0UL << (start % BIT_PER_LONG);
+		else if (n == TIMER_WHEEL_MAP_LONGS)
+			bits &= ~(~0UL << (start % BIT_PER_LONG));
+
+		while (bits) {
+			idx = word * BIT_PER_LONG + (unsigned)ffsl((long)bits) - 1;
+			if (!list_empty(&w->slot[level][idx]))
+				return (int)idx;
+			__clear_bit(idx, map);
+			bits &= bits - 1;
+		}
+	}
+
+	return -1;
+}
+
+/* Return the earliest expiry time on the wheel. Slots at each level are in
+ * expiry order starting from the current position, so only the first
+ * non-empty slot of each level needs to be examined. */
+static void
+timer_wheel_update_timer(timer_wheel_t *w, timeval_t *timer_min)
+{
+	thread_t *thread;
+	unsigned level;
+	unsigned start;
+	int idx;
+
+	if (!w->next_valid) {
+		timerclear(&w->next);
+		for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+			start = (unsigned)(w->now >> (TIMER_WHEEL_BITS * level));
+			if (level)
+				start++;
+			idx = timer_wheel_next_slot(w, level, start & TIMER_WHEEL_MASK);
+			if (idx < 0)
+				continue;
+			list_for_each_entry(thread, &w->slot[level][idx], next) {
+				if (!timerisset(&w->next) || timercmp(&thread->sands, &w->next, <))
+					w->next = thread->sands;
+			}
+		}
+		w->next_valid = true;
+	}
+
+	if (!timerisset(&w->next))
+		return;
+
+	if (!timerisset(timer_min) ||
+	    timercmp(&w->next, timer_min, <=))
+		*timer_min = w->next;
+}
+
+/* Redistribute the timers of a higher level slot into the lower levels */
+static void
+timer_wheel_cascade(timer_wheel_t *w, unsigned level, unsigned idx)
+{
+	thread_t *thread, *thread_tmp;
+	list_head_t l;
+
+	if (list_empty(&w->slot[level][idx]))
+		return;
+
+	INIT_LIST_HEAD(&l);
+	list_splice_init(&w->slot[level][idx], &l);
+	__clear_bit(idx, w->map[level]);
+
+	list_for_each_entry_safe(thread, thread_tmp, &l, next) {
+		list_head_del(&thread->next);
+		w->count--;
+		timer_wheel_add(w, thread);
+	}
+}
+
+/* Move all expired timers onto the ready queue */
+static void
+timer_wheel_move_ready(thread_master_t *m, timer_wheel_t *w)
+{
+	thread_t *thread, *thread_tmp;
+	uint64_t target = timer_wheel_tick(&time_now);
+	uint64_t next_tick;
+	unsigned level;
+	unsigned idx;
+	int next;
+
+	if (!w->count) {
+		if (target > w->now)
+			w->now = target;
+		return;
+	}
+
+	while (true) {
+		idx = w->now & TIMER_WHEEL_MASK;
+		list_for_each_entry_safe(thread, thread_tmp, &w->slot[0][idx], next) {
+			/* Timers in the current tick may not have expired yet */
+			if (w->now >= target && timercmp(&time_now, &thread->sands, <))
+				continue;
+
+			timer_wheel_del(w, thread);
+			thread_add_ready(m, thread);
+			if (thread->type != THREAD_TIMER_SHUTDOWN)
+				thread->type = THREAD_READY;
+#ifdef _WITH_THREAD_STATS_
+			thread_set_ready_time(thread, THREAD_READY);
+			m->timer_expired++;
+#endif
+		}
+
+		if (w->now >= target)
+			break;
+
+		/* Skip empty slots up to the next cascade boundary */
+		next_tick = (w->now | TIMER_WHEEL_MASK) + 1;
+		if (idx != TIMER_WHEEL_MASK) {
+			next = timer_wheel_next_slot(w, 0, idx + 1);
+			if (next > (int)idx)
+				next_tick = (w->now & ~(uint64_t)TIMER_WHEEL_MASK) + (unsigned)next;
+		}
+		w->now = next_tick < target ? next_tick : target;
+
+		if (w->now & TIMER_WHEEL_MASK)
+			continue;
+
+		for (level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+			idx = (w->now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+			timer_wheel_cascade(w, level, idx);
+			if (idx)
+				break;
+		}
+	}
+
+	w->next_valid = false;
+}
+
+/* Move every timer on the wheel onto list l, leaving the wheel empty */
+static void
+timer_wheel_flush(timer_wheel_t *w, list_head_t *l)
+{
+	unsigned level, i;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		for (i = 0; i < TIMER_WHEEL_SLOTS; i++)
+			list_splice_init(&w->slot[level][i], l);
+	}
+	list_splice_init(&w->disabled, l);
+
+	memset(w->map, 0, sizeof(w->map));
+	w->count = 0;
+	timerclear(&w->next);
+	w->next_valid = true;
+}
+
 /* Compute the wait timer. Take care of timeouted fd */
 //计算timer_fd的等待时间
 static void
@@ -274,7 +863,10 @@ thread_set_timer(thread_master_t *m)
 	//收集m->timer,m->write,m->read,m->child的最小超时时间，将其
 	//做为timer_wait
 	timerclear(&timer_wait);
-	thread_update_timer(&m->timer, &timer_wait);
+	if (m->timer_wheel)
+		timer_wheel_update_timer(m->timer_wheel, &timer_wait);
+	else
+		thread_update_timer(&m->timer, &timer_wait);
 	thread_update_timer(&m->write, &timer_wait);
 	thread_update_timer(&m->read, &timer_wait);
 	thread_update_timer(&m->child, &timer_wait);
@@ -334,12 +926,19 @@ thread_timerfd_handler(thread_t *thread)
 	if (len < 0)
 		log_message(LOG_ERR, "scheduler: Error reading on timerfd fd:%d (%m)", m->timer_fd);
 
+#ifdef _WITH_THREAD_STATS_
+	m->timer_wakeups++;
+#endif
+
 	/* Read, Write, Timer, Child thread. */
 	//检查m->read,m->write,m->timer,m->child链上的所有事件
 	//利用当前时间timer_now,将过期时间小于timer_now的event全部移动到ready链上，并置相应的type
 	thread_rb_move_ready(m, &m->read, THREAD_READ_TIMEOUT);
 	thread_rb_move_ready(m, &m->write, THREAD_WRITE_TIMEOUT);
-	thread_rb_move_ready(m, &m->timer, THREAD_READY);
+	if (m->timer_wheel)
+		timer_wheel_move_ready(m, m->timer_wheel);
+	else
+		thread_rb_move_ready(m, &m->timer, THREAD_READY);
 	thread_rb_move_ready(m, &m->child, THREAD_CHILD_TIMEOUT);
 
 	/* Register next timerfd thread */
@@ -509,6 +1108,83 @@ report_child_status(int status, pid_t pid, char const *prog_name)
 }
 #endif
 
+/* Slab allocation of thread_t and thread_event_t. Objects are carved out of
+ * contiguous chunks and recycled through the unuse lists; the chunks are
+ * only released when the thread_master is destroyed. */
+static void
+thread_slab_grow(thread_master_t *m, list_head_t *free_list, thread_slab_stats_t *stats,
+		 size_t obj_size, size_t list_offset, unsigned num)
+{
+	thread_slab_chunk_t *chunk;
+	unsigned i;
+
+	chunk = MALLOC(sizeof(thread_slab_chunk_t) + num * obj_size);
+	chunk->size = num * obj_size;
+	list_add_tail(&chunk->e, &m->slab_chunks);
+
+	for (i = 0; i < num; i++)
+		list_add_tail((list_head_t *)(chunk->objs + i * obj_size + list_offset), free_list);
+
+	stats->total += num;
+}
+
+static void *
+thread_slab_get(thread_master_t *m, list_head_t *free_list, thread_slab_stats_t *stats,
+		size_t obj_size, size_t list_offset)
+{
+	list_head_t *e;
+
+	if (list_empty(free_list)) {
+		thread_slab_grow(m, free_list, stats, obj_size, list_offset, THREAD_SLAB_CHUNK);
+		stats->miss++;
+	}
+	else
+		stats->hit++;
+
+	e = free_list->next;
+	list_del_init(e);
+
+	if (++stats->in_use > stats->high_water)
+		stats->high_water = stats->in_use;
+
+	return (char *)e - list_offset;
+}
+
+static void
+thread_slab_destroy(thread_master_t *m)
+{
+	thread_slab_chunk_t *chunk, *chunk_tmp;
+
+	list_for_each_entry_safe(chunk, chunk_tmp, &m->slab_chunks, e) {
+		list_head_del(&chunk->e);
+		FREE(chunk);
+	}
+}
+
+/* Size the slabs for the expected number of threads and fd events, so that
+ * a large configuration is laid out contiguously from the start. */
+void
+thread_master_prealloc(thread_master_t *m, unsigned threads, unsigned events)
+{
+	if (threads > m->thread_stats.total) {
+		thread_slab_grow(m, &m->unuse, &m->thread_stats, sizeof(thread_t),
+				 offsetof(thread_t, next), threads - m->thread_stats.total);
+		m->alloc = m->thread_stats.total;
+	}
+
+	if (events > m->event_stats.total)
+		thread_slab_grow(m, &m->event_unuse, &m->event_stats, sizeof(thread_event_t),
+				 offsetof(thread_event_t, next), events - m->event_stats.total);
+}
+
+static void
+thread_event_free(thread_master_t *m, thread_event_t *event)
+{
+	INIT_LIST_HEAD(&event->next);
+	list_add_tail(&event->next, &m->event_unuse);
+	m->event_stats.in_use--;
+}
+
 /* epoll related */
 static int
 thread_events_resize(thread_master_t *m, int delta)
@@ -549,12 +1225,12 @@ thread_event_new(thread_master_t *m, int fd)
 {
 	thread_event_t *event;
 
-	event = (thread_event_t *) MALLOC(sizeof(thread_event_t));
-	if (!event)
-		return NULL;
+	event = thread_slab_get(m, &m->event_unuse, &m->event_stats, sizeof(thread_event_t),
+				offsetof(thread_event_t, next));
+	memset(event, 0, sizeof(*event));
 
 	if (thread_events_resize(m, 1) < 0) {
-		FREE(event);
+		thread_event_free(m, event);
 		return NULL;
 	}
 
@@ -573,6 +1249,174 @@ thread_event_get(thread_master_t *m, int fd)
 	return rb_search(&m->io_events, &event, n, thread_event_cmp);
 }
 
+#ifdef _WITH_IO_URING_
+/* io_uring related. Each fd with a read or write thread waiting has a poll
+ * request in the ring. Arming and removing polls only queues SQEs, which are
+ * submitted by the io_uring_enter() that waits for completions, so changing
+ * the fds waited on doesn't cost a system call each. A one shot poll
+ * completes at once if the fd is already ready, which keeps the level
+ * triggered behaviour the threads rely on with epoll.
+ *
+ * A persistent read registered edge triggered gets a multishot poll instead,
+ * which stays armed across the thread running and being requeued, so a
+ * packet costs no SQE at all. It is only re-armed when a completion says the
+ * kernel has ended it. A multishot poll only reports new wakeups, and several
+ * wakeups can be reported by one completion, so it is no use for a level
+ * triggered reader that may leave data queued. */
+static inline uint64_t
+thread_uring_data(int fd, uint32_t gen)
+{
+	return (uint64_t)gen << 32 | (uint32_t)fd;
+}
+
+static void
+thread_uring_remove(thread_master_t *m, thread_event_t *event)
+{
+	struct io_uring_sqe *sqe;
+
+	if (!event->poll_gen || !uring_owned(m->ring))
+		return;
+
+	/* The removal's own completion has user_data 0, and is ignored */
+	if ((sqe = uring_get_sqe(m->ring))) {
+		sqe->opcode = IORING_OP_POLL_REMOVE;
+		sqe->fd = -1;
+		sqe->addr = thread_uring_data(event->fd, event->poll_gen);
+	}
+	else
+		log_message(LOG_INFO, "scheduler: io_uring queue full removing poll for fd %d", event->fd);
+
+	event->poll_gen = 0;
+	event->poll_mask = 0;
+	event->poll_multi = false;
+}
+
+static int
+thread_uring_arm(thread_master_t *m, thread_event_t *event)
+{
+	struct io_uring_sqe *sqe;
+	unsigned mask = 0;
+	bool multi;
+
+	if (event->read)
+		mask |= POLLIN;
+	if (event->write)
+		mask |= POLLOUT;
+
+	multi = mask == POLLIN && !m->ring_no_multi &&
+		__test_bit(THREAD_FL_READ_PERSIST_BIT, &event->flags) &&
+		__test_bit(THREAD_FL_READ_EDGE_BIT, &event->flags);
+
+	/* A poll in flight for more events will do, since completions with
+	 * no thread waiting are ignored, unless it is a multishot poll and the
+	 * fd is no longer edge triggered */
+	if (!mask ||
+	    (event->poll_gen && (event->poll_mask & mask) == mask && (multi || !event->poll_multi)) ||
+	    !uring_owned(m->ring))
+		return 0;
+
+	thread_uring_remove(m, event);
+
+	if (!(sqe = uring_get_sqe(m->ring))) {
+		log_message(LOG_INFO, "scheduler: io_uring queue full adding poll for fd %d", event->fd);
+		return -1;
+	}
+
+	if (!++m->ring_gen)
+		m->ring_gen = 1;
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = event->fd;
+	sqe->poll_events = (uint16_t)mask;
+	if (multi)
+		sqe->len = IORING_POLL_ADD_MULTI;
+	sqe->user_data = thread_uring_data(event->fd, m->ring_gen);
+
+	event->poll_gen = m->ring_gen;
+	event->poll_mask = mask;
+	event->poll_multi = multi;
+
+	return 0;
+}
+
+/* Move the threads of the fds reported ready to the ready queues */
+static void
+thread_uring_process(thread_master_t *m)
+{
+	struct io_uring_cqe *cqe;
+	thread_event_t *ev;
+	uint32_t gen;
+	int fd, res;
+	bool more, multi;
+
+	while ((cqe = uring_peek_cqe(m->ring))) {
+		fd = (int)(uint32_t)cqe->user_data;
+		gen = (uint32_t)(cqe->user_data >> 32);
+		res = cqe->res;
+		more = cqe->flags & IORING_CQE_F_MORE;
+		uring_cqe_seen(m->ring);
+
+		/* Skip removals, and polls that have been removed or replaced */
+		if (!gen ||
+		    !(ev = thread_event_get(m, fd)) ||
+		    ev->poll_gen != gen)
+			continue;
+
+		/* A multishot poll stays armed unless the kernel has ended it */
+		if (!more) {
+			multi = ev->poll_multi;
+			ev->poll_gen = 0;
+			ev->poll_mask = 0;
+			ev->poll_multi = false;
+
+			/* Multishot polls need Linux 5.13 */
+			if (res == -EINVAL && multi) {
+				if (!m->ring_no_multi)
+					log_message(LOG_INFO, "scheduler: io_uring multishot poll not supported - using one shot polls");
+				m->ring_no_multi = true;
+				thread_uring_arm(m, ev);
+				continue;
+			}
+		}
+
+		if (res < 0) {
+			/* As with epoll, threads on an fd closed under them are
+			 * left to time out */
+			if (res != -EBADF)
+				log_message(LOG_INFO, "scheduler: io_uring poll error for fd %d - %s", fd, strerror(-res));
+			continue;
+		}
+
+		if (res & (POLLHUP | POLLERR | POLLNVAL)) {
+			if (ev->read) {
+				thread_move_ready(m, &m->read, ev->read, THREAD_READ_ERROR);
+				ev->read = NULL;
+			}
+
+			if (ev->write) {
+				thread_move_ready(m, &m->write, ev->write, THREAD_WRITE_ERROR);
+				ev->write = NULL;
+			}
+
+			continue;
+		}
+
+		if ((res & POLLIN) && ev->read) {
+			thread_move_ready(m, &m->read, ev->read, THREAD_READY_FD);
+			ev->read = NULL;
+		}
+
+		if ((res & POLLOUT) && ev->write) {
+			thread_move_ready(m, &m->write, ev->write, THREAD_READY_FD);
+			ev->write = NULL;
+		}
+
+		/* Keep polling for a thread that is still waiting */
+		thread_uring_arm(m, ev);
+	}
+}
+#endif
+
 //添加或者修改thread事件
 static int
 thread_event_set(thread_t *thread)
@@ -582,6 +1426,13 @@ thread_event_set(thread_t *thread)
 	struct epoll_event ev;
 	int op;
 
+#ifdef _WITH_IO_URING_
+	if (m->ring) {
+		__set_bit(THREAD_FL_EPOLL_BIT, &event->flags);
+		return thread_uring_arm(m, event);
+	}
+#endif
+
 	memset(&ev, 0, sizeof(struct epoll_event));
 	ev.data.ptr = event;
 	if (__test_bit(THREAD_FL_READ_BIT, &event->flags))
@@ -590,6 +1441,9 @@ thread_event_set(thread_t *thread)
 	if (__test_bit(THREAD_FL_WRITE_BIT, &event->flags))
 		ev.events |= EPOLLOUT;
 
+	if (__test_bit(THREAD_FL_READ_EDGE_BIT, &event->flags))
+		ev.events |= EPOLLET;
+
 	if (__test_bit(THREAD_FL_EPOLL_BIT, &event->flags))
 		op = EPOLL_CTL_MOD;
 	else
@@ -616,6 +1470,11 @@ thread_event_cancel(thread_t *thread)
 		return -1;
 	}
 
+#ifdef _WITH_IO_URING_
+	if (m->ring)
+		thread_uring_remove(m, event);
+	else
+#endif
 	//知会epoll,不再关心此事件
 	if (m->epoll_fd != -1 &&
 	    epoll_ctl(m->epoll_fd, EPOLL_CTL_DEL, event->fd, NULL) < 0 &&
@@ -627,7 +1486,8 @@ thread_event_cancel(thread_t *thread)
 	rb_erase(&event->n, &m->io_events);
 	if (event == m->current_event)
 		m->current_event = NULL;
-	FREE(thread->event);
+	thread_event_free(m, event);
+	thread->event = NULL;
 	return 0;
 }
 
@@ -641,6 +1501,8 @@ thread_event_del(thread_t *thread, unsigned flag)
 
 	if (flag == THREAD_FL_EPOLL_READ_BIT) {
 		__clear_bit(THREAD_FL_READ_BIT, &event->flags);
+		__clear_bit(THREAD_FL_READ_PERSIST_BIT, &event->flags);
+		__clear_bit(THREAD_FL_READ_EDGE_BIT, &event->flags);
 		if (!__test_bit(THREAD_FL_EPOLL_WRITE_BIT, &event->flags))
 			return thread_event_cancel(thread);
 
@@ -663,10 +1525,11 @@ thread_event_del(thread_t *thread, unsigned flag)
 
 /* Make thread master. */
 //创建thread_master
-thread_master_t *
-thread_make_master(void)
+static thread_master_t *
+thread_make_master_common(bool signals)
 {
 	thread_master_t *new;
+	int i;
 
 	new = (thread_master_t *) MALLOC(sizeof (thread_master_t));
 
@@ -696,8 +1559,15 @@ thread_make_master(void)
 #ifdef USE_SIGNAL_THREADS
 	INIT_LIST_HEAD(&new->signal);
 #endif
-	INIT_LIST_HEAD(&new->ready);
+	for (i = 0; i < THREAD_PRIO_MAX; i++)
+		INIT_LIST_HEAD(&new->ready[i]);
+	new->func_prio = RB_ROOT;
 	INIT_LIST_HEAD(&new->unuse);
+	INIT_LIST_HEAD(&new->event_unuse);
+	INIT_LIST_HEAD(&new->slab_chunks);
+#ifdef _WITH_THREAD_STATS_
+	new->func_stats = RB_ROOT;
+#endif
 
 
 	/* Register timerfd thread */
@@ -723,16 +1593,48 @@ thread_make_master(void)
 		log_message(LOG_INFO, "Unable to set CLOEXEC on timer_fd - %s (%d)", strerror(errno), errno);
 #endif
 
-	new->signal_fd = signal_handler_init();
+#ifdef _WITH_IO_URING_
+	/* epoll is still used if the kernel doesn't support io_uring, or it
+	 * has been disabled */
+	if (!(new->ring = uring_init(THREAD_URING_ENTRIES)))
+		log_message(LOG_INFO, "scheduler: io_uring not available (%m) - using epoll");
+#endif
+
+	new->signal_fd = signals ? signal_handler_init() : -1;
+
+	/* Expired timers only reach the ready queues via the timerfd, so
+	 * it must not wait behind other work; SNMP can wait */
+	thread_set_func_priority(new, thread_timerfd_handler, THREAD_PRIO_CRITICAL);
+#ifdef _WITH_SNMP_
+	thread_set_func_priority(new, snmp_read_thread, THREAD_PRIO_BULK);
+	thread_set_func_priority(new, snmp_timeout_thread, THREAD_PRIO_BULK);
+#endif
 
 	//创建timer_thread,并注册timer_fd的工作为，检查当前时间将过期的event移动到reay链上
 	new->timer_thread = thread_add_read(new, thread_timerfd_handler, NULL, new->timer_fd, TIMER_NEVER);
 
-	add_signal_read_thread(new);
+	if (signals)
+		add_signal_read_thread(new);
 
 	return new;
 }
 
+thread_master_t *
+thread_make_master(void)
+{
+	return thread_make_master_common(true);
+}
+
+#ifdef _WITH_CHECKER_THREADS_
+/* Make a thread master for a worker thread. Signals are only handled by
+ * the process's main thread master. */
+thread_master_t *
+thread_make_worker_master(void)
+{
+	return thread_make_master_common(false);
+}
+#endif
+
 #ifdef THREAD_DUMP
 static char *
 timer_delay(timeval_t sands)
@@ -785,6 +1687,27 @@ thread_list_dump(list_head_t *l, const char *list, FILE *fp)
 	conf_write(fp, "----[ End list_dump ]----");
 }
 
+static void
+timer_wheel_dump(timer_wheel_t *w, const char *wheel, FILE *fp)
+{
+	thread_t *thread;
+	unsigned level, idx;
+	int i = 1;
+
+	conf_write(fp, "----[ Begin wheel_dump %s, %lu timers, tick %" PRIu64 " ]----", wheel, w->count, w->now);
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		for (idx = 0; idx < TIMER_WHEEL_SLOTS; idx++) {
+			list_for_each_entry(thread, &w->slot[level][idx], next)
+				conf_write(fp, "#%.2d level %u slot %u Thread type %s, timer: %s, func %s(), id %ld", i++, level, idx, get_thread_type_str(thread->type), timer_delay(thread->sands), get_function_name(thread->func), thread->id);
+		}
+	}
+	list_for_each_entry(thread, &w->disabled, next)
+		conf_write(fp, "#%.2d disabled Thread type %s, func %s(), id %ld", i++, get_thread_type_str(thread->type), get_function_name(thread->func), thread->id);
+
+	conf_write(fp, "----[ End wheel_dump ]----");
+}
+
 static void
 event_rb_dump(rb_root_t *root, const char *tree, FILE *fp)
 {
@@ -797,45 +1720,40 @@ event_rb_dump(rb_root_t *root, const char *tree, FILE *fp)
 	conf_write(fp, "----[ End rb_dump ]----");
 }
 
+static void
+thread_slab_dump(const thread_slab_stats_t *stats, const char *slab, FILE *fp)
+{
+	conf_write(fp, "----[ %s slab: total %lu, in use %lu, high water %lu, hits %lu, misses %lu ]----",
+		   slab, stats->total, stats->in_use, stats->high_water, stats->hit, stats->miss);
+}
+
 void
 dump_thread_data(thread_master_t *m, FILE *fp)
 {
 	thread_rb_dump(&m->read, "read", fp);
 	thread_rb_dump(&m->write, "write", fp);
 	thread_rb_dump(&m->child, "child", fp);
-	thread_rb_dump(&m->timer, "timer", fp);
+	if (m->timer_wheel)
+		timer_wheel_dump(m->timer_wheel, "timer", fp);
+	else
+		thread_rb_dump(&m->timer, "timer", fp);
 	thread_list_dump(&m->event, "event", fp);
-	thread_list_dump(&m->ready, "ready", fp);
+	thread_list_dump(&m->ready[THREAD_PRIO_CRITICAL], "ready critical", fp);
+	thread_list_dump(&m->ready[THREAD_PRIO_NORMAL], "ready normal", fp);
+	thread_list_dump(&m->ready[THREAD_PRIO_BULK], "ready bulk", fp);
 #ifdef USE_SIGNAL_THREADS
 	thread_list_dump(&m->signal, "signal", fp);
 #endif
 	thread_list_dump(&m->unuse, "unuse", fp);
 	event_rb_dump(&m->io_events, "io_events", fp);
+	thread_slab_dump(&m->thread_stats, "thread", fp);
+	thread_slab_dump(&m->event_stats, "event", fp);
 }
 #endif
 
 /* declare thread_timer_cmp() for rbtree compares */
 RB_TIMER_CMP(thread);
 
-/* Free all unused thread. */
-//释放掉所有unused的线程元素
-static void
-thread_clean_unuse(thread_master_t * m)
-{
-	thread_t *thread, *thread_tmp;
-	list_head_t *l = &m->unuse;
-
-	list_for_each_entry_safe(thread, thread_tmp, l, next) {
-		list_head_del(&thread->next);
-
-		/* free the thread */
-		FREE(thread);
-		m->alloc--;
-	}
-
-	INIT_LIST_HEAD(l);
-}
-
 /* Move thread to unuse list. */
 //将此thread加入到unuse中
 static void
@@ -847,6 +1765,7 @@ thread_add_unuse(thread_master_t *m, thread_t *thread)
 	thread->event = NULL;
 	INIT_LIST_HEAD(&thread->next);
 	list_add_tail(&thread->next, &m->unuse);
+	m->thread_stats.in_use--;
 }
 
 /* Move list element to unuse queue */
@@ -883,24 +1802,230 @@ thread_destroy_rb(thread_master_t *m, rb_root_cached_t *root)
 	}
 }
 
+static void
+thread_destroy_timer_wheel(thread_master_t *m, timer_wheel_t *w)
+{
+	thread_t *thread, *thread_tmp;
+	list_head_t l;
+
+	INIT_LIST_HEAD(&l);
+	timer_wheel_flush(w, &l);
+	list_for_each_entry_safe(thread, thread_tmp, &l, next) {
+		list_head_del(&thread->next);
+		thread_add_unuse(m, thread);
+	}
+}
+
+#ifdef _WITH_THREAD_TRACE_
+static void
+thread_trace_flush(thread_trace_t *trace)
+{
+	const char *p = (const char *)trace->buf;
+	size_t len = trace->count * sizeof(thread_trace_rec_t);
+	ssize_t ret;
+
+	/* A forked child must not write the parent's records */
+	if (trace->pid == getpid()) {
+		while (len) {
+			ret = write(trace->fd, p, len);
+			if (ret < 0) {
+				if (errno == EINTR)
+					continue;
+				break;
+			}
+			p += ret;
+			len -= (size_t)ret;
+		}
+	}
+
+	trace->count = 0;
+}
+
+/* Functions are numbered in the order they are first seen */
+static uint16_t
+thread_trace_func(thread_trace_t *trace, int (*func)(thread_t *))
+{
+	unsigned i;
+
+	if (!func)
+		return 0;
+
+	i = (unsigned)(((uintptr_t)func >> 4) % THREAD_TRACE_FUNCS);
+	while (trace->funcs[i] && trace->funcs[i] != func)
+		i = (i + 1) % THREAD_TRACE_FUNCS;
+
+	if (!trace->funcs[i]) {
+		/* Keep a free slot so the probe above terminates */
+		if (trace->nfuncs >= THREAD_TRACE_FUNCS - 1)
+			return 0;
+		trace->funcs[i] = func;
+		trace->func_num[i] = ++trace->nfuncs;
+	}
+
+	return trace->func_num[i];
+}
+
+static int32_t
+thread_trace_timeout(const timeval_t *sands)
+{
+	timeval_t diff;
+
+	if (sands->tv_sec == TIMER_DISABLED)
+		return -1;
+
+	if (timercmp(sands, &time_now, <=))
+		return 0;
+
+	timersub(sands, &time_now, &diff);
+	return (int32_t)(diff.tv_sec * 1000 + diff.tv_usec / 1000);
+}
+
+static void
+thread_trace_record(thread_master_t *m, enum thread_trace_op op, const thread_t *thread, int32_t arg)
+{
+	thread_trace_t *trace = m->trace;
+	thread_trace_rec_t *rec;
+	timeval_t now, diff;
+	unsigned long delta;
+
+	/* The timerfd thread is internal to the scheduler */
+	if (thread && thread->func == thread_timerfd_handler)
+		return;
+
+	now = timer_now();
+	timersub(&now, &trace->last, &diff);
+	delta = timer_long(diff);
+	trace->last = now;
+
+	rec = &trace->buf[trace->count];
+	rec->delta = delta > UINT32_MAX ? UINT32_MAX : (uint32_t)delta;
+	rec->op = (uint8_t)op;
+	rec->arg = arg;
+	if (thread) {
+		rec->id = (uint32_t)thread->id;
+		rec->func = thread_trace_func(trace, thread->func);
+		rec->type = (uint8_t)thread->type;
+		rec->val = thread->type == THREAD_CHILD ? thread->u.c.pid : thread->u.val;
+	} else {
+		rec->id = 0;
+		rec->func = 0;
+		rec->type = 0;
+		rec->val = 0;
+	}
+
+	if (++trace->count == THREAD_TRACE_BUF)
+		thread_trace_flush(trace);
+}
+
+static inline void
+thread_trace(thread_master_t *m, enum thread_trace_op op, const thread_t *thread, int32_t arg)
+{
+	if (m->trace)
+		thread_trace_record(m, op, thread, arg);
+}
+
+bool
+thread_trace_start(thread_master_t *m, const char *path)
+{
+	thread_trace_hdr_t hdr = { .rec_size = sizeof(thread_trace_rec_t) };
+	thread_trace_t *trace;
+	int fd;
+
+	if (m->trace)
+		thread_trace_stop(m);
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (fd == -1) {
+		log_message(LOG_INFO, "Unable to open thread trace file %s - %m", path);
+		return false;
+	}
+
+	PMALLOC(trace);
+	trace->fd = fd;
+	trace->pid = getpid();
+	trace->last = timer_now();
+
+	memcpy(hdr.magic, THREAD_TRACE_MAGIC, sizeof(hdr.magic));
+	hdr.pid = trace->pid;
+	hdr.start = (int64_t)trace->last.tv_sec * TIMER_HZ + trace->last.tv_usec;
+	if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+		log_message(LOG_INFO, "Unable to write thread trace file %s - %m", path);
+		close(fd);
+		FREE(trace);
+		return false;
+	}
+
+	m->trace = trace;
+
+	return true;
+}
+
+void
+thread_trace_stop(thread_master_t *m)
+{
+	if (!m->trace)
+		return;
+
+	thread_trace_flush(m->trace);
+	close(m->trace->fd);
+	FREE(m->trace);
+	m->trace = NULL;
+}
+
+static void
+thread_trace_launch(thread_master_t *m)
+{
+	char path[PATH_MAX];
+	const char *name = "parent";
+
+#ifndef _DEBUG_
+#ifdef _WITH_VRRP_
+	if (prog_type == PROG_TYPE_VRRP)
+		name = "vrrp";
+#endif
+#ifdef _WITH_LVS_
+	if (prog_type == PROG_TYPE_CHECKER)
+		name = "checker";
+#endif
+#ifdef _WITH_BFD_
+	if (prog_type == PROG_TYPE_BFD)
+		name = "bfd";
+#endif
+#endif
+
+	snprintf(path, sizeof(path), "%s/keepalived_%s_%d.trace", thread_trace_dir, name, getpid());
+	if (thread_trace_start(m, path))
+		log_message(LOG_INFO, "Recording thread trace to %s", path);
+}
+#else
+#define thread_trace(m, op, thread, arg)
+#endif
+
 /* Cleanup master */
 void
 thread_cleanup_master(thread_master_t * m)
 {
+	int i;
+
+	thread_trace(m, THREAD_TRACE_CLEANUP, NULL, 0);
+
 	/* Unuse current thread lists */
 	thread_destroy_rb(m, &m->read);
 	thread_destroy_rb(m, &m->write);
 	thread_destroy_rb(m, &m->timer);
+	if (m->timer_wheel)
+		thread_destroy_timer_wheel(m, m->timer_wheel);
 	thread_destroy_rb(m, &m->child);
 	thread_destroy_list(m, &m->event);
 #ifdef USE_SIGNAL_THREADS
 	thread_destroy_list(m, &m->signal);
 #endif
-	thread_destroy_list(m, &m->ready);
+	for (i = 0; i < THREAD_PRIO_MAX; i++)
+		thread_destroy_list(m, &m->ready[i]);
 	m->child_pid = RB_ROOT;
 
-	/* Clean garbage */
-	thread_clean_unuse(m);
+	/* The unused threads and events are kept for reuse, and the memory is
+	 * only released by thread_destroy_master() */
 
 	FREE(m->epoll_events);
 	m->epoll_size = 0;
@@ -919,6 +2044,18 @@ thread_cleanup_master(thread_master_t * m)
 void
 thread_destroy_master(thread_master_t * m)
 {
+#ifdef _WITH_THREAD_TRACE_
+	thread_trace_stop(m);
+
+#endif
+#ifdef _WITH_IO_URING_
+	/* Nothing needs removing from the ring if it is being destroyed */
+	if (m->ring) {
+		uring_destroy(m->ring);
+		m->ring = NULL;
+	}
+
+#endif
 	if (m->epoll_fd != -1) {
 		close(m->epoll_fd);
 		m->epoll_fd = -1;
@@ -932,6 +2069,17 @@ thread_destroy_master(thread_master_t * m)
 
 	thread_cleanup_master(m);
 
+	thread_slab_destroy(m);
+
+	thread_destroy_func_priorities(m);
+
+#ifdef _WITH_THREAD_STATS_
+	thread_stats_destroy(m);
+#endif
+
+	if (m->timer_wheel)
+		FREE(m->timer_wheel);
+
 	FREE(m);
 }
 
@@ -965,11 +2113,8 @@ thread_new(thread_master_t *m)
 	thread_t *new;
 
 	/* If one thread is already allocated return it */
-	new = thread_trim_head(&m->unuse);
-	if (!new) {
-		new = (thread_t *)MALLOC(sizeof(thread_t));
-		m->alloc++;
-	}
+	new = thread_slab_get(m, &m->unuse, &m->thread_stats, sizeof(thread_t), offsetof(thread_t, next));
+	m->alloc = m->thread_stats.total;
 
 	INIT_LIST_HEAD(&new->next);
 	new->id = thread_get_id(m);
@@ -978,11 +2123,12 @@ thread_new(thread_master_t *m)
 
 /* Add new read thread. */
 //添加读事件（支持读超时)
-thread_t *
-thread_add_read_sands(thread_master_t *m, int (*func) (thread_t *), void *arg, int fd, timeval_t *sands)
+static thread_t *
+thread_add_read_common(thread_master_t *m, int (*func) (thread_t *), void *arg, int fd, timeval_t *sands, bool persist, bool edge)
 {
 	thread_event_t *event;
 	thread_t *thread;
+	bool edge_changed;
 
 	assert(m != NULL);
 
@@ -1014,7 +2160,16 @@ thread_add_read_sands(thread_master_t *m, int (*func) (thread_t *), void *arg, i
 	/* Set & flag event */
 	__set_bit(THREAD_FL_READ_BIT, &event->flags);
 	event->read = thread;
-	if (!__test_bit(THREAD_FL_EPOLL_READ_BIT, &event->flags)) {
+	if (persist)
+		__set_bit(THREAD_FL_READ_PERSIST_BIT, &event->flags);
+	else
+		__clear_bit(THREAD_FL_READ_PERSIST_BIT, &event->flags);
+	edge_changed = edge != __test_bit(THREAD_FL_READ_EDGE_BIT, &event->flags);
+	if (edge)
+		__set_bit(THREAD_FL_READ_EDGE_BIT, &event->flags);
+	else
+		__clear_bit(THREAD_FL_READ_EDGE_BIT, &event->flags);
+	if (!__test_bit(THREAD_FL_EPOLL_READ_BIT, &event->flags) || edge_changed) {
 		if (thread_event_set(thread) < 0) {
 			log_message(LOG_INFO, "scheduler: Cant register read event for fd [%d](%m)", fd);
 			thread_add_unuse(m, thread);
@@ -1022,6 +2177,10 @@ thread_add_read_sands(thread_master_t *m, int (*func) (thread_t *), void *arg, i
 		}
 		__set_bit(THREAD_FL_EPOLL_READ_BIT, &event->flags);
 	}
+#ifdef _WITH_IO_URING_
+	else if (m->ring)
+		thread_uring_arm(m, event);
+#endif
 
 	thread->sands = *sands;
 
@@ -1029,9 +2188,17 @@ thread_add_read_sands(thread_master_t *m, int (*func) (thread_t *), void *arg, i
 	//将此thread添加到m->read链上（添加时，按thread->sands时间自小向大排列）
 	rb_insert_sort_cached(&m->read, thread, n, thread_timer_cmp);
 
+	thread_trace(m, persist ? THREAD_TRACE_READ_PERSIST : THREAD_TRACE_READ, thread, thread_trace_timeout(sands));
+
 	return thread;
 }
 
+thread_t *
+thread_add_read_sands(thread_master_t *m, int (*func) (thread_t *), void *arg, int fd, timeval_t *sands)
+{
+	return thread_add_read_common(m, func, arg, fd, sands, false, false);
+}
+
 //添加超时读事件
 thread_t *
 thread_add_read(thread_master_t *m, int (*func) (thread_t *), void *arg, int fd, unsigned long timer)
@@ -1050,6 +2217,80 @@ thread_add_read(thread_master_t *m, int (*func) (thread_t *), void *arg, int fd,
 	return thread_add_read_sands(m, func, arg, fd, &sands);
 }
 
+/* A persistent read thread is not released after its function has run, but
+ * put straight back on the read queue, with the fd still registered, until it
+ * is cancelled or thread_del_persistent_read() is called. The function can
+ * set thread->sands for the next timeout; otherwise the old timeout is kept,
+ * so a persistent read with a timeout should always update it.
+ *
+ * If edge is set, the fd is registered edge triggered, and the function must
+ * read until EAGAIN. That applies to the whole fd, so an edge triggered fd
+ * must not also be waited on for writing. */
+thread_t *
+thread_add_persistent_read_sands(thread_master_t *m, int (*func) (thread_t *), void *arg, int fd, timeval_t *sands, bool edge)
+{
+	return thread_add_read_common(m, func, arg, fd, sands, true, edge);
+}
+
+thread_t *
+thread_add_persistent_read(thread_master_t *m, int (*func) (thread_t *), void *arg, int fd, unsigned long timer, bool edge)
+{
+	timeval_t sands;
+
+	if (timer == TIMER_NEVER)
+		sands.tv_sec = TIMER_DISABLED;
+	else {
+		set_time_now();
+		sands = timer_add_long(time_now, timer);
+	}
+
+	return thread_add_persistent_read_sands(m, func, arg, fd, &sands, edge);
+}
+
+/* Called from a persistent read thread's function to have the thread released
+ * when the function returns, rather than requeued */
+void
+thread_del_persistent_read(thread_t *thread)
+{
+	thread_event_t *event = thread->event;
+
+	if (!event || !__test_bit(THREAD_FL_READ_PERSIST_BIT, &event->flags))
+		return;
+
+	__clear_bit(THREAD_FL_READ_PERSIST_BIT, &event->flags);
+	if (__test_bit(THREAD_FL_READ_EDGE_BIT, &event->flags)) {
+		__clear_bit(THREAD_FL_READ_EDGE_BIT, &event->flags);
+		thread_event_set(thread);
+	}
+}
+
+/* Put a persistent read thread back on the read queue after it has run.
+ * Returns false if the thread is to be released. */
+static bool
+thread_requeue_persistent(thread_master_t *m, thread_t *thread)
+{
+	thread_event_t *event = thread->event;
+
+	if ((thread->type != THREAD_READY_FD &&
+	     thread->type != THREAD_READ_TIMEOUT &&
+	     thread->type != THREAD_READ_ERROR) ||
+	    !event ||
+	    !__test_bit(THREAD_FL_READ_PERSIST_BIT, &event->flags) ||
+	    !__test_bit(THREAD_FL_EPOLL_READ_BIT, &event->flags) ||
+	    event->read)
+		return false;
+
+	thread->type = THREAD_READ;
+	event->read = thread;
+#ifdef _WITH_IO_URING_
+	if (m->ring)
+		thread_uring_arm(m, event);
+#endif
+	rb_insert_sort_cached(&m->read, thread, n, thread_timer_cmp);
+
+	return true;
+}
+
 int
 thread_del_read(thread_t *thread)
 {
@@ -1096,6 +2337,8 @@ thread_read_requeue(thread_master_t *m, int fd, const timeval_t *new_sands)
 	thread->sands = *new_sands;
 
 	rb_move_cached(&thread->master->read, thread, n, thread_timer_cmp);
+
+	thread_trace(m, THREAD_TRACE_REQUEUE, thread, thread_trace_timeout(new_sands));
 }
 
 void
@@ -1150,6 +2393,10 @@ thread_add_write(thread_master_t *m, int (*func) (thread_t *), void *arg, int fd
 		}
 		__set_bit(THREAD_FL_EPOLL_WRITE_BIT, &event->flags);
 	}
+#ifdef _WITH_IO_URING_
+	else if (m->ring)
+		thread_uring_arm(m, event);
+#endif
 
 	/* Compute write timeout value */
 	if (timer == TIMER_NEVER)
@@ -1162,6 +2409,8 @@ thread_add_write(thread_master_t *m, int (*func) (thread_t *), void *arg, int fd
 	/* Sort the thread. */
 	rb_insert_sort_cached(&m->write, thread, n, thread_timer_cmp);
 
+	thread_trace(m, THREAD_TRACE_WRITE, thread, thread_trace_timeout(&thread->sands));
+
 	return thread;
 }
 
@@ -1212,10 +2461,18 @@ thread_add_timer(thread_master_t *m, int (*func) (thread_t *), void *arg, unsign
 		set_time_now();
 		//设置到期时间
 		thread->sands = timer_add_long(time_now, timer);
+		if (thread_get_slack(m, func))
+			thread_timer_coalesce(m, &thread->sands);
 	}
 
-	/* Sort by timeval. */
-	rb_insert_sort_cached(&m->timer, thread, n, thread_timer_cmp);
+	if (m->timer_wheel)
+		timer_wheel_add(m->timer_wheel, thread);
+	else {
+		/* Sort by timeval. */
+		rb_insert_sort_cached(&m->timer, thread, n, thread_timer_cmp);
+	}
+
+	thread_trace(m, THREAD_TRACE_TIMER, thread, thread_trace_timeout(&thread->sands));
 
 	return thread;
 }
@@ -1232,15 +2489,56 @@ timer_thread_update_timeout(thread_t *thread, unsigned long timer)
 
 	set_time_now();
 	sands = timer_add_long(time_now, timer);
+	if (thread_get_slack(thread->master, thread->func))
+		thread_timer_coalesce(thread->master, &sands);
 
 	if (timercmp(&thread->sands, &sands, ==))
 		return;
 
+	thread_trace(thread->master, THREAD_TRACE_REQUEUE, thread, thread_trace_timeout(&sands));
+
+	if (thread->master->timer_wheel) {
+		timer_wheel_del(thread->master->timer_wheel, thread);
+		thread->sands = sands;
+		timer_wheel_add(thread->master->timer_wheel, thread);
+		return;
+	}
+
 	thread->sands = sands;
 
 	rb_move_cached(&thread->master->timer, thread, n, thread_timer_cmp);
 }
 
+/* Select between the rb tree and the timer wheel for timer threads,
+ * migrating any timers that are already queued. */
+void
+thread_set_timer_wheel(thread_master_t *m, bool enable)
+{
+	thread_t *thread, *thread_tmp;
+	list_head_t l;
+
+	if (enable == !!m->timer_wheel)
+		return;
+
+	if (enable) {
+		m->timer_wheel = timer_wheel_new();
+		rb_for_each_entry_safe_cached(thread, thread_tmp, &m->timer, n) {
+			rb_erase_cached(&thread->n, &m->timer);
+			timer_wheel_add(m->timer_wheel, thread);
+		}
+		return;
+	}
+
+	INIT_LIST_HEAD(&l);
+	timer_wheel_flush(m->timer_wheel, &l);
+	list_for_each_entry_safe(thread, thread_tmp, &l, next) {
+		list_head_del(&thread->next);
+		rb_insert_sort_cached(&m->timer, thread, n, thread_timer_cmp);
+	}
+
+	FREE(m->timer_wheel);
+}
+
 thread_t *
 thread_add_timer_shutdown(thread_master_t *m, int(*func)(thread_t *), void *arg, unsigned long timer)
 {
@@ -1282,6 +2580,8 @@ thread_add_child(thread_master_t * m, int (*func) (thread_t *), void * arg, pid_
 	/* Sort by PID */
 	rb_insert_sort(&m->child_pid, thread, rb_data, thread_child_pid_cmp);
 
+	thread_trace(m, THREAD_TRACE_CHILD, thread, thread_trace_timeout(&thread->sands));
+
 	return thread;
 }
 
@@ -1313,6 +2613,18 @@ thread_add_event(thread_master_t * m, int (*func) (thread_t *), void *arg, int v
 	thread->func = func;
 	thread->arg = arg;
 	thread->u.val = val;
+#ifdef _WITH_THREAD_STATS_
+	thread->ready_time = timer_now();
+#endif
+
+	thread_trace(m, THREAD_TRACE_EVENT, thread, 0);
+
+	/* Bulk events wait behind ready threads rather than preempting them */
+	if (thread_get_priority(m, func) == THREAD_PRIO_BULK) {
+		thread_add_ready(m, thread);
+		return thread;
+	}
+
 	INIT_LIST_HEAD(&thread->next);
 	list_add_tail(&thread->next, &m->event);
 
@@ -1334,9 +2646,14 @@ thread_add_generic_terminate_event(thread_master_t * m, thread_type_t type, int
 	thread->func = func;
 	thread->arg = NULL;
 	thread->u.val = 0;
+#ifdef _WITH_THREAD_STATS_
+	thread->ready_time = timer_now();
+#endif
 	INIT_LIST_HEAD(&thread->next);
 	list_add_tail(&thread->next, &m->event);
 
+	thread_trace(m, THREAD_TRACE_EVENT, thread, 0);
+
 	return thread;
 }
 
@@ -1391,6 +2708,8 @@ thread_cancel(thread_t *thread)
 
 	m = thread->master;
 
+	thread_trace(m, THREAD_TRACE_CANCEL, thread, 0);
+
 	switch (thread->type) {
 	case THREAD_READ:
 		thread_event_del(thread, THREAD_FL_EPOLL_READ_BIT);
@@ -1401,7 +2720,10 @@ thread_cancel(thread_t *thread)
 		rb_erase_cached(&thread->n, &m->write);
 		break;
 	case THREAD_TIMER:
-		rb_erase_cached(&thread->n, &m->timer);
+		if (m->timer_wheel)
+			timer_wheel_del(m->timer_wheel, thread);
+		else
+			rb_erase_cached(&thread->n, &m->timer);
 		break;
 	case THREAD_CHILD:
 		//取消子进程termination事件
@@ -1417,7 +2739,8 @@ thread_cancel(thread_t *thread)
 	case THREAD_WRITE_TIMEOUT:
 		if (thread->event) {
 			rb_erase(&thread->event->n, &m->io_events);
-			FREE(thread->event);
+			thread_event_free(m, thread->event);
+			thread->event = NULL;
 		}
 		/* ... falls through ... */
 	case THREAD_EVENT:
@@ -1572,6 +2895,7 @@ thread_fetch_next_queue(thread_master_t *m)
 	int last_epoll_errno = 0;
 	int ret;
 	int i;
+	list_head_t *ready;
 
 	assert(m != NULL);
 
@@ -1582,12 +2906,13 @@ thread_fetch_next_queue(thread_master_t *m)
 
 	/* If there are ready threads process them */
 	//已有ready事件，不需要等待，直接返回
-	if (m->ready.next != &m->ready)
-		return &m->ready;
+	if ((ready = thread_next_ready_queue(m)))
+		return ready;
 
 	do {
 #ifdef _WITH_SNMP_
-		if (snmp_running)
+		/* Only the process's main thread master drives SNMP */
+		if (snmp_running && m->snmp_timer_thread)
 			snmp_epoll_info(m);
 #endif
 
@@ -1610,11 +2935,29 @@ thread_fetch_next_queue(thread_master_t *m)
 			log_message(LOG_INFO, "calling epoll_wait");
 #endif
 
+#ifdef _WITH_IO_URING_
+		/* Submit the queued polls and wait for one to complete */
+		if (m->ring) {
+			ret = uring_enter(m->ring, 1);
+
+			/* The completion queue is full, so process it */
+			if (ret < 0 && (errno == EBUSY || errno == EAGAIN))
+				ret = 0;
+		}
+		else
+#endif
 		/* Call epoll function. */
 		//死等待epoll事件发生（通过epoll_ctl添加，删除关心的fd)
 		ret = epoll_wait(m->epoll_fd, m->epoll_events, m->epoll_count, -1);
 		sav_errno = errno;
 
+		thread_trace(m, THREAD_TRACE_WAKEUP, NULL, ret);
+
+#ifdef _WITH_THREAD_STATS_
+		/* Stamp fds made ready below with the time they were seen */
+		set_time_now();
+#endif
+
 #ifdef _EPOLL_DEBUG_
 		if (do_epoll_debug) {
 			if (ret == -1)
@@ -1644,6 +2987,13 @@ thread_fetch_next_queue(thread_master_t *m)
 			continue;
 		}
 
+#ifdef _WITH_IO_URING_
+		if (m->ring) {
+			thread_uring_process(m);
+			ret = 0;
+		}
+#endif
+
 		/* Handle epoll events */
 		//遍历收到的所有事件，并按状态将其划分到m->ready链上
 		for (i = 0; i < ret; i++) {
@@ -1676,7 +3026,7 @@ thread_fetch_next_queue(thread_master_t *m)
 			if (ep_ev->events & EPOLLIN) {
 				if (!ev->read) {
 					//收到读事件，但ev并不在read中，告警，并忽略
-					log_message(LOG_INFO, "scheduler: No read thread bound on fd:%d (fl:0x%.4X)"
+					log_message_rl(LOG_INFO, "scheduler: No read thread bound on fd:%d (fl:0x%.4X)"
 						      , ev->fd, ep_ev->events);
 					continue;
 				}
@@ -1689,7 +3039,7 @@ thread_fetch_next_queue(thread_master_t *m)
 			//收到可写事件
 			if (ep_ev->events & EPOLLOUT) {
 				if (!ev->write) {
-					log_message(LOG_INFO, "scheduler: No write thread bound on fd:%d (fl:0x%.4X)"
+					log_message_rl(LOG_INFO, "scheduler: No write thread bound on fd:%d (fl:0x%.4X)"
 						      , ev->fd, ep_ev->events);
 					continue;
 				}
@@ -1712,8 +3062,8 @@ thread_fetch_next_queue(thread_master_t *m)
 
 		/* If there is a ready thread, return it. */
 		//如果ready链上有元素，则返回首个元素
-		if (m->ready.next != &m->ready)
-			return &m->ready;
+		if ((ready = thread_next_ready_queue(m)))
+			return ready;
 	} while (true);
 }
 
@@ -1721,6 +3071,11 @@ thread_fetch_next_queue(thread_master_t *m)
 static inline void
 thread_call(thread_t * thread)
 {
+#ifdef _WITH_THREAD_STATS_
+	int (*func)(thread_t *) = thread->func;
+	timeval_t ready = thread->ready_time;
+	timeval_t start;
+#endif
 
 /* Our infinite scheduling loop */
 #ifdef _EPOLL_DEBUG_
@@ -1728,7 +3083,13 @@ thread_call(thread_t * thread)
 		log_message(LOG_INFO, "Calling thread function %s(), type %s, val/fd/pid %d, status %d id %lu", get_function_name(thread->func), get_thread_type_str(thread->type), thread->u.val, thread->u.c.status, thread->id);
 #endif
 
+#ifdef _WITH_THREAD_STATS_
+	start = timer_now();
+	(*thread->func) (thread);
+	thread_stats_update(thread->master, func, ready, start, timer_now());
+#else
 	(*thread->func) (thread);
+#endif
 }
 
 //keepalived中的术语threads实际上为libevent中的event
@@ -1781,8 +3142,11 @@ process_threads(thread_master_t *m)
 		    thread->type == THREAD_TIMER_SHUTDOWN ||
 		    thread->type == THREAD_TERMINATE) {
 			//触发其事件回调
-			if (thread->func)
+			if (thread->func) {
+				thread_trace(m, THREAD_TRACE_CALL, thread, 0);
 				thread_call(thread);
+				thread_trace(m, THREAD_TRACE_RETURN, thread, 0);
+			}
 
 			if (thread->type == THREAD_TERMINATE_START)
 				shutting_down = true;
@@ -1791,7 +3155,8 @@ process_threads(thread_master_t *m)
 		//event对应资源回收（已执行的event,及不需要执行的event)
 		m->current_event = (thread->type == THREAD_READY_FD) ? thread->event : NULL;
 		thread_type = thread->type;
-		thread_add_unuse(master, thread);
+		if (!thread_requeue_persistent(m, thread))
+			thread_add_unuse(master, thread);
 
 		//检查是否需要退出事件处理循环
 		/* If we are shutting down, and the shutdown timer is not running and
@@ -1806,7 +3171,9 @@ process_threads(thread_master_t *m)
 }
 
 //处理进程终止
-static void
+/* Also called for scripts run by the script spawner, which are not our
+ * children, when it reports their exit */
+void
 process_child_termination(pid_t pid, int status)
 {
 	thread_master_t * m = master;
@@ -1892,8 +3259,17 @@ launch_thread_scheduler(thread_master_t *m)
 	//注册进程退出信号（完成子进程退出处理）
 	signal_set(SIGCHLD, thread_child_handler, m);
 
+#ifdef _WITH_THREAD_TRACE_
+	if (thread_trace_dir)
+		thread_trace_launch(m);
+#endif
+
 	//进行事件处理循环，直要关闭
 	process_threads(m);
+
+#ifdef _WITH_THREAD_TRACE_
+	thread_trace_stop(m);
+#endif
 }
 
 #ifdef THREAD_DUMP
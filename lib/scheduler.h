@@ -26,6 +26,8 @@
 /* system includes */
 #include <sys/types.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <sys/timerfd.h>
 #ifdef _WITH_SNMP_
@@ -36,6 +38,9 @@
 #include "list.h"
 #include "list_head.h"
 #include "rbtree.h"
+#ifdef _WITH_IO_URING_
+#include "io_uring.h"
+#endif
 
 /* Thread types. */
 typedef enum {
@@ -71,11 +76,46 @@ enum thread_flags {
 	THREAD_FL_EPOLL_BIT,
 	THREAD_FL_EPOLL_READ_BIT,
 	THREAD_FL_EPOLL_WRITE_BIT,
+	THREAD_FL_READ_PERSIST_BIT,	/* read thread is requeued after running */
+	THREAD_FL_READ_EDGE_BIT,	/* fd is registered with EPOLLET */
 };
 
 /* epoll def */
 #define THREAD_EPOLL_REALLOC_THRESH	64
 
+/* io_uring def - the submission queue only needs to hold the poll
+ * requests queued between two waits */
+#define THREAD_URING_ENTRIES	256
+
+/* Timer wheel def. With 1ms ticks and 4 levels of 256 slots the wheel
+ * spans about 49 days; anything further out is parked in the last slot
+ * and re-cascaded. */
+#define TIMER_WHEEL_BITS	8
+#define TIMER_WHEEL_SLOTS	(1U << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK	(TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS	4
+#define TIMER_WHEEL_TICK	1000U		/* usecs per tick of the innermost wheel */
+#define TIMER_WHEEL_MAP_LONGS	(TIMER_WHEEL_SLOTS / (CHAR_BIT * sizeof(unsigned long)))
+
+/* Ready queue classes, highest priority first */
+typedef enum {
+	THREAD_PRIO_CRITICAL,
+	THREAD_PRIO_NORMAL,
+	THREAD_PRIO_BULK,
+	THREAD_PRIO_MAX
+} thread_prio_t;
+
+/* How many threads of higher classes may run while a lower class is
+ * waiting before the lower class is given a turn */
+#define THREAD_PRIO_STARVE_LIMIT	16
+
+/* Number of objects allocated at a time when a slab runs dry */
+#define THREAD_SLAB_CHUNK	64
+
+/* Per function statistics. Bucket i of a histogram counts values below
+ * 2^i usecs, the last bucket counts everything larger. */
+#define THREAD_STATS_BUCKETS	24
+
 /* Thread itself. */
 typedef struct _thread {
 	unsigned long id;
@@ -102,30 +142,146 @@ typedef struct _thread {
 	};
 
 	rb_node_t rb_data;		/* PID or fd/vrid */
+#ifdef _WITH_THREAD_STATS_
+	timeval_t ready_time;		/* when the thread became runnable */
+#endif
 } thread_t;
 
+/* Hierarchical timing wheel for timer threads */
+typedef struct _timer_wheel {
+	list_head_t		slot[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+	unsigned long		map[TIMER_WHEEL_LEVELS][TIMER_WHEEL_MAP_LONGS];	/* possibly non-empty slots */
+	list_head_t		disabled;	/* timers set to TIMER_NEVER */
+	uint64_t		now;		/* tick the wheel has been run up to */
+	unsigned long		count;		/* armed timers, excluding disabled */
+	timeval_t		next;		/* cached earliest expiry */
+	bool			next_valid;
+} timer_wheel_t;
+
 /* Thread Event */
 typedef struct _thread_event {
 	thread_t		*read;
 	thread_t		*write;
 	unsigned long		flags;
 	int			fd;
+#ifdef _WITH_IO_URING_
+	uint32_t		poll_gen;	/* of the poll request in flight, 0 if none */
+	unsigned		poll_mask;	/* events of the poll request in flight */
+	bool			poll_multi;	/* the poll request in flight is multishot */
+#endif
 
-	rb_node_t		n;
+	union {
+		rb_node_t	n;
+		list_head_t	next;		/* thread_master.event_unuse */
+	};
 } thread_event_t;
 
+/* Slab statistics for thread_t and thread_event_t */
+typedef struct _thread_slab_stats {
+	unsigned long		total;		/* objects allocated in chunks */
+	unsigned long		in_use;
+	unsigned long		high_water;
+	unsigned long		hit;		/* allocations taken from the free list */
+	unsigned long		miss;		/* allocations that needed a new chunk */
+} thread_slab_stats_t;
+
+#ifdef _WITH_THREAD_STATS_
+/* Run time and queue delay of the threads run for one function */
+typedef struct _thread_func_stats {
+	int (*func)(thread_t *);
+	unsigned long		count;
+	uint64_t		run_total;	/* usecs */
+	unsigned long		run_max;
+	uint64_t		delay_total;	/* usecs from ready to run */
+	unsigned long		delay_max;
+	unsigned long		run_hist[THREAD_STATS_BUCKETS];
+	unsigned long		delay_hist[THREAD_STATS_BUCKETS];
+
+	rb_node_t		n;
+} thread_func_stats_t;
+#endif
+
+/* Scheduler trace file format. The file is a thread_trace_hdr_t followed
+ * by thread_trace_rec_t records, in host byte order. */
+#define THREAD_TRACE_MAGIC	"KATRACE1"
+
+enum thread_trace_op {
+	THREAD_TRACE_READ = 1,		/* fd, arg = timeout ms or -1 */
+	THREAD_TRACE_READ_PERSIST,	/* fd, arg = timeout ms or -1 */
+	THREAD_TRACE_WRITE,		/* fd, arg = timeout ms or -1 */
+	THREAD_TRACE_TIMER,		/* arg = timeout ms or -1 */
+	THREAD_TRACE_CHILD,		/* val = pid, arg = timeout ms or -1 */
+	THREAD_TRACE_EVENT,		/* val = thread val */
+	THREAD_TRACE_CANCEL,
+	THREAD_TRACE_REQUEUE,		/* arg = new timeout ms or -1 */
+	THREAD_TRACE_WAKEUP,		/* arg = fds returned by epoll/io_uring */
+	THREAD_TRACE_CALL,		/* type = thread type when run */
+	THREAD_TRACE_RETURN,		/* records since the CALL were made by it */
+	THREAD_TRACE_CLEANUP,		/* all threads removed, e.g. on reload */
+};
+
+typedef struct _thread_trace_hdr {
+	char			magic[8];
+	uint32_t		rec_size;	/* sizeof(thread_trace_rec_t) */
+	int32_t			pid;
+	int64_t			start;		/* usecs, CLOCK_MONOTONIC */
+} thread_trace_hdr_t;
+
+typedef struct _thread_trace_rec {
+	uint32_t		delta;		/* usecs since the previous record */
+	uint32_t		id;		/* thread id */
+	int32_t			arg;
+	int32_t			val;		/* fd, pid or thread val */
+	uint16_t		func;		/* function number, 0 if none */
+	uint8_t			op;
+	uint8_t			type;
+} thread_trace_rec_t;
+
+#ifdef _WITH_THREAD_TRACE_
+#define THREAD_TRACE_BUF	4096		/* records written at a time */
+#define THREAD_TRACE_FUNCS	1024		/* size of function number hash */
+
+typedef struct _thread_trace {
+	int			fd;
+	pid_t			pid;		/* process the trace belongs to */
+	timeval_t		last;
+	unsigned		count;
+	uint16_t		nfuncs;
+	int (*funcs[THREAD_TRACE_FUNCS])(thread_t *);
+	uint16_t		func_num[THREAD_TRACE_FUNCS];
+	thread_trace_rec_t	buf[THREAD_TRACE_BUF];
+} thread_trace_t;
+#endif
+
 /* Master of the threads. */
 typedef struct _thread_master {
 	rb_root_cached_t	read;//读事件存于此链上
 	rb_root_cached_t	write;//WRITE类型的存在此链上
 	rb_root_cached_t	timer;//用于串连timer
+	timer_wheel_t		*timer_wheel;	/* if set, used instead of the timer rb tree */
 	rb_root_cached_t	child;//用于串连子线程 
 	list_head_t		event;//用于串连自定义的事件
 #ifdef USE_SIGNAL_THREADS
 	list_head_t 		signal;
 #endif
-	list_head_t		ready;//用于挂接write,timer,child,read上可读写的fd或者超时的fd，可以处理回调的
+	list_head_t		ready[THREAD_PRIO_MAX];//用于挂接write,timer,child,read上可读写的fd或者超时的fd，可以处理回调的
+	unsigned		ready_skipped[THREAD_PRIO_MAX];	/* runs of higher classes while waiting */
+	rb_root_t		func_prio;	/* non default thread_prio_t and slack by function */
+	unsigned long		timer_slack;	/* usecs timers can be delayed by to coalesce them */
 	list_head_t		unuse;//空闲的thread_t变量(用于thread复用）
+	list_head_t		event_unuse;	/* free thread_event_t */
+	list_head_t		slab_chunks;	/* memory backing thread_t and thread_event_t */
+	thread_slab_stats_t	thread_stats;
+	thread_slab_stats_t	event_stats;
+#ifdef _WITH_THREAD_STATS_
+	rb_root_t		func_stats;	/* thread_func_stats_t by function */
+	unsigned long		timer_wakeups;	/* timerfd expiries */
+	unsigned long		timer_expired;	/* timer threads run */
+	unsigned long		timer_coalesced; /* timers delayed to expire with others */
+#endif
+#ifdef _WITH_THREAD_TRACE_
+	thread_trace_t		*trace;		/* set while recording a trace */
+#endif
 
 	/* child process related */
 	rb_root_t		child_pid;//用于挂接所有子进程(按pid排序）
@@ -137,6 +293,11 @@ typedef struct _thread_master {
 	unsigned int		epoll_size;
 	unsigned int		epoll_count;//记录收到的epoll事件数目
 	int			epoll_fd;//epoll接口对外的fd
+#ifdef _WITH_IO_URING_
+	uring_t			*ring;		/* used instead of epoll if set */
+	uint32_t		ring_gen;	/* generation of the last poll request */
+	bool			ring_no_multi;	/* the kernel rejected a multishot poll */
+#endif
 
 	/* timer related */
 	//提供timer能力
@@ -195,7 +356,7 @@ typedef enum {
 #define DEFAULT_CHILD_FINDER ((void *)1)
 
 /* global vars exported */
-extern thread_master_t *master;
+extern THREAD_LOCAL thread_master_t *master;
 #ifndef _DEBUG_
 extern prog_type_t prog_type;		/* Parent/VRRP/Checker process */
 #endif
@@ -208,6 +369,9 @@ extern bool do_epoll_debug;
 #ifdef _EPOLL_THREAD_DUMP_
 extern bool do_epoll_thread_dump;
 #endif
+#ifdef _WITH_THREAD_TRACE_
+extern const char *thread_trace_dir;
+#endif
 
 /* Prototypes. */
 extern void set_child_finder_name(char const * (*)(pid_t));
@@ -217,15 +381,29 @@ extern void log_command_line(unsigned);
 extern bool report_child_status(int, pid_t, const char *);
 #endif
 extern thread_master_t *thread_make_master(void);
+#ifdef _WITH_CHECKER_THREADS_
+extern thread_master_t *thread_make_worker_master(void);
+#endif
+extern void thread_master_prealloc(thread_master_t *, unsigned, unsigned);
 extern thread_t *thread_add_terminate_event(thread_master_t *);
 extern thread_t *thread_add_start_terminate_event(thread_master_t *, int (*)(thread_t *));
 #ifdef THREAD_DUMP
 extern void dump_thread_data(thread_master_t *, FILE *);
 #endif
+#ifdef _WITH_THREAD_STATS_
+extern void dump_thread_stats(thread_master_t *, FILE *);
+#endif
+#ifdef _WITH_THREAD_TRACE_
+extern bool thread_trace_start(thread_master_t *, const char *);
+extern void thread_trace_stop(thread_master_t *);
+#endif
 extern void thread_cleanup_master(thread_master_t *);
 extern void thread_destroy_master(thread_master_t *);
 extern thread_t *thread_add_read_sands(thread_master_t *, int (*) (thread_t *), void *, int, timeval_t *);
 extern thread_t *thread_add_read(thread_master_t *, int (*) (thread_t *), void *, int, unsigned long);
+extern thread_t *thread_add_persistent_read_sands(thread_master_t *, int (*) (thread_t *), void *, int, timeval_t *, bool);
+extern thread_t *thread_add_persistent_read(thread_master_t *, int (*) (thread_t *), void *, int, unsigned long, bool);
+extern void thread_del_persistent_read(thread_t *);
 extern int thread_del_read(thread_t *);
 extern void thread_requeue_read(thread_master_t *, int, const timeval_t *);
 extern thread_t *thread_add_write(thread_master_t *, int (*) (thread_t *), void *, int, unsigned long);
@@ -233,6 +411,10 @@ extern int thread_del_write(thread_t *);
 extern void thread_close_fd(thread_t *);
 extern thread_t *thread_add_timer(thread_master_t *, int (*) (thread_t *), void *, unsigned long);
 extern void timer_thread_update_timeout(thread_t *, unsigned long);
+extern void thread_set_timer_wheel(thread_master_t *, bool);
+extern void thread_set_func_priority(thread_master_t *, int (*)(thread_t *), thread_prio_t);
+extern void thread_set_func_slack(thread_master_t *, int (*)(thread_t *));
+extern void thread_set_timer_slack(thread_master_t *, unsigned long);
 extern thread_t *thread_add_timer_shutdown(thread_master_t *, int (*) (thread_t *), void *, unsigned long);
 extern thread_t *thread_add_child(thread_master_t *, int (*) (thread_t *), void *, pid_t, unsigned long);
 extern void thread_children_reschedule(thread_master_t *, int (*) (thread_t *), unsigned long);
@@ -241,10 +423,12 @@ extern void thread_cancel(thread_t *);
 extern void thread_cancel_read(thread_master_t *, int);
 extern int snmp_timeout_thread(thread_t *);
 extern void process_threads(thread_master_t *);
+extern void process_child_termination(pid_t, int);
 extern void thread_child_handler(void *, int);
 extern void thread_add_base_threads(thread_master_t *);
 extern void launch_thread_scheduler(thread_master_t *);
 #ifdef THREAD_DUMP
+extern const char *get_function_name(int (*)(thread_t *));
 extern const char *get_signal_function_name(void (*)(void *, int));
 extern void register_signal_handler_address(const char *, void (*)(void *, int));
 extern void register_thread_address(const char *, int (*)(thread_t *));
@@ -42,7 +42,7 @@
 #include "../keepalived/include/vrrp_json.h"
 #endif
 
-#ifdef _WITH_JSON_
+#if defined _WITH_JSON_ || defined _WITH_ALLOC_PROFILE_
   /* We need to include the realtime signals, but
    * unfortunately SIGRTMIN/SIGRTMAX are not constants.
    * I'm not clear if _NSIG is always defined, so play safe.
@@ -108,6 +108,10 @@ get_signum(const char *sigfunc)
 	else if (!strcmp(sigfunc, "JSON"))
 		return SIGJSON;
 #endif
+#ifdef _WITH_ALLOC_PROFILE_
+	else if (!strcmp(sigfunc, "ALLOC"))
+		return SIGALLOC;
+#endif
 
 	/* Not found */
 	return -1;
@@ -493,6 +497,9 @@ signal_handlers_clear(void *state)
 #ifdef _WITH_JSON_
 	signal_set(SIGJSON, state, NULL);
 #endif
+#ifdef _WITH_ALLOC_PROFILE_
+	signal_set(SIGALLOC, state, NULL);
+#endif
 }
 
 void
@@ -31,6 +31,11 @@
 
 #include "scheduler.h"
 
+#ifdef _WITH_ALLOC_PROFILE_
+/* Start/stop the allocation profiler */
+#define SIGALLOC (SIGRTMIN + 3)
+#endif
+
 static inline int
 sigmask_func(int how, const sigset_t *set, sigset_t *oldset)
 {
@@ -34,7 +34,7 @@
 #endif
 
 /* time_now holds current time */
-timeval_t time_now;
+THREAD_LOCAL timeval_t time_now;
 #ifdef _TIMER_CHECK_
 static timeval_t last_time;
 bool do_timer_check;
@@ -191,3 +191,14 @@ set_time_now(void)
 
 	return time_now;
 }
+
+/* Microseconds since start, which was returned by timer_now() */
+unsigned long
+timer_elapsed(timeval_t start)
+{
+	timeval_t now = timer_now();
+
+	timersub(&now, &start, &now);
+
+	return timer_long(now);
+}
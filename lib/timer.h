@@ -30,8 +30,15 @@
 
 typedef struct timeval timeval_t;
 
+/* State that each checker worker thread needs its own copy of */
+#ifdef _WITH_CHECKER_THREADS_
+#define THREAD_LOCAL	__thread
+#else
+#define THREAD_LOCAL
+#endif
+
 /* Global vars */
-extern timeval_t time_now;
+extern THREAD_LOCAL timeval_t time_now;
 
 #ifdef _TIMER_CHECK_
 bool do_timer_check;
@@ -115,5 +122,6 @@ extern timeval_t set_time_now(void);
 #endif
 extern timeval_t timer_add_long(timeval_t, unsigned long);
 extern timeval_t timer_sub_long(timeval_t, unsigned long);
+extern unsigned long timer_elapsed(timeval_t);
 
 #endif
@@ -560,7 +560,7 @@ inet_sockaddrtos2(struct sockaddr_storage *addr, char *addr_str)
 char *
 inet_sockaddrtos(struct sockaddr_storage *addr)
 {
-	static char addr_str[INET6_ADDRSTRLEN];
+	static THREAD_LOCAL char addr_str[INET6_ADDRSTRLEN];
 	inet_sockaddrtos2(addr, addr_str);
 	return addr_str;
 }
@@ -583,7 +583,7 @@ char *
 inet_sockaddrtopair(struct sockaddr_storage *addr)
 {
 	char addr_str[INET6_ADDRSTRLEN];
-	static char ret[sizeof(addr_str) + 8];	/* '[' + addr_str + ']' + ':' + 'nnnnn' */
+	static THREAD_LOCAL char ret[sizeof(addr_str) + 8];	/* '[' + addr_str + ']' + ':' + 'nnnnn' */
 
 	inet_sockaddrtos2(addr, addr_str);
 	snprintf(ret, sizeof(ret), "[%s]:%d"
@@ -596,7 +596,7 @@ char *
 inet_sockaddrtotrio(struct sockaddr_storage *addr, uint16_t proto)
 {
 	char addr_str[INET6_ADDRSTRLEN];
-	static char ret[sizeof(addr_str) + 13];	/* '[' + addr_str + ']' + ':' + 'sctp' + ':' + 'nnnnn' */
+	static THREAD_LOCAL char ret[sizeof(addr_str) + 13];	/* '[' + addr_str + ']' + ':' + 'sctp' + ':' + 'nnnnn' */
 	char *proto_str = proto == IPPROTO_TCP ? "tcp" : proto == IPPROTO_UDP ? "udp" : proto == IPPROTO_SCTP ? "sctp" : proto == 0 ? "none" : "?";
 
 	inet_sockaddrtos2(addr, addr_str);
@@ -1005,3 +1005,26 @@ memcmp_constant_time(const void *s1, const void *s2, size_t n)
 
 	return ret;
 }
+
+/* FNV-1a style, but a word at a time, for hashing configuration lines
+ * quickly. Not for anything needing collision resistance. */
+uint64_t
+mem_hash(const void *data, size_t len)
+{
+	const char *p = data;
+	uint64_t h = 14695981039346656037ULL;
+	uint64_t w;
+
+	for (; len >= sizeof(w); p += sizeof(w), len -= sizeof(w)) {
+		memcpy(&w, p, sizeof(w));
+		h = (h ^ w) * 1099511628211ULL;
+		h ^= h >> 29;
+	}
+
+	while (len--) {
+		h ^= (unsigned char)*p++;
+		h *= 1099511628211ULL;
+	}
+
+	return h;
+}
@@ -193,5 +193,6 @@ extern int fork_exec(char **);
 extern int open_pipe(int [2]);
 #endif
 extern int memcmp_constant_time(const void *, const void *, size_t);
+extern uint64_t mem_hash(const void *, size_t);
 
 #endif
@@ -0,0 +1,202 @@
+/*
+ * Benchmark of checker worker threads: each worker runs its own thread
+ * master doing TCP connect checks, as TCP_CHECK does, against a local
+ * listener. Reports the check rate for increasing numbers of workers.
+ *
+ * Built by "make check" when keepalived is configured with
+ * --enable-checker-threads.
+ *
+ * Usage: checker_bench [SECONDS [CONCURRENCY [MAX_WORKERS]]]
+ *	(default 2 seconds, 64 checks in flight per worker, nproc workers)
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "scheduler.h"
+#include "timer.h"
+#include "memory.h"
+
+#ifndef _WITH_CHECKER_THREADS_
+#error keepalived must be configured with --enable-checker-threads
+#endif
+
+typedef struct {
+	pthread_t		tid;
+	thread_master_t		*m;
+	unsigned		outstanding;
+	unsigned long		checks;
+	unsigned long		failed;
+} worker_t;
+
+static struct sockaddr_in addr;
+static volatile bool stop;
+static unsigned concurrency = 64;
+
+static double
+now_secs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *
+acceptor(void *arg)
+{
+	int lfd = *(int *)arg;
+	int fd;
+
+	for (;;) {
+		fd = accept4(lfd, NULL, NULL, SOCK_CLOEXEC);
+		if (fd >= 0)
+			close(fd);
+	}
+
+	return NULL;
+}
+
+static int connect_thread(thread_t *);
+
+static void
+start_check(thread_master_t *m, worker_t *w)
+{
+	struct linger lg = { .l_onoff = 1, .l_linger = 0 };
+	int fd;
+
+	/* Reset on close so that the client ports don't sit in TIME_WAIT */
+	fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) && errno != EINPROGRESS) {
+		w->failed++;
+		close(fd);
+		if (!--w->outstanding)
+			thread_add_terminate_event(m);
+		return;
+	}
+
+	thread_add_write(m, connect_thread, w, fd, TIMER_HZ);
+}
+
+static int
+connect_thread(thread_t *thread)
+{
+	worker_t *w = THREAD_ARG(thread);
+	int err = 0;
+	socklen_t len = sizeof(err);
+
+	if (thread->type == THREAD_WRITE_TIMEOUT ||
+	    getsockopt(thread->u.fd, SOL_SOCKET, SO_ERROR, &err, &len) || err)
+		w->failed++;
+	else
+		w->checks++;
+	thread_close_fd(thread);
+
+	if (!stop)
+		start_check(thread->master, w);
+	else if (!--w->outstanding)
+		thread_add_terminate_event(thread->master);
+
+	return 0;
+}
+
+static void *
+worker_thread(void *arg)
+{
+	worker_t *w = arg;
+	unsigned i;
+
+	master = w->m;
+	set_time_now();
+
+	w->outstanding = concurrency;
+	for (i = 0; i < concurrency; i++)
+		start_check(w->m, w);
+
+	process_threads(w->m);
+
+	return NULL;
+}
+
+static void
+run(unsigned n, double secs)
+{
+	worker_t *workers = calloc(n, sizeof(*workers));
+	unsigned long checks = 0, failed = 0;
+	double t0, elapsed;
+	unsigned i;
+
+	stop = false;
+	for (i = 0; i < n; i++)
+		workers[i].m = thread_make_worker_master();
+
+	t0 = now_secs();
+	for (i = 0; i < n; i++)
+		pthread_create(&workers[i].tid, NULL, worker_thread, &workers[i]);
+
+	usleep((useconds_t)(secs * 1e6));
+	stop = true;
+
+	for (i = 0; i < n; i++) {
+		pthread_join(workers[i].tid, NULL);
+		checks += workers[i].checks;
+		failed += workers[i].failed;
+		thread_destroy_master(workers[i].m);
+	}
+	elapsed = now_secs() - t0;
+
+	printf("%2u worker%s: %10.0f checks/sec (%lu checks, %lu failed)\n",
+		n, n == 1 ? " " : "s", checks / elapsed, checks, failed);
+
+	free(workers);
+}
+
+int
+main(int argc, char **argv)
+{
+	socklen_t len = sizeof(addr);
+	unsigned max_workers = (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+	double secs = 2;
+	pthread_t tid;
+	unsigned i;
+	int lfd;
+
+	if (argc > 1)
+		secs = strtod(argv[1], NULL);
+	if (argc > 2)
+		concurrency = (unsigned)strtoul(argv[2], NULL, 10);
+	if (argc > 3)
+		max_workers = (unsigned)strtoul(argv[3], NULL, 10);
+
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	lfd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (lfd < 0 || bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(lfd, 4096) || getsockname(lfd, (struct sockaddr *)&addr, &len)) {
+		perror("listener");
+		return 1;
+	}
+
+	/* Keep the listener from being the bottleneck */
+	for (i = 0; i < max_workers; i++)
+		pthread_create(&tid, NULL, acceptor, &lfd);
+
+	for (i = 1; i <= max_workers; i *= 2) {
+		run(i, secs);
+		if (i < max_workers && i * 2 > max_workers)
+			i = max_workers / 2;
+	}
+
+	return 0;
+}
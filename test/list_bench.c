@@ -0,0 +1,152 @@
+/*
+ * Benchmark of the element-allocating list against the intrusive
+ * list_head_t, using objects the size of a real server.
+ *
+ * Built by "make check".
+ *
+ * Usage: list_bench [NUM_OBJECTS ...]	(default 1000 10000 100000)
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <malloc.h>
+#include <sys/socket.h>
+
+#include "list.h"
+#include "list_head.h"
+#include "memory.h"
+
+/* Roughly the size and layout of a real_server_t */
+typedef struct _obj {
+	struct sockaddr_storage	addr;
+	int			weight;
+	bool			alive;
+	char			pad[96];
+	list_head_t		e_list;
+} obj_t;
+
+/* The parser interleaves other allocations with the objects */
+#define FILLER_SIZE	48
+
+static volatile long sink;
+
+static double
+now_secs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t
+heap_used(void)
+{
+	return mallinfo2().uordblks;
+}
+
+static obj_t *
+new_obj(unsigned i, void **filler)
+{
+	obj_t *o = MALLOC(sizeof(obj_t));
+
+	o->weight = (int)(i % 7) + 1;
+	o->alive = i % 3;
+	*filler = MALLOC(FILLER_SIZE);
+
+	return o;
+}
+
+static void
+run(unsigned n)
+{
+	void **fillers = malloc(n * sizeof(*fillers));
+	unsigned passes = 10000000 / n + 1;
+	size_t base, mem_list, mem_lh;
+	double t0, t_list, t_lh;
+	unsigned i, p;
+	obj_t *o;
+	element e;
+	list l;
+	LH_LIST_HEAD(lh);
+	long sum;
+
+	/* Element-allocating list */
+	base = heap_used();
+	l = alloc_list(NULL, NULL);
+	for (i = 0; i < n; i++)
+		list_add(l, new_obj(i, &fillers[i]));
+	mem_list = heap_used() - base;
+
+	t0 = now_secs();
+	for (p = 0; p < passes; p++) {
+		sum = 0;
+		LIST_FOREACH(l, o, e) {
+			if (o->alive)
+				sum += o->weight;
+		}
+		sink = sum;
+	}
+	t_list = now_secs() - t0;
+
+	LIST_FOREACH(l, o, e)
+		FREE(o);
+	free_list(&l);
+	for (i = 0; i < n; i++)
+		FREE(fillers[i]);
+
+	/* Intrusive list */
+	base = heap_used();
+	for (i = 0; i < n; i++) {
+		o = new_obj(i, &fillers[i]);
+		INIT_LIST_HEAD(&o->e_list);
+		list_add_tail(&o->e_list, &lh);
+	}
+	mem_lh = heap_used() - base;
+
+	t0 = now_secs();
+	for (p = 0; p < passes; p++) {
+		sum = 0;
+		list_for_each_entry(o, &lh, e_list) {
+			if (o->alive)
+				sum += o->weight;
+		}
+		sink = sum;
+	}
+	t_lh = now_secs() - t0;
+
+	while (!list_empty(&lh)) {
+		o = list_first_entry(&lh, obj_t, e_list);
+		list_head_del(&o->e_list);
+		FREE(o);
+	}
+	for (i = 0; i < n; i++)
+		FREE(fillers[i]);
+	free(fillers);
+
+	printf("%7u objects: allocs %7u -> %7u, heap %9zu -> %9zu bytes (%+.1f%%), walk %6.2f -> %6.2f ns/object\n",
+	       n, 2 * n + 1, n, mem_list - n * FILLER_SIZE, mem_lh - n * FILLER_SIZE,
+	       100.0 * ((double)mem_lh - (double)mem_list) / (double)(mem_list - n * FILLER_SIZE),
+	       t_list * 1e9 / ((double)n * passes), t_lh * 1e9 / ((double)n * passes));
+}
+
+int
+main(int argc, char **argv)
+{
+	static const unsigned def_sizes[] = { 1000, 10000, 100000 };
+	int i;
+
+	if (argc <= 1) {
+		for (i = 0; i < (int)(sizeof(def_sizes) / sizeof(def_sizes[0])); i++)
+			run(def_sizes[i]);
+	} else {
+		for (i = 1; i < argc; i++)
+			run((unsigned)strtoul(argv[i], NULL, 10));
+	}
+
+	return 0;
+}
@@ -0,0 +1,202 @@
+/*
+ * Benchmark of the configuration parser. A keyword tree shaped like
+ * keepalived's (a few dozen root keywords, blocks with a hundred or so
+ * keywords, and nested blocks) is installed, and a generated
+ * configuration of the requested number of lines is parsed with it.
+ *
+ * Built and run by "make check", with the minimum rate given by
+ * PARSE_BENCH_MIN_RATE.
+ *
+ * Usage: parse_bench [-l LOOPS] [-r MIN_RATE] [LINES]
+ *	-l	number of times to parse the configuration (default 3)
+ *	-r	fail if fewer than MIN_RATE lines per second are parsed
+ *		(default $PARSE_BENCH_MIN_RATE, or no minimum)
+ *	LINES	approximate size of the configuration (default 200000)
+ *
+ * The exit status is non-zero if the configuration did not parse
+ * cleanly, or parsing was slower than MIN_RATE.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "parser.h"
+#include "memory.h"
+
+#define ROOT_KEYWORDS		40
+#define BLOCK_KEYWORDS		120
+#define NESTED_KEYWORDS		20
+#define LINES_PER_BLOCK		20
+
+static char *root_kw[ROOT_KEYWORDS];
+static char *block_kw[BLOCK_KEYWORDS];
+static char *nested_kw[NESTED_KEYWORDS];
+
+static unsigned long handled;
+static unsigned long expected;
+
+static double
+now_secs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+count_handler(__attribute__((unused)) vector_t *strvec)
+{
+	handled++;
+}
+
+static vector_t *
+bench_init_keywords(void)
+{
+	unsigned i;
+
+	for (i = 0; i < ROOT_KEYWORDS; i++)
+		install_keyword_root(root_kw[i], count_handler, true);
+
+	/* Like vrrp_instance or virtual_server */
+	install_keyword_root("instance", count_handler, true);
+	for (i = 0; i < BLOCK_KEYWORDS; i++)
+		install_keyword(block_kw[i], count_handler);
+
+	/* Like track_script or a real_server */
+	install_keyword("track", count_handler);
+	install_sublevel();
+	for (i = 0; i < NESTED_KEYWORDS; i++)
+		install_keyword(nested_kw[i], count_handler);
+	install_sublevel_end();
+
+	return keywords;
+}
+
+static char *
+kw_name(const char *prefix, unsigned i)
+{
+	char *name = malloc(strlen(prefix) + 12);
+
+	sprintf(name, "%s_%u", prefix, i);
+	return name;
+}
+
+/* Keywords are used from across each table, as in a real configuration */
+static unsigned long
+write_config(FILE *fp, unsigned long lines)
+{
+	unsigned long n = 0;
+	unsigned long blk;
+	unsigned i;
+
+	for (blk = 0; n < lines; blk++) {
+		if (blk % 10 == 0) {
+			fprintf(fp, "! block group %lu\n", blk / 10);
+			fprintf(fp, "%s %lu\n", root_kw[(blk * 7) % ROOT_KEYWORDS], blk);
+			expected++;
+			n += 2;
+		}
+
+		fprintf(fp, "instance I_%lu {\n", blk);
+		expected++;
+		for (i = 0; i < LINES_PER_BLOCK; i++) {
+			fprintf(fp, "    %s %lu	# value\n", block_kw[(blk + i * 13) % BLOCK_KEYWORDS], blk + i);
+			expected++;
+		}
+		fprintf(fp, "    track {\n");
+		expected++;
+		for (i = 0; i < 3; i++) {
+			fprintf(fp, "        %s weight %u\n", nested_kw[(blk + i * 7) % NESTED_KEYWORDS], i);
+			expected++;
+		}
+		fprintf(fp, "    }\n}\n\n");
+		n += LINES_PER_BLOCK + 8;
+	}
+
+	return n;
+}
+
+int
+main(int argc, char **argv)
+{
+	char conf_file[] = "/tmp/parse_bench.XXXXXX";
+	unsigned long lines = 200000;
+	unsigned loops = 3;
+	double min_rate = 0;
+	double t0, best = 0, t;
+	FILE *fp;
+	int fd;
+	int opt;
+	unsigned i;
+	int ret = EXIT_SUCCESS;
+	const char *env;
+
+	if ((env = getenv("PARSE_BENCH_MIN_RATE")))
+		min_rate = strtod(env, NULL);
+
+	while ((opt = getopt(argc, argv, "l:r:")) != -1) {
+		switch (opt) {
+		case 'l':
+			loops = (unsigned)strtoul(optarg, NULL, 10);
+			break;
+		case 'r':
+			min_rate = strtod(optarg, NULL);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-l LOOPS] [-r MIN_RATE] [LINES]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind < argc)
+		lines = strtoul(argv[optind], NULL, 10);
+	if (!loops)
+		loops = 1;
+
+	for (i = 0; i < ROOT_KEYWORDS; i++)
+		root_kw[i] = kw_name("root_keyword", i);
+	for (i = 0; i < BLOCK_KEYWORDS; i++)
+		block_kw[i] = kw_name("block_keyword", i);
+	for (i = 0; i < NESTED_KEYWORDS; i++)
+		nested_kw[i] = kw_name("nested_keyword", i);
+
+	if ((fd = mkstemp(conf_file)) == -1 || !(fp = fdopen(fd, "w"))) {
+		perror("parse_bench: creating configuration");
+		return EXIT_FAILURE;
+	}
+	lines = write_config(fp, lines);
+	fclose(fp);
+
+	for (i = 0; i < loops; i++) {
+		handled = 0;
+		t0 = now_secs();
+		init_data(conf_file, bench_init_keywords);
+		t = now_secs() - t0;
+		if (!best || t < best)
+			best = t;
+
+		if (handled != expected || get_config_status() != CONFIG_OK) {
+			fprintf(stderr, "parse_bench: %lu of %lu keywords handled, config status %d\n",
+				handled, expected, get_config_status());
+			ret = EXIT_FAILURE;
+			break;
+		}
+	}
+
+	unlink(conf_file);
+
+	printf("%lu lines: best of %u parses %.3f s, %.0f lines/s, %.0f ns/line\n",
+	       lines, loops, best, lines / best, best * 1e9 / lines);
+
+	if (min_rate && lines / best < min_rate) {
+		fprintf(stderr, "parse_bench: %.0f lines/s is below the minimum %.0f\n", lines / best, min_rate);
+		ret = EXIT_FAILURE;
+	}
+
+	return ret;
+}
@@ -0,0 +1,349 @@
+#! /bin/bash
+
+# Usage:
+#  scale-bench.sh [options]
+#
+# Generates a keepalived configuration of the requested scale, and measures
+# how long keepalived takes to check it (--config-test), to start in a
+# network namespace of its own (net_namespace) and to reload it on SIGHUP.
+#
+# Results are written as a single JSON object, so that they can be kept and
+# compared between releases. Times are in seconds, and are null if they
+# could not be measured. The startup and reload times reported by keepalived
+# itself are logged by it when run with --log-detail.
+#
+# Must be run as root, since it creates a network namespace. Requires bash 5.
+
+KEEPALIVED=keepalived
+INSTANCES=100
+VIPS=4
+VIRTUAL_SERVERS=0
+REAL_SERVERS=4
+SCRIPTS=0
+TRACK_FILES=0
+PRIORITY=255
+LOOPS=3
+TIMEOUT=60
+GENERATE_ONLY=
+OUTPUT=
+
+show_help()
+{
+	cat <<EOF
+$0 - Usage:
+	-h		Show this!
+	-k		keepalived binary (default keepalived in PATH)
+	-n		number of vrrp instances (default $INSTANCES)
+	-v		number of VIPs per vrrp instance (default $VIPS)
+	-V		number of virtual servers (default $VIRTUAL_SERVERS)
+	-r		number of real servers per virtual server (default $REAL_SERVERS)
+	-s		number of vrrp_scripts, tracked by the instances in turn (default $SCRIPTS)
+	-f		number of track files, tracked by the instances in turn (default $TRACK_FILES)
+	-p		priority of the vrrp instances (default $PRIORITY, starts as master)
+	-l		number of times to run --config-test (default $LOOPS)
+	-w		seconds to wait for startup and reload (default $TIMEOUT)
+	-g		write the configuration to stdout and exit
+	-o		write the results to a file rather than stdout
+EOF
+}
+
+while getopts ":hk:n:v:V:r:s:f:p:l:w:go:" opt; do
+	case $opt in
+	h)
+		show_help
+		exit 0
+		;;
+	k)
+		KEEPALIVED=$OPTARG
+		;;
+	n)
+		INSTANCES=$OPTARG
+		;;
+	v)
+		VIPS=$OPTARG
+		;;
+	V)
+		VIRTUAL_SERVERS=$OPTARG
+		;;
+	r)
+		REAL_SERVERS=$OPTARG
+		;;
+	s)
+		SCRIPTS=$OPTARG
+		;;
+	f)
+		TRACK_FILES=$OPTARG
+		;;
+	p)
+		PRIORITY=$OPTARG
+		;;
+	l)
+		LOOPS=$OPTARG
+		;;
+	w)
+		TIMEOUT=$OPTARG
+		;;
+	g)
+		GENERATE_ONLY=yes
+		;;
+	o)
+		OUTPUT=$OPTARG
+		;;
+	?)
+		echo Unknown option \'$OPTARG\' && show_help && exit 1
+		;;
+	esac
+done
+
+# Each interface can carry 255 VRIDs
+INTERFACES=$(((INSTANCES + 254) / 255))
+
+# Address n (counting from 0) in the /8 starting at net
+addr()
+{
+	echo $1.$(($2 / 65536 % 256)).$(($2 / 256 % 256)).$(($2 % 256))
+}
+
+generate_config()
+{
+	local i j n
+
+	[[ -n $NS_NAME ]] && printf "net_namespace %s\n\n" $NS_NAME
+	cat <<EOF
+global_defs {
+	router_id scale_bench
+	vrrp_garp_master_delay 0
+	vrrp_garp_master_repeat 1
+	enable_script_security
+	script_user root
+}
+EOF
+
+	for ((n = 0; n < SCRIPTS; n++)); do
+		cat <<EOF
+
+vrrp_script chk_$n {
+	script "/bin/true"
+	interval 5
+}
+EOF
+	done
+
+	for ((n = 0; n < TRACK_FILES; n++)); do
+		cat <<EOF
+
+vrrp_track_file track_$n {
+	file "$WORK_DIR/track_$n"
+}
+EOF
+	done
+
+	for ((i = 0; i < INSTANCES; i++)); do
+		cat <<EOF
+
+vrrp_instance VI_$i {
+	state MASTER
+	interface bench$((i / 255))
+	virtual_router_id $((i % 255 + 1))
+	priority $PRIORITY
+	advert_int 1
+	virtual_ipaddress {
+EOF
+		for ((j = 0; j < VIPS; j++)); do
+			echo "		$(addr 10 $((i * VIPS + j)))/32"
+		done
+		echo "	}"
+		[[ $SCRIPTS -gt 0 ]] && printf "\ttrack_script {\n\t\tchk_%d weight 0\n\t}\n" $((i % SCRIPTS))
+		[[ $TRACK_FILES -gt 0 ]] && printf "\ttrack_file {\n\t\ttrack_%d weight 0\n\t}\n" $((i % TRACK_FILES))
+		echo "}"
+	done
+
+	for ((i = 0; i < VIRTUAL_SERVERS; i++)); do
+		cat <<EOF
+
+virtual_server $(addr 172 $i) 80 {
+	delay_loop 10
+	lb_algo rr
+	lb_kind NAT
+	protocol TCP
+EOF
+		for ((j = 0; j < REAL_SERVERS; j++)); do
+			cat <<EOF
+	real_server $(addr 11 $((i * REAL_SERVERS + j))) 8080 {
+		TCP_CHECK {
+			connect_timeout 3
+		}
+	}
+EOF
+		done
+		echo "}"
+	done
+}
+
+if [[ -n $GENERATE_ONLY ]]; then
+	WORK_DIR=/tmp generate_config
+	exit 0
+fi
+
+WORK_DIR=$(mktemp -d /tmp/scale-bench.XXXXXX) || exit 1
+CONF=$WORK_DIR/keepalived.conf
+
+# The namespace is set in the configuration rather than by --namespace,
+# since a namespace given on the command line prevents reloading
+NS_NAME=scale_bench_$$
+
+[[ $(id -u) -ne 0 ]] && echo $0 must be run as root && rmdir $WORK_DIR && exit 1
+
+KA_PID=
+cleanup()
+{
+	[[ -n $KA_PID ]] && kill -TERM $KA_PID 2>/dev/null && wait $KA_PID 2>/dev/null
+	ip netns del $NS_NAME 2>/dev/null
+	rm -rf $WORK_DIR
+}
+trap cleanup EXIT
+
+generate_config >$CONF
+for ((n = 0; n < TRACK_FILES; n++)); do
+	echo 0 >$WORK_DIR/track_$n
+done
+CONF_LINES=$(wc -l <$CONF)
+
+now()
+{
+	echo $EPOCHREALTIME
+}
+
+# Seconds from $1 to $2
+elapsed()
+{
+	[[ -z $1 || -z $2 ]] && echo null && return
+	awk "BEGIN { printf \"%.6f\", $2 - $1 }"
+}
+
+# Convert the microseconds logged by keepalived to seconds
+usecs()
+{
+	[[ -z $1 ]] && echo null && return
+	awk "BEGIN { printf \"%.6f\", $1 / 1000000 }"
+}
+
+# Wait until a log line matching $1 has been seen $2 times (default 1) after
+# line $3 of the log, and print the time it was logged
+wait_for_log()
+{
+	local count=${2:-1} from=${3:-0} end=$((${EPOCHREALTIME%.*} + TIMEOUT))
+
+	while [[ ${EPOCHREALTIME%.*} -lt $end ]]; do
+		line=$(tail -n +$((from + 1)) $LOG | grep -- "$1" | sed -n "${count}p")
+		[[ -n $line ]] && echo ${line%% *} && return 0
+		sleep 0.05
+	done
+
+	return 1
+}
+
+# The value following $2 in the log line matching $1 after line $3
+logged_usecs()
+{
+	tail -n +$((${3:-0} + 1)) $LOG | grep -- "$1" | head -1 | sed -e "s/.*$2 \([0-9]*\) us.*/\1/"
+}
+
+# The interfaces are created in a namespace of their own
+ip netns add $NS_NAME || exit 1
+ip -n $NS_NAME link set lo up
+for ((n = 0; n < INTERFACES; n++)); do
+	ip -n $NS_NAME link add bench$n type veth peer name bench_peer$n
+	ip -n $NS_NAME link set bench$n up
+	ip -n $NS_NAME link set bench_peer$n up
+	ip -n $NS_NAME addr add 192.168.$n.1/24 dev bench$n
+done
+
+# --config-test, best of LOOPS runs
+CONFIG_TEST=
+for ((n = 0; n < LOOPS; n++)); do
+	START=$(now)
+	ip netns exec $NS_NAME $KEEPALIVED --config-test=$WORK_DIR/config-test.log -f $CONF
+	STATUS=$?
+	T=$(elapsed $START $(now))
+	[[ -z $CONFIG_TEST ]] || awk "BEGIN { exit !($T < $CONFIG_TEST) }" && CONFIG_TEST=$T
+done
+if [[ $STATUS -ne 0 ]]; then
+	echo "Configuration test failed with status $STATUS:" >&2
+	head -20 $WORK_DIR/config-test.log >&2
+	exit 1
+fi
+
+# Each line keepalived logs is prefixed with the time it was read
+LOG=$WORK_DIR/keepalived.log
+SUBSYS=
+[[ $VIRTUAL_SERVERS -eq 0 ]] && SUBSYS=--vrrp
+[[ $INSTANCES -eq 0 ]] && SUBSYS=--check
+START=$(now)
+$KEEPALIVED --dont-fork --log-console --log-detail --no-syslog $SUBSYS -f $CONF \
+	-p $WORK_DIR/keepalived.pid -r $WORK_DIR/vrrp.pid -c $WORK_DIR/checkers.pid \
+	2> >(while IFS= read -r line; do echo "$EPOCHREALTIME $line"; done >$LOG) &
+KA_PID=$!
+
+if [[ $INSTANCES -gt 0 ]]; then
+	VRRP_STARTED=$(wait_for_log "VRRP startup took")
+	FIRST_ADVERT=$(wait_for_log "Entering MASTER STATE")
+	[[ $PRIORITY -eq 255 ]] && ALL_MASTER=$(wait_for_log "Entering MASTER STATE" $INSTANCES)
+	VRRP_PARSE=$(logged_usecs "VRRP startup took" parse)
+	VRRP_COMPLETE_INIT=$(logged_usecs "VRRP startup took" vrrp_complete_init)
+	VRRP_STARTUP=$(logged_usecs "VRRP startup took" took)
+fi
+if [[ $VIRTUAL_SERVERS -gt 0 ]]; then
+	CHECKER_STARTED=$(wait_for_log "Checker startup took")
+	CHECKER_PARSE=$(logged_usecs "Checker startup took" parse)
+	CHECKER_STARTUP=$(logged_usecs "Checker startup took" took)
+fi
+
+# Reload the unchanged configuration
+LOG_LINES=$(wc -l <$LOG)
+HUP_SENT=$(now)
+kill -HUP $KA_PID 2>/dev/null
+if [[ $INSTANCES -gt 0 ]]; then
+	VRRP_RELOADED=$(wait_for_log "VRRP reload took" 1 $LOG_LINES)
+	VRRP_RELOAD_PARSE=$(logged_usecs "VRRP reload took" parse $LOG_LINES)
+	VRRP_RELOAD_COMPLETE_INIT=$(logged_usecs "VRRP reload took" vrrp_complete_init $LOG_LINES)
+	VRRP_RELOAD=$(logged_usecs "VRRP reload took" took $LOG_LINES)
+fi
+if [[ $VIRTUAL_SERVERS -gt 0 ]]; then
+	CHECKER_RELOADED=$(wait_for_log "Checker reload took" 1 $LOG_LINES)
+	CHECKER_RELOAD=$(logged_usecs "Checker reload took" took $LOG_LINES)
+fi
+
+kill -TERM $KA_PID 2>/dev/null
+wait $KA_PID
+KA_PID=
+
+[[ -n $OUTPUT ]] && exec >$OUTPUT
+cat <<EOF
+{
+	"keepalived": "$($KEEPALIVED --version 2>&1 | head -1)",
+	"instances": $INSTANCES,
+	"vips_per_instance": $VIPS,
+	"virtual_servers": $VIRTUAL_SERVERS,
+	"real_servers_per_virtual_server": $REAL_SERVERS,
+	"scripts": $SCRIPTS,
+	"track_files": $TRACK_FILES,
+	"config_lines": $CONF_LINES,
+	"config_test": $CONFIG_TEST,
+	"vrrp_parse": $(usecs $VRRP_PARSE),
+	"vrrp_complete_init": $(usecs $VRRP_COMPLETE_INIT),
+	"vrrp_startup": $(usecs $VRRP_STARTUP),
+	"vrrp_started": $(elapsed $START $VRRP_STARTED),
+	"first_advert": $(elapsed $START $FIRST_ADVERT),
+	"all_master": $(elapsed $START $ALL_MASTER),
+	"checker_parse": $(usecs $CHECKER_PARSE),
+	"checker_startup": $(usecs $CHECKER_STARTUP),
+	"checker_started": $(elapsed $START $CHECKER_STARTED),
+	"vrrp_reload_parse": $(usecs $VRRP_RELOAD_PARSE),
+	"vrrp_reload_complete_init": $(usecs $VRRP_RELOAD_COMPLETE_INIT),
+	"vrrp_reload": $(usecs $VRRP_RELOAD),
+	"vrrp_reloaded": $(elapsed $HUP_SENT $VRRP_RELOADED),
+	"checker_reload": $(usecs $CHECKER_RELOAD),
+	"checker_reloaded": $(elapsed $HUP_SENT $CHECKER_RELOADED)
+}
+EOF
@@ -0,0 +1,547 @@
+/*
+ * Replay of a scheduler trace recorded with keepalived --thread-trace,
+ * for comparing scheduler implementations against a real workload.
+ *
+ * The threads of the trace are recreated with synthetic callbacks that
+ * redo the adds, cancels and requeues the original callback made. Each
+ * recorded fd is replaced by an eventfd, which is made readable when the
+ * trace shows the fd became ready, child processes are replaced by timers
+ * expiring when the child was reaped, and all delays are divided by the
+ * replay speed. The scheduler's CPU use per replayed call is reported.
+ *
+ * Built by "make check" when keepalived is configured with
+ * --enable-thread-trace (and --enable-io-uring to replay with the io_uring
+ * backend).
+ *
+ * Usage: sched_replay [-w] [-r] [-s SPEED] [-S SLACK_USECS] [-l LOOPS] TRACE
+ *	-w	use the timer wheel rather than the rb tree
+ *	-r	spin for the recorded run time of each callback
+ *	-s	replay SPEED times faster than recorded (default 1)
+ *	-S	timer slack for the replayed timers (default 0)
+ *	-l	number of times to replay the trace (default 1)
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+
+#include "scheduler.h"
+#include "timer.h"
+#include "memory.h"
+
+#define NONE	((size_t)-1)
+
+/* A thread of the trace */
+typedef struct {
+	thread_t	*thread;	/* replaying it */
+	thread_t	*inject;	/* timer making its fd ready */
+	size_t		first_call;	/* its first CALL record */
+	size_t		next_call;	/* its next CALL record to replay */
+	int		fd;		/* eventfd standing in for the recorded fd */
+	bool		persist;
+	bool		pre_existing;	/* added before the trace started */
+} rthread_t;
+
+static thread_trace_rec_t *recs;
+static size_t nrecs;
+static uint64_t *when;		/* usecs from the start of the trace */
+static size_t *next_call;	/* next CALL record of the same thread */
+static rthread_t *rthreads;
+static uint32_t max_id;
+static int *efds;		/* eventfds by recorded fd */
+static int max_fd;
+static int *open_fds;		/* all the eventfds created */
+static size_t nopen_fds;
+static size_t open_fds_size;
+
+static double speed = 1;
+static bool spin;
+static size_t calls_total;
+static size_t calls_done;
+static bool timed_out;
+
+static double
+now_secs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+cpu_secs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long
+scaled(uint64_t usecs)
+{
+	return (unsigned long)(usecs / speed);
+}
+
+static unsigned long
+scaled_timeout(int32_t msecs)
+{
+	return msecs < 0 ? TIMER_NEVER : scaled((uint64_t)msecs * 1000);
+}
+
+static bool
+load_trace(const char *path)
+{
+	thread_trace_hdr_t hdr;
+	struct stat st;
+	FILE *fp;
+
+	if (!(fp = fopen(path, "r")) || fstat(fileno(fp), &st)) {
+		fprintf(stderr, "Unable to open %s - %m\n", path);
+		return false;
+	}
+
+	if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	    memcmp(hdr.magic, THREAD_TRACE_MAGIC, sizeof(hdr.magic)) ||
+	    hdr.rec_size != sizeof(thread_trace_rec_t)) {
+		fprintf(stderr, "%s is not a thread trace\n", path);
+		fclose(fp);
+		return false;
+	}
+
+	nrecs = ((size_t)st.st_size - sizeof(hdr)) / sizeof(thread_trace_rec_t);
+	recs = malloc(nrecs * sizeof(*recs) + 1);
+	nrecs = fread(recs, sizeof(*recs), nrecs, fp);
+	fclose(fp);
+
+	printf("%s: pid %d, %zu records\n", path, hdr.pid, nrecs);
+
+	return true;
+}
+
+static bool
+is_add(uint8_t op)
+{
+	return op >= THREAD_TRACE_READ && op <= THREAD_TRACE_EVENT;
+}
+
+/* Link the calls of each thread, and find the threads which existed
+ * before the trace started */
+static void
+prepare(void)
+{
+	uint64_t t = 0;
+	size_t *last_call;
+	bool *added;
+	size_t i;
+
+	when = malloc(nrecs * sizeof(*when) + 1);
+	next_call = malloc(nrecs * sizeof(*next_call) + 1);
+
+	for (i = 0; i < nrecs; i++) {
+		t += recs[i].delta;
+		when[i] = t;
+		if (recs[i].id > max_id)
+			max_id = recs[i].id;
+		if ((recs[i].op == THREAD_TRACE_READ || recs[i].op == THREAD_TRACE_READ_PERSIST ||
+		     recs[i].op == THREAD_TRACE_WRITE ||
+		     (recs[i].op == THREAD_TRACE_CALL && recs[i].type == THREAD_READY_FD)) &&
+		    recs[i].val > max_fd)
+			max_fd = recs[i].val;
+	}
+
+	rthreads = calloc(max_id + 1, sizeof(*rthreads));
+	last_call = malloc((max_id + 1) * sizeof(*last_call));
+	added = calloc(max_id + 1, sizeof(*added));
+	efds = malloc(((size_t)max_fd + 1) * sizeof(*efds));
+	for (i = 0; i <= max_id; i++)
+		rthreads[i].first_call = last_call[i] = NONE;
+	for (i = 0; i <= (size_t)max_fd; i++)
+		efds[i] = -1;
+
+	for (i = 0; i < nrecs; i++) {
+		if (is_add(recs[i].op))
+			added[recs[i].id] = true;
+		if (recs[i].op != THREAD_TRACE_CALL)
+			continue;
+
+		next_call[i] = NONE;
+		if (last_call[recs[i].id] == NONE) {
+			rthreads[recs[i].id].first_call = i;
+			rthreads[recs[i].id].pre_existing = !added[recs[i].id];
+		} else
+			next_call[last_call[recs[i].id]] = i;
+		last_call[recs[i].id] = i;
+		calls_total++;
+	}
+
+	free(last_call);
+	free(added);
+}
+
+/* If the replay has fallen out of step with the trace, an fd number may
+ * be reused while the thread using it before is still waiting, and so
+ * the recorded fd is then given a new eventfd */
+static int
+replay_fd(int fd, bool new)
+{
+	if (fd < 0 || fd > max_fd)
+		return -1;
+
+	if (efds[fd] == -1 || new) {
+		efds[fd] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (nopen_fds == open_fds_size) {
+			open_fds_size = open_fds_size ? open_fds_size * 2 : 64;
+			open_fds = realloc(open_fds, open_fds_size * sizeof(*open_fds));
+		}
+		open_fds[nopen_fds++] = efds[fd];
+	}
+
+	return efds[fd];
+}
+
+static int
+inject_thread(thread_t *thread)
+{
+	rthread_t *rt = THREAD_ARG(thread);
+	uint64_t one = 1;
+
+	rt->inject = NULL;
+	if (write(rt->fd, &one, sizeof(one)) != sizeof(one))
+		fprintf(stderr, "eventfd write failed - %m\n");
+
+	return 0;
+}
+
+/* Make the fd of rt ready when the trace shows its next call did */
+static void
+arm_inject(rthread_t *rt, uint64_t from)
+{
+	if (rt->next_call == NONE || recs[rt->next_call].type != THREAD_READY_FD || rt->fd == -1)
+		return;
+
+	rt->inject = thread_add_timer(master, inject_thread, rt, scaled(when[rt->next_call] - from));
+}
+
+static void
+cancel_inject(rthread_t *rt)
+{
+	uint64_t val;
+
+	if (rt->inject) {
+		thread_cancel(rt->inject);
+		rt->inject = NULL;
+	}
+
+	if (rt->fd != -1 && read(rt->fd, &val, sizeof(val)) == -1 && errno != EAGAIN)
+		fprintf(stderr, "eventfd read failed - %m\n");
+}
+
+static int
+deadline_thread(thread_t *thread)
+{
+	timed_out = true;
+	thread_add_terminate_event(thread->master);
+
+	return 0;
+}
+
+static void
+add_deadline(void)
+{
+	thread_add_timer(master, deadline_thread, NULL, scaled(when[nrecs - 1]) + 2 * TIMER_HZ);
+}
+
+static int replay_thread(thread_t *);
+
+static thread_t *
+replay_read(rthread_t *rt, unsigned long timeout)
+{
+	if (rt->persist)
+		return thread_add_persistent_read(master, replay_thread, rt, rt->fd, timeout, false);
+
+	return thread_add_read(master, replay_thread, rt, rt->fd, timeout);
+}
+
+static void
+replay_add_read(rthread_t *rt, int fd, unsigned long timeout, uint64_t from)
+{
+	rt->fd = replay_fd(fd, false);
+	if (!(rt->thread = replay_read(rt, timeout)) && rt->fd != -1) {
+		rt->fd = replay_fd(fd, true);
+		rt->thread = replay_read(rt, timeout);
+	}
+
+	if (rt->thread)
+		arm_inject(rt, from);
+}
+
+static void
+replay_record(size_t i)
+{
+	thread_trace_rec_t *rec = &recs[i];
+	rthread_t *rt = &rthreads[rec->id];
+	unsigned long timeout = scaled_timeout(rec->arg);
+	timeval_t sands;
+	uint32_t id;
+
+	switch (rec->op) {
+	case THREAD_TRACE_READ:
+	case THREAD_TRACE_READ_PERSIST:
+		rt->next_call = rt->first_call;
+		rt->persist = rec->op == THREAD_TRACE_READ_PERSIST;
+		replay_add_read(rt, rec->val, timeout, when[i]);
+		break;
+	case THREAD_TRACE_WRITE:
+		/* An eventfd is always writable, so this runs straight away */
+		rt->next_call = rt->first_call;
+		rt->fd = replay_fd(rec->val, false);
+		rt->thread = thread_add_write(master, replay_thread, rt, rt->fd, timeout);
+		break;
+	case THREAD_TRACE_TIMER:
+		rt->next_call = rt->first_call;
+		rt->thread = thread_add_timer(master, replay_thread, rt, timeout);
+		break;
+	case THREAD_TRACE_CHILD:
+		/* Expire when the child was reaped */
+		rt->next_call = rt->first_call;
+		if (rt->next_call != NONE)
+			timeout = scaled(when[rt->next_call] - when[i]);
+		rt->thread = thread_add_timer(master, replay_thread, rt, timeout);
+		break;
+	case THREAD_TRACE_EVENT:
+		rt->next_call = rt->first_call;
+		rt->thread = thread_add_event(master, replay_thread, rt, rec->val);
+		break;
+	case THREAD_TRACE_CANCEL:
+		cancel_inject(rt);
+		if (rt->thread && rt->thread->type != THREAD_UNUSED)
+			thread_cancel(rt->thread);
+		rt->thread = NULL;
+		break;
+	case THREAD_TRACE_CLEANUP:
+		/* The original code re-adds the threads it wants */
+		thread_cleanup_master(master);
+		thread_add_base_threads(master);
+		for (id = 0; id <= max_id; id++)
+			rthreads[id].thread = rthreads[id].inject = NULL;
+		add_deadline();
+		break;
+	case THREAD_TRACE_REQUEUE:
+		if (!rt->thread)
+			break;
+		if (rt->thread->type == THREAD_TIMER)
+			timer_thread_update_timeout(rt->thread, timeout);
+		else if (rt->thread->type == THREAD_READ) {
+			set_time_now();
+			if (timeout == TIMER_NEVER)
+				sands.tv_sec = TIMER_DISABLED;
+			else
+				sands = timer_add_long(time_now, timeout);
+			thread_requeue_read(master, rt->fd, &sands);
+		}
+		break;
+	}
+}
+
+/* Create the threads that were added before the trace started */
+static void
+replay_pre_existing(void)
+{
+	rthread_t *rt;
+	size_t i;
+
+	for (i = 0; i <= max_id; i++) {
+		rt = &rthreads[i];
+		if (!rt->pre_existing)
+			continue;
+
+		rt->next_call = rt->first_call;
+		switch (recs[rt->first_call].type) {
+		case THREAD_READY_FD:
+		case THREAD_READ_TIMEOUT:
+			rt->persist = next_call[rt->first_call] != NONE;
+			replay_add_read(rt, recs[rt->first_call].val, TIMER_NEVER, 0);
+			break;
+		case THREAD_EVENT:
+			rt->thread = thread_add_event(master, replay_thread, rt, recs[rt->first_call].val);
+			break;
+		default:
+			rt->thread = thread_add_timer(master, replay_thread, rt, scaled(when[rt->first_call]));
+			break;
+		}
+	}
+}
+
+static void
+spin_for(uint64_t usecs)
+{
+	double end = now_secs() + usecs / 1e6;
+
+	while (now_secs() < end)
+		;
+}
+
+static int
+replay_thread(thread_t *thread)
+{
+	rthread_t *rt = THREAD_ARG(thread);
+	size_t call = rt->next_call;
+	size_t i;
+
+	if (thread->type == THREAD_READY_FD || thread->type == THREAD_READ_TIMEOUT)
+		cancel_inject(rt);
+	if (!rt->persist)
+		rt->thread = NULL;
+
+	/* Not called this often in the trace */
+	if (call == NONE) {
+		if (rt->persist)
+			thread_del_persistent_read(thread);
+		return 0;
+	}
+
+	/* Redo what the original callback did */
+	rt->next_call = next_call[call];
+	for (i = call + 1; i < nrecs; i++) {
+		if (recs[i].op == THREAD_TRACE_RETURN && recs[i].id == recs[call].id)
+			break;
+		replay_record(i);
+	}
+	if (spin && i < nrecs)
+		spin_for(when[i] - when[call]);
+
+	if (rt->persist) {
+		if (rt->next_call == NONE)
+			thread_del_persistent_read(thread);
+		else {
+			/* The original callback set the time of its next timeout */
+			set_time_now();
+			if (recs[rt->next_call].type == THREAD_READ_TIMEOUT)
+				thread->sands = timer_add_long(time_now, scaled(when[rt->next_call] - when[call]));
+			else {
+				thread->sands.tv_sec = TIMER_DISABLED;
+				arm_inject(rt, when[call]);
+			}
+		}
+	}
+
+	if (++calls_done == calls_total)
+		thread_add_terminate_event(thread->master);
+
+	return 0;
+}
+
+static void
+run(bool wheel, unsigned long slack)
+{
+	double t0, c0, wall, cpu;
+	size_t i;
+
+	calls_done = 0;
+	timed_out = false;
+	for (i = 0; i <= max_id; i++) {
+		rthreads[i].thread = rthreads[i].inject = NULL;
+		rthreads[i].fd = -1;
+		rthreads[i].persist = false;
+	}
+
+	master = thread_make_master();
+	thread_set_timer_wheel(master, wheel);
+	if (slack) {
+		thread_set_timer_slack(master, slack);
+		thread_set_func_slack(master, replay_thread);
+	}
+
+	t0 = now_secs();
+	c0 = cpu_secs();
+
+	/* Redo the adds made before the first call */
+	replay_pre_existing();
+	for (i = 0; i < nrecs && recs[i].op != THREAD_TRACE_CALL; i++)
+		replay_record(i);
+	add_deadline();
+
+	launch_thread_scheduler(master);
+
+	wall = now_secs() - t0;
+	cpu = cpu_secs() - c0;
+
+	printf("%-6s %-8s replayed %zu/%zu calls%s in %.3f s (recorded %.3f s): %.0f ns cpu/call, slab threads %lu (hit %lu miss %lu)\n",
+		wheel ? "wheel" : "rbtree",
+#ifdef _WITH_IO_URING_
+		master->ring ? "io_uring" :
+#endif
+				   "epoll",
+		calls_done, calls_total, timed_out ? " (timed out)" : "",
+		wall, when[nrecs - 1] / 1e6, calls_done ? cpu * 1e9 / calls_done : 0,
+		master->thread_stats.total, master->thread_stats.hit, master->thread_stats.miss);
+
+	thread_destroy_master(master);
+	master = NULL;
+
+	for (i = 0; i < nopen_fds; i++)
+		close(open_fds[i]);
+	nopen_fds = 0;
+	for (i = 0; i <= (size_t)max_fd; i++)
+		efds[i] = -1;
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned long slack = 0;
+	unsigned loops = 1;
+	bool wheel = false;
+	unsigned i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "wrs:S:l:")) != -1) {
+		switch (opt) {
+		case 'w':
+			wheel = true;
+			break;
+		case 'r':
+			spin = true;
+			break;
+		case 's':
+			speed = strtod(optarg, NULL);
+			break;
+		case 'S':
+			slack = strtoul(optarg, NULL, 10);
+			break;
+		case 'l':
+			loops = (unsigned)strtoul(optarg, NULL, 10);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-w] [-r] [-s SPEED] [-S SLACK_USECS] [-l LOOPS] TRACE\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind >= argc || speed <= 0) {
+		fprintf(stderr, "Usage: %s [-w] [-r] [-s SPEED] [-S SLACK_USECS] [-l LOOPS] TRACE\n", argv[0]);
+		return 1;
+	}
+
+	if (!load_trace(argv[optind]))
+		return 1;
+	if (!nrecs)
+		return 0;
+
+	prepare();
+
+	for (i = 0; i < loops; i++)
+		run(wheel, slack);
+
+	return 0;
+}
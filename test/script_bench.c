@@ -0,0 +1,134 @@
+/*
+ * Benchmark of starting scripts with fork() and with the
+ * clone(CLONE_VM | CLONE_VFORK) path used when script_vfork is set, from
+ * a process with a large RSS, as the VRRP and checker processes have with
+ * big configurations.
+ *
+ * Built by "make check".
+ *
+ * Usage: script_bench [-m RSS_MB] [-n SCRIPTS] [SCRIPT]
+ *	-m	memory to allocate and touch first (default 200)
+ *	-n	number of scripts to run with each method (default 1000)
+ *	SCRIPT	the script to run (default /bin/true)
+ *
+ * For each method, the time notify_exec() takes to return, which is the
+ * time the daemon is blocked, and the time until the script has exited,
+ * are reported.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "notify.h"
+#include "logger.h"
+#include "memory.h"
+
+/* Keeps the compiler from dropping the allocation */
+char *ballast;
+
+static double
+now_secs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long
+rss_kb(void)
+{
+	char buf[256];
+	long rss = -1;
+	FILE *fp;
+
+	if (!(fp = fopen("/proc/self/status", "r")))
+		return -1;
+	while (fgets(buf, sizeof(buf), fp))
+		if (!strncmp(buf, "VmRSS:", 6))
+			rss = strtol(buf + 6, NULL, 10);
+	fclose(fp);
+
+	return rss;
+}
+
+static void
+run(notify_script_t *script, unsigned n, bool vfork)
+{
+	double t0, t, t_call = 0, t_total;
+	unsigned i;
+	int status;
+
+	set_script_vfork(vfork);
+
+	t0 = now_secs();
+	for (i = 0; i < n; i++) {
+		t = now_secs();
+		if (notify_exec(script)) {
+			fprintf(stderr, "notify_exec failed\n");
+			exit(1);
+		}
+		t_call += now_secs() - t;
+
+		if (wait(&status) == -1) {
+			perror("wait");
+			exit(1);
+		}
+	}
+	t_total = now_secs() - t0;
+
+	printf("%-5s %6u scripts: notify_exec %8.1f us, until exit %8.1f us per script\n",
+		vfork ? "vfork" : "fork", n, t_call * 1e6 / n, t_total * 1e6 / n);
+}
+
+int
+main(int argc, char **argv)
+{
+	char *args[] = { "/bin/true", NULL };
+	notify_script_t script = {
+		.args = args,
+		.num_args = 1,
+		.flags = SC_EXECABLE,
+	};
+	unsigned long mb = 200;
+	unsigned n = 1000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:n:")) != -1) {
+		switch (opt) {
+		case 'm':
+			mb = strtoul(optarg, NULL, 10);
+			break;
+		case 'n':
+			n = (unsigned)strtoul(optarg, NULL, 10);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-m RSS_MB] [-n SCRIPTS] [SCRIPT]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (optind < argc)
+		args[0] = argv[optind];
+
+	if (mb) {
+		if (!(ballast = malloc(mb << 20))) {
+			perror("malloc");
+			return 1;
+		}
+		memset(ballast, 1, mb << 20);
+	}
+
+	enable_console_log();
+
+	printf("RSS %ld kB\n", rss_kb());
+	run(&script, n, false);
+	run(&script, n, true);
+
+	return 0;
+}
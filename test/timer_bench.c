@@ -0,0 +1,132 @@
+/*
+ * Benchmark of the scheduler timer queue, comparing the rb tree with the
+ * timer wheel.
+ *
+ * Built by "make check".
+ *
+ * Usage: timer_bench [NUM_TIMERS ...]	(default 1000 10000 100000)
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "scheduler.h"
+#include "timer.h"
+#include "memory.h"
+
+static unsigned long fired;
+static unsigned long early;
+static unsigned long expected;
+
+static double
+now_secs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+cpu_secs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int
+dummy_thread(__attribute__((unused)) thread_t *thread)
+{
+	return 0;
+}
+
+static int
+expire_thread(thread_t *thread)
+{
+	set_time_now();
+	if (timercmp(&time_now, &thread->sands, <))
+		early++;
+
+	if (++fired == expected)
+		thread_add_terminate_event(thread->master);
+
+	return 0;
+}
+
+static void
+run(unsigned n, bool wheel)
+{
+	thread_t **threads = malloc(n * sizeof(*threads));
+	double t0, t_add, t_upd, t_cancel, t_expire;
+	unsigned i;
+
+	master = thread_make_master();
+	thread_set_timer_wheel(master, wheel);
+
+	/* Arm n timers spread over a 60s delay_loop */
+	t0 = now_secs();
+	for (i = 0; i < n; i++)
+		threads[i] = thread_add_timer(master, dummy_thread, NULL, (unsigned long)random() % (60 * TIMER_HZ));
+	t_add = now_secs() - t0;
+
+	/* Re-arm each of them, as checkers do every delay_loop */
+	t0 = now_secs();
+	for (i = 0; i < n; i++)
+		timer_thread_update_timeout(threads[i], (unsigned long)random() % (60 * TIMER_HZ));
+	t_upd = now_secs() - t0;
+
+	t0 = now_secs();
+	for (i = 0; i < n; i++)
+		thread_cancel(threads[i]);
+	t_cancel = now_secs() - t0;
+
+	/* Now let n timers expire over 200ms and measure the CPU used by the
+	 * scheduler loop */
+	fired = early = 0;
+	expected = n;
+	for (i = 0; i < n; i++)
+		thread_add_timer(master, expire_thread, NULL, (unsigned long)random() % (TIMER_HZ / 5));
+	t0 = cpu_secs();
+	launch_thread_scheduler(master);
+	t_expire = cpu_secs() - t0;
+
+	printf("%-6s %7u timers: add %8.1f ns, update %8.1f ns, cancel %8.1f ns, expiry %8.1f ns cpu/timer (fired %lu, early %lu)\n",
+		wheel ? "wheel" : "rbtree", n,
+		t_add * 1e9 / n, t_upd * 1e9 / n, t_cancel * 1e9 / n,
+		t_expire * 1e9 / n, fired, early);
+
+	thread_destroy_master(master);
+	master = NULL;
+	free(threads);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned sizes[] = { 1000, 10000, 100000 };
+	unsigned n;
+	int i;
+
+	srandom(1);
+
+	if (argc > 1) {
+		for (i = 1; i < argc; i++) {
+			n = (unsigned)strtoul(argv[i], NULL, 10);
+			run(n, false);
+			run(n, true);
+		}
+		return 0;
+	}
+
+	for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+		run(sizes[i], false);
+		run(sizes[i], true);
+	}
+
+	return 0;
+}